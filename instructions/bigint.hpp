@@ -0,0 +1,192 @@
+#pragma once
+
+#include "../mizu/opcode.hpp"
+#include "bits.hpp"
+
+#include <algorithm>
+
+namespace mizu {
+	namespace detail {
+		/**
+		 * Adds two numbers and a carry
+		 * @param carry the carry into the addition (zero or one), replaced with the carry out of it
+		 */
+		inline uint64_t add_with_carry(uint64_t a, uint64_t b, uint64_t& carry) {
+			uint64_t sum = a + b;
+			uint64_t carry_out = sum < a;
+			sum += carry;
+			carry = carry_out + (sum < carry);
+			return sum;
+		}
+
+		/**
+		 * Subtracts a number and a borrow from another number
+		 * @param borrow the borrow into the subtraction (zero or one), replaced with the borrow out of it
+		 */
+		inline uint64_t subtract_with_borrow(uint64_t a, uint64_t b, uint64_t& borrow) {
+			uint64_t difference = a - b;
+			uint64_t borrow_out = a < b;
+			borrow_out += difference < borrow;
+			difference -= borrow;
+			borrow = borrow_out;
+			return difference;
+		}
+	}
+
+	inline namespace instructions { extern "C" {
+
+		/**
+		 * Adds two numbers and the carry of a previous addition
+		 * @note The carry out is stored in the register the next (more significant) limb's sum is stored in, so numbers made of several 64 bit limbs can be added by one add_carry per limb (storing the sum's limbs in consecutive registers)
+		 * @param out register storing the carry in (zero or one) and to store \p a + \p b + carry in, the register after it (out + 1) is where the carry out is stored
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* add_carry(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			uint64_t carry = registers[pc->out];
+			auto dbg = registers[pc->out] = detail::add_with_carry(registers[pc->a], registers[pc->b], carry);
+			registers[pc->out + 1] = carry;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(add_carry);
+
+		/**
+		 * Subtracts one number and the borrow of a previous subtraction from another
+		 * @note Like mizu::add_carry the borrow out is stored in the register the next (more significant) limb's difference is stored in
+		 * @param out register storing the borrow in (zero or one) and to store \p a - \p b - borrow in, the register after it (out + 1) is where the borrow out is stored
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* subtract_borrow(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			uint64_t borrow = registers[pc->out];
+			auto dbg = registers[pc->out] = detail::subtract_with_borrow(registers[pc->a], registers[pc->b], borrow);
+			registers[pc->out + 1] = borrow;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(subtract_borrow);
+
+		/**
+		 * Multiplies two numbers keeping the whole 128 bit product
+		 * @note Like the limbs of mizu::add_carry the less significant half is stored first
+		 * @param out register to store the lower 64 bits of \p a * \p b in, the register after it (out + 1) is where the upper 64 bits are stored
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* multiply_wide(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			uint64_t a = registers[pc->a], b = registers[pc->b];
+			auto dbg = registers[pc->out] = a * b;
+			registers[pc->out + 1] = detail::upper_product(a, b);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(multiply_wide);
+	}}
+
+	namespace unsafe { inline namespace instructions { extern "C" {
+
+		/**
+		 * Adds two numbers stored as arrays of 64 bit limbs (least significant limb first)
+		 *
+		 * @param out Register storing a pointer to where the sum's limbs should be stored (may be the same as \p a or \p b), the register after it (out + 1) stores how many limbs each number has and is replaced with the carry out of the most significant limb
+		 * @param a Register storing a pointer to the first number's limbs
+		 * @param b Register storing a pointer to the second number's limbs
+		 */
+		void* bigint_add(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto sum = (uint64_t*)registers[pc->out];
+			auto a = (const uint64_t*)registers[pc->a];
+			auto b = (const uint64_t*)registers[pc->b];
+			size_t n = registers[pc->out + 1];
+			uint64_t carry = 0;
+			for(size_t i = 0; i < n; ++i)
+				sum[i] = detail::add_with_carry(a[i], b[i], carry);
+			registers[pc->out + 1] = carry;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(bigint_add);
+
+		/**
+		 * Subtracts one number stored as an array of 64 bit limbs (least significant limb first) from another
+		 *
+		 * @param out Register storing a pointer to where the difference's limbs should be stored (may be the same as \p a or \p b), the register after it (out + 1) stores how many limbs each number has and is replaced with the borrow out of the most significant limb
+		 * @param a Register storing a pointer to the limbs of the number to subtract from
+		 * @param b Register storing a pointer to the limbs of the number to subtract
+		 */
+		void* bigint_subtract(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto difference = (uint64_t*)registers[pc->out];
+			auto a = (const uint64_t*)registers[pc->a];
+			auto b = (const uint64_t*)registers[pc->b];
+			size_t n = registers[pc->out + 1];
+			uint64_t borrow = 0;
+			for(size_t i = 0; i < n; ++i)
+				difference[i] = detail::subtract_with_borrow(a[i], b[i], borrow);
+			registers[pc->out + 1] = borrow;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(bigint_subtract);
+
+		/**
+		 * Multiplies two numbers stored as arrays of 64 bit limbs (least significant limb first)
+		 *
+		 * @param out Register storing a pointer to where the product's limbs should be stored (twice as many limbs as each number, must not overlap \p a or \p b), the register after it (out + 1) stores how many limbs each number has
+		 * @param a Register storing a pointer to the first number's limbs
+		 * @param b Register storing a pointer to the second number's limbs
+		 */
+		void* bigint_multiply(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto product = (uint64_t*)registers[pc->out];
+			auto a = (const uint64_t*)registers[pc->a];
+			auto b = (const uint64_t*)registers[pc->b];
+			size_t n = registers[pc->out + 1];
+			std::fill(product, product + 2 * n, 0);
+			for(size_t i = 0; i < n; ++i) {
+				uint64_t carry = 0;
+				for(size_t j = 0; j < n; ++j) {
+					// NOTE: a[i] * b[j] + product[i + j] + carry always fits in 128 bits
+					uint64_t high = detail::upper_product(a[i], b[j]), low = a[i] * b[j];
+					low += carry;
+					high += low < carry;
+					low += product[i + j];
+					high += low < product[i + j];
+					product[i + j] = low;
+					carry = high;
+				}
+				product[i + n] = carry;
+			}
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(bigint_multiply);
+	}}}
+
+	// Register all the unsafe functions with the lookup system
+	MIZU_REGISTER_INSTRUCTION(unsafe::bigint_add);
+	MIZU_REGISTER_INSTRUCTION(unsafe::bigint_subtract);
+	MIZU_REGISTER_INSTRUCTION(unsafe::bigint_multiply);
+}
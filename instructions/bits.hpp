@@ -0,0 +1,204 @@
+#pragma once
+
+#include "../mizu/opcode.hpp"
+
+#include <bit>
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+namespace mizu {
+	namespace detail {
+		/**
+		 * Calculates the upper 64 bits of the 128 bit product of two numbers
+		 */
+		inline uint64_t upper_product(uint64_t a, uint64_t b) {
+#ifdef _MSC_VER
+			return __umulh(a, b);
+#else
+			return (unsigned __int128)a * b >> 64;
+#endif
+		}
+
+		/**
+		 * Calculates the upper 64 bits of the 128 bit product of two signed numbers
+		 */
+		inline int64_t upper_product_signed(int64_t a, int64_t b) {
+#ifdef _MSC_VER
+			return __mulh(a, b);
+#else
+			return (__int128)a * b >> 64;
+#endif
+		}
+	}
+
+	inline namespace instructions { extern "C" {
+
+		/**
+		 * Counts how many bits of a number are set
+		 * @param out register to store the number of ones in \p a in
+		 * @param a register storing the value
+		 */
+		void* count_ones(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = std::popcount(registers[pc->a]);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(count_ones);
+
+		/**
+		 * Counts how many zero bits come before the most significant one bit of a number
+		 * @param out register to store the number of leading zeros in \p a in (64 if \p a is zero)
+		 * @param a register storing the value
+		 */
+		void* count_leading_zeros(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = std::countl_zero(registers[pc->a]);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(count_leading_zeros);
+
+		/**
+		 * Counts how many zero bits come after the least significant one bit of a number
+		 * @param out register to store the number of trailing zeros in \p a in (64 if \p a is zero)
+		 * @param a register storing the value
+		 */
+		void* count_trailing_zeros(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = std::countr_zero(registers[pc->a]);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(count_trailing_zeros);
+
+		/**
+		 * Rotates the bits of a number towards its most significant bit (bits shifted out of the top reappear at the bottom)
+		 * @param out register to store \p a rotated left by \p b in
+		 * @param a register storing the value to rotate
+		 * @param b register storing how many bits to rotate by (modulo 64)
+		 */
+		void* rotate_left(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = std::rotl(registers[pc->a], registers[pc->b] & 63);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(rotate_left);
+
+		/**
+		 * Rotates the bits of a number towards its least significant bit (bits shifted out of the bottom reappear at the top)
+		 * @param out register to store \p a rotated right by \p b in
+		 * @param a register storing the value to rotate
+		 * @param b register storing how many bits to rotate by (modulo 64)
+		 */
+		void* rotate_right(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = std::rotr(registers[pc->a], registers[pc->b] & 63);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(rotate_right);
+
+		/**
+		 * Rotates the bits of a number towards its most significant bit by an immediate
+		 * @param out register to store \p a rotated left by \p b in
+		 * @param a register storing the value to rotate
+		 * @param b (branch immediate) how many bits to rotate by (modulo 64, so negative immediates rotate the other way)
+		 */
+		void* rotate_left_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = std::rotl(registers[pc->a], *(int16_t*)&pc->b & 63);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(rotate_left_immediate);
+
+		/**
+		 * Rotates the bits of a number towards its least significant bit by an immediate
+		 * @param out register to store \p a rotated right by \p b in
+		 * @param a register storing the value to rotate
+		 * @param b (branch immediate) how many bits to rotate by (modulo 64, so negative immediates rotate the other way)
+		 */
+		void* rotate_right_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = std::rotr(registers[pc->a], *(int16_t*)&pc->b & 63);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(rotate_right_immediate);
+
+		/**
+		 * Reverses the order of the bytes in a number (converting between little and big endian)
+		 * @param out register to store \p a with its bytes reversed in
+		 * @param a register storing the value
+		 */
+		void* byte_swap(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = std::byteswap(registers[pc->a]);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(byte_swap);
+
+		/**
+		 * Multiplies two numbers keeping the upper half of the 128 bit product
+		 * @param out register to store the upper 64 bits of \p a * \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* multiply_high(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = detail::upper_product(registers[pc->a], registers[pc->b]);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(multiply_high);
+
+		/**
+		 * Multiplies two numbers keeping the upper half of the 128 bit product
+		 * @param out register to store the upper 64 bits of \p a * \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 * @note Both \p a and \p b are treated as being signed
+		 */
+		void* multiply_high_signed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = detail::upper_product_signed(*(int64_t*)&registers[pc->a], *(int64_t*)&registers[pc->b]);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(multiply_high_signed);
+	}}
+}
@@ -1,8 +1,17 @@
 #pragma once
 
 #include "../mizu/opcode.hpp"
+#include "../mizu/exception.hpp"
 
 #include <fp/string.h>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef MIZU_ENABLE_QUICKENING
+	#include <atomic>
+#endif
 
 namespace mizu {
 
@@ -31,6 +40,138 @@ namespace mizu {
 	 */
 	constexpr uint32_t label2immediate(const fp_string label) { return label2immediate(fp_string_to_view_const(label)); }
 
+	namespace detail {
+		/**
+		 * Divides two signed numbers (rounding towards zero)
+		 * @note Dividing by -1 negates \p a (wrapping around for the smallest signed number) instead of overflowing
+		 */
+		inline int64_t signed_quotient(int64_t a, int64_t b) {
+			if(b == -1) return int64_t(0 - uint64_t(a));
+			return a / b;
+		}
+
+		/**
+		 * Finds the remainder of the division of two signed numbers
+		 * @note The remainder of dividing by -1 is always zero (even for the smallest signed number)
+		 */
+		inline int64_t signed_remainder(int64_t a, int64_t b) {
+			if(b == -1) return 0;
+			return a % b;
+		}
+
+		/**
+		 * Reads the instruction an opcode performs
+		 * @note When quickening is enabled other threads may be rewriting the opcode, so it is read atomically
+		 */
+		inline auto read_instruction(opcode* op) {
+#ifdef MIZU_ENABLE_QUICKENING
+			return std::atomic_ref(op->op).load(std::memory_order_relaxed);
+#else
+			return op->op;
+#endif
+		}
+
+		/**
+		 * Reads the 32 bit immediate stored in an opcode's \p a and \p b
+		 * @note When quickening is enabled other threads may be rewriting the opcode, so both halves are read atomically
+		 */
+		inline uint32_t read_immediate(opcode* op) {
+#ifdef MIZU_ENABLE_QUICKENING
+			reg_t halves[2] = {std::atomic_ref(op->a).load(std::memory_order_relaxed), std::atomic_ref(op->b).load(std::memory_order_relaxed)};
+			return std::bit_cast<uint32_t>(halves);
+#else
+			return *(uint32_t*)&op->a;
+#endif
+		}
+
+		/**
+		 * Remembers the return address of a call on the environment's shadow stack
+		 *
+		 * @param env the environment the call is made in
+		 * @param return_address the opcode the call will return to
+		 */
+		inline void shadow_stack_push(registers_and_stack* env, const opcode* return_address) {
+			if(env->shadow_stack_depth < MIZU_SHADOW_STACK_SIZE)
+				env->shadow_stack[env->shadow_stack_depth] = return_address;
+			++env->shadow_stack_depth;
+		}
+
+		/**
+		 * Pops the return address of the innermost call off of the environment's shadow stack
+		 * @note When MIZU_CHECK_SHADOW_STACK is defined, throws if the remembered address doesn't match \p return_address
+		 *
+		 * @param env the environment the return happens in
+		 * @param return_address the address stored in the return address register
+		 * @return const opcode* the opcode to return to (always \p return_address)
+		 */
+		inline const opcode* shadow_stack_pop(registers_and_stack* env, const opcode* return_address) {
+			if(env->shadow_stack_depth == 0) return return_address; // Returning from a call made by the host (or a jump_to)
+			auto depth = --env->shadow_stack_depth;
+			if(depth >= MIZU_SHADOW_STACK_SIZE) return return_address;
+#ifdef MIZU_CHECK_SHADOW_STACK
+			if(env->shadow_stack[depth] != return_address)
+				MIZU_THROW(std::runtime_error("Return address doesn't match the one remembered by the shadow stack."));
+#endif
+			return return_address;
+		}
+
+		/**
+		 * Reserves space on the stack and copies the registers from \p first to \p last (inclusive) into it
+		 * @return uint8_t* the new stack pointer
+		 */
+		inline uint8_t* push_registers(uint64_t* registers, registers_and_stack* env, uint8_t* sp, reg_t first, reg_t last) {
+			assert(first <= last);
+			size_t size = (last - first + 1) * sizeof(uint64_t);
+			sp -= size;
+			assert(sp > env->stack_boundary);
+			assert(sp <= env->stack_bottom);
+			std::memcpy(sp, registers + first, size);
+			return sp;
+		}
+
+		/**
+		 * Copies the registers saved by push_registers back and releases the space they took on the stack
+		 * @return uint8_t* the new stack pointer
+		 */
+		inline uint8_t* pop_registers(uint64_t* registers, registers_and_stack* env, uint8_t* sp, reg_t first, reg_t last) {
+			assert(first <= last);
+			size_t size = (last - first + 1) * sizeof(uint64_t);
+			assert(sp + size > env->stack_boundary);
+			assert(sp + size <= env->stack_bottom);
+			std::memcpy(registers + first, sp, size);
+			registers[0] = 0;
+			return sp + size;
+		}
+
+		/**
+		 * Reserves space on the stack and copies the registers selected by \p mask (bit i selects register \p first + i) into it
+		 * @return uint8_t* the new stack pointer
+		 */
+		inline uint8_t* push_register_mask(uint64_t* registers, registers_and_stack* env, uint8_t* sp, reg_t first, uint32_t mask) {
+			sp -= std::popcount(mask) * sizeof(uint64_t);
+			assert(sp > env->stack_boundary);
+			assert(sp <= env->stack_bottom);
+			auto saved = (uint64_t*)sp;
+			for(; mask; mask &= mask - 1)
+				*saved++ = registers[first + std::countr_zero(mask)];
+			return sp;
+		}
+
+		/**
+		 * Copies the registers saved by push_register_mask (with the same mask) back and releases the space they took on the stack
+		 * @return uint8_t* the new stack pointer
+		 */
+		inline uint8_t* pop_register_mask(uint64_t* registers, registers_and_stack* env, uint8_t* sp, reg_t first, uint32_t mask) {
+			assert(sp + std::popcount(mask) * sizeof(uint64_t) > env->stack_boundary);
+			assert(sp + std::popcount(mask) * sizeof(uint64_t) <= env->stack_bottom);
+			auto saved = (uint64_t*)sp;
+			for(; mask; mask &= mask - 1)
+				registers[first + std::countr_zero(mask)] = *saved++;
+			registers[0] = 0;
+			return (uint8_t*)saved;
+		}
+	}
+
 	inline namespace instructions { extern "C" {
 		constexpr auto program_end = nullptr;
 
@@ -49,6 +190,42 @@ namespace mizu {
 #endif
 		MIZU_REGISTER_INSTRUCTION(label);
 
+		/**
+		 * Stores the address of an opcode relative to this one
+		 * @param out register to store the address in
+		 * @param signed immediate how many opcodes away from this one the address should point
+		 * @note When quickening is enabled find_label instructions rewrite themselves into this instruction once they have found their label.
+		 */
+		void* load_relative_address(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+#ifdef MIZU_ENABLE_QUICKENING
+			// Dispatch read our instruction without synchronizing, so acquire the rewrite (which find_label released) before reading the offset it wrote
+			std::atomic_ref(pc->op).load(std::memory_order_acquire);
+#endif
+			auto dbg = registers[pc->out] = (uint64_t)(pc + int32_t(detail::read_immediate(pc)));
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(load_relative_address);
+
+		/**
+		 * Placeholder which an opcode is replaced with while it is being quickened, waits for the rewrite to finish and then runs the rewritten instruction
+		 * @note Only placed in programs when MIZU_ENABLE_QUICKENING is defined.
+		 */
+		void* quickening_in_progress(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			--pc; // NOTE: Dispatches to the same opcode again
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(quickening_in_progress);
+
 		/**
 		 * Finds the provided label and stores a pointer to it in \p out
 		 * @param out register to store the label pointer in
@@ -63,22 +240,48 @@ namespace mizu {
 		{
 			auto program_start = env->calculate_program_start(pc);
 			auto program_end = env->calculate_program_end(pc);
-			auto needle = *(uint32_t*)&pc->a;
+#ifdef MIZU_ENABLE_QUICKENING
+			// If another thread already started rewriting this opcode run the rewritten instruction instead
+			std::atomic_ref op(pc->op);
+			if(op.load(std::memory_order_acquire) != find_label) {
+				--pc;
+				MIZU_NEXT();
+			}
+#endif
+			auto needle = detail::read_immediate(pc);
 			registers[pc->out] = 0;
 
 			// Try to find searching till the end
 			for(auto cur = pc; cur != program_end; ++cur)
-				if(cur->op == label && *(uint32_t*)&cur->a == needle) {
+				if(detail::read_instruction(cur) == label && detail::read_immediate(cur) == needle) {
 					registers[pc->out] = (uint64_t)cur;
 					break;
 				}
 			// If we failed to find try searching till the beginning
 			if(registers[pc->out] == 0)
 				for(auto cur = pc; cur != program_start; --cur)
-					if(cur->op == label && *(uint32_t*)&cur->a == needle) {
+					if(detail::read_instruction(cur) == label && detail::read_immediate(cur) == needle) {
 						registers[pc->out] = (uint64_t)cur;
 						break;
 					}
+#ifdef MIZU_ENABLE_QUICKENING
+			// If another thread rewrote this opcode while we were searching the needle might have been read mid rewrite, so run the rewritten instruction instead
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if(op.load(std::memory_order_relaxed) != find_label) {
+				--pc;
+				MIZU_NEXT();
+			}
+
+			// Rewrite ourselves into a load of the address we found (only one thread gets to perform the rewrite, and every thread would write the same thing)
+			auto offset = (opcode*)registers[pc->out] - pc;
+			decltype(pc->op) expected = find_label;
+			if(registers[pc->out] && offset == int32_t(offset) && op.compare_exchange_strong(expected, quickening_in_progress, std::memory_order_acquire)) {
+				int32_t immediate = offset;
+				std::atomic_ref(pc->a).store(((reg_t*)&immediate)[0], std::memory_order_relaxed);
+				std::atomic_ref(pc->b).store(((reg_t*)&immediate)[1], std::memory_order_relaxed);
+				op.store(load_relative_address, std::memory_order_release);
+			}
+#endif
 			auto dbg = (opcode*)registers[pc->out];
 			MIZU_NEXT();
 		}
@@ -180,6 +383,25 @@ namespace mizu {
 #endif
 		MIZU_REGISTER_INSTRUCTION(load_upper_immediate);
 
+		/**
+		 * Loads a full 64 bit value from the environment's constant pool (see mizu::constant_pool) into a register
+		 * @note Replaces a load_immediate and load_upper_immediate pair when loading host pointers, 64 bit integers, or f64s.
+		 * @param out the register to update
+		 * @param immediate the index of the constant to load
+		 */
+		void* load_constant(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto index = *(uint32_t*)&pc->a;
+			assert(index < env->constants.size());
+			auto dbg = registers[pc->out] = env->constants[index];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(load_constant);
+
 		/**
 		 * Converts a register to a 64 bit integer.
 		 * @param out register to store the result in
@@ -196,16 +418,21 @@ namespace mizu {
 #endif
 		MIZU_REGISTER_INSTRUCTION(convert_to_u64);
 
-// 		void* convert_to_i64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
-// #ifdef MIZU_IMPLEMENTATION
-// 		{
-// 			auto dbg = ((int64_t&)registers[pc->out]) = registers[pc->a];
-// 			MIZU_NEXT();
-// 		}
-// #else
-// 		;
-// #endif
-//		MIZU_REGISTER_INSTRUCTION(convert_to_i64);
+		/**
+		 * Converts a register to a signed 64 bit integer.
+		 * @param out register to store the result in
+		 * @param a register whose value to convert
+		 */
+		void* convert_to_i64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(convert_to_i64);
 
 		/**
 		 * Converts a register to a 32 bit integer.
@@ -223,16 +450,21 @@ namespace mizu {
 #endif
 		MIZU_REGISTER_INSTRUCTION(convert_to_u32);
 
-// 		void* convert_to_i32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
-// #ifdef MIZU_IMPLEMENTATION
-// 		{
-// 			auto dbg = ((int32_t&)registers[pc->out]) = registers[pc->a];
-// 			MIZU_NEXT();
-// 		}
-// #else
-// 		;
-// #endif
-//		MIZU_REGISTER_INSTRUCTION(convert_to_i32);
+		/**
+		 * Converts a register to a signed 32 bit integer (sign extending its bottom 32 bits to fill the whole register).
+		 * @param out register to store the result in
+		 * @param a register whose value to convert
+		 */
+		void* convert_to_i32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = int64_t(int32_t(registers[pc->a]));
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(convert_to_i32);
 
 		/**
 		 * Converts a register to a 16 bit integer.
@@ -250,16 +482,21 @@ namespace mizu {
 #endif
 		MIZU_REGISTER_INSTRUCTION(convert_to_u16);
 
-// 		void* convert_to_i16(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
-// #ifdef MIZU_IMPLEMENTATION
-// 		{
-// 			auto dbg = ((int16_t&)registers[pc->out]) = registers[pc->a];
-// 			MIZU_NEXT();
-// 		}
-// #else
-// 		;
-// #endif
-//		MIZU_REGISTER_INSTRUCTION(convert_to_i16);
+		/**
+		 * Converts a register to a signed 16 bit integer (sign extending its bottom 16 bits to fill the whole register).
+		 * @param out register to store the result in
+		 * @param a register whose value to convert
+		 */
+		void* convert_to_i16(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = int64_t(int16_t(registers[pc->a]));
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(convert_to_i16);
 
 		/**
 		 * Converts a register to an 8 bit integer.
@@ -277,6 +514,22 @@ namespace mizu {
 #endif
 		MIZU_REGISTER_INSTRUCTION(convert_to_u8);
 
+		/**
+		 * Converts a register to a signed 8 bit integer (sign extending its bottom 8 bits to fill the whole register).
+		 * @param out register to store the result in
+		 * @param a register whose value to convert
+		 */
+		void* convert_to_i8(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = int64_t(int8_t(registers[pc->a]));
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(convert_to_i8);
+
 		/**
 		 * Loads a 64 bit integer from the stack
 		 * @param out register to store the result in
@@ -434,499 +687,1582 @@ namespace mizu {
 		MIZU_REGISTER_INSTRUCTION(stack_store_u8);
 
 		/**
-		 * Subtracts a value from the stack pointer. In other words reserves some additional memory on the stack.
-		 * @param a register storing how many bytes to reserve
+		 * Loads a 32 bit integer from the stack, sign extending it to 64 bits
+		 * @param out register to store the result in
+		 * @param a register storing an offset to the current stack pointer (defaults to zero bytes)
 		 */
-		void* stack_push(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* stack_load_i32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			sp -= registers[pc->a];
-			assert(sp > env->stack_boundary);
-			assert(sp <= env->stack_bottom);
+			uint8_t* offset = (uint8_t*)(sp + registers[pc->a]);
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = (int64_t)*(int32_t*)offset;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(stack_push);
+		MIZU_REGISTER_INSTRUCTION(stack_load_i32);
 
 		/**
-		 * Subtracts a value from the stack pointer. In other words reserves some additional memory on the stack.
-		 * @param immediate how many bytes to reserve
+		 * Loads a 16 bit integer from the stack, sign extending it to 64 bits
+		 * @param out register to store the result in
+		 * @param a register storing an offset to the current stack pointer (defaults to zero bytes)
 		 */
-		void* stack_push_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* stack_load_i16(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto& size = *(uint32_t*)&pc->a;
-			sp -= size;
-			assert(sp > env->stack_boundary);
-			assert(sp <= env->stack_bottom);
+			uint8_t* offset = (uint8_t*)(sp + registers[pc->a]);
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = (int64_t)*(int16_t*)offset;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(stack_push_immediate);
+		MIZU_REGISTER_INSTRUCTION(stack_load_i16);
 
 		/**
-		 * Adds a value to stack pointer. In other words releases reserved memory on the stack.
-		 * @param a register storing how many bytes to release
+		 * Loads an 8 bit integer from the stack, sign extending it to 64 bits
+		 * @param out register to store the result in
+		 * @param a register storing an offset to the current stack pointer (defaults to zero bytes)
 		 */
-		void* stack_pop(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* stack_load_i8(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			sp += registers[pc->a];
-			assert(sp > env->stack_boundary);
-			assert(sp <= env->stack_bottom);
+			uint8_t* offset = (uint8_t*)(sp + registers[pc->a]);
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = (int64_t)*(int8_t*)offset;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(stack_pop);
+		MIZU_REGISTER_INSTRUCTION(stack_load_i8);
 
 		/**
-		 * Adds a value to stack pointer. In other words releases reserved memory on the stack.
-		 * @param immediate how many bytes to release
+		 * Loads a 64 bit integer from the stack at an immediate offset
+		 * @param out register to store the result in
+		 * @param b (branch immediate) offset to the current stack pointer in bytes
 		 */
-		void* stack_pop_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* stack_load_u64_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto& size = *(uint32_t*)&pc->a;
-			sp += size;
-			assert(sp > env->stack_boundary);
-			assert(sp <= env->stack_bottom);
+			uint8_t* offset = sp + *(int16_t*)&pc->b;
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = *(uint64_t*)offset;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(stack_pop_immediate);
+		MIZU_REGISTER_INSTRUCTION(stack_load_u64_immediate);
 
 		/**
-		 * Returns the offset needed to load/store to the bottom of the stack
-		 * @param out register to store the calculated offset in
-		 * @param a register storing a signed offset relative to the bottom of the stack
+		 * Loads a 32 bit integer from the stack at an immediate offset
+		 * @param out register to store the result in
+		 * @param b (branch immediate) offset to the current stack pointer in bytes
 		 */
-		void* offset_of_stack_bottom(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* stack_load_u32_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto offset = (int64_t&)registers[pc->a];
-			auto bottom = env->stack_bottom - offset;
-			assert(bottom > env->stack_boundary);
-			assert(bottom <= env->stack_bottom);
-			auto dbg = registers[pc->out] = sp - bottom;
+			uint8_t* offset = sp + *(int16_t*)&pc->b;
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = *(uint32_t*)offset;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(offset_of_stack_bottom);
+		MIZU_REGISTER_INSTRUCTION(stack_load_u32_immediate);
 
 		/**
-		 * Moves the program counter by an offset. If the offset is zero this instruction is executed again. If it is one the next instruction is executed as usual.
-		 *	If it is negative a previous instruction is executed.
-		 * @param out register to store the address of the instruction that should be executed next.
-		 * @param a register storing how many instructions to jump
-		 * @note \p a is interpreted as a signed integer, allowing for negative jumps
+		 * Loads a 16 bit integer from the stack at an immediate offset
+		 * @param out register to store the result in
+		 * @param b (branch immediate) offset to the current stack pointer in bytes
 		 */
-		void* jump_relative(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* stack_load_u16_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto a = registers[pc->a];
-			auto dbg = registers[pc->out] = (uint64_t)(pc + 1);
-			pc += *(int64_t*)&a - 1;
+			uint8_t* offset = sp + *(int16_t*)&pc->b;
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = *(uint16_t*)offset;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(jump_relative);
+		MIZU_REGISTER_INSTRUCTION(stack_load_u16_immediate);
 
 		/**
-		 * Moves the program counter by an offset. If the offset is zero this instruction is executed again. If it is one the next instruction is executed as usual.
-		 *	If it is negative a previous instruction is executed.
-		 * @param out register to store the address of the instruction that should be executed next.
-		 * @param immediate how many instructions to jump
-		 * @note \p immediate is interpreted as a signed integer, allowing for negative jumps
+		 * Loads an 8 bit integer from the stack at an immediate offset
+		 * @param out register to store the result in
+		 * @param b (branch immediate) offset to the current stack pointer in bytes
 		 */
-		void* jump_relative_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* stack_load_u8_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = (uint64_t)(pc + 1);
-			pc += *(int32_t*)&pc->a - 1;
+			uint8_t* offset = sp + *(int16_t*)&pc->b;
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = *offset;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(jump_relative_immediate);
+		MIZU_REGISTER_INSTRUCTION(stack_load_u8_immediate);
 
 		/**
-		 * Sets the program counter to a value (usually the output of another jump)
-		 * @param out register to store the address of the instruction that should be executed next.
-		 * @param a register storing the address of the instruction to jump to.
+		 * Loads a 32 bit integer from the stack at an immediate offset, sign extending it to 64 bits
+		 * @param out register to store the result in
+		 * @param b (branch immediate) offset to the current stack pointer in bytes
 		 */
-		void* jump_to(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* stack_load_i32_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = (uint64_t)(pc + 1);
-			pc = (opcode*)registers[pc->a] - 1;
+			uint8_t* offset = sp + *(int16_t*)&pc->b;
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = (int64_t)*(int32_t*)offset;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(jump_to);
+		MIZU_REGISTER_INSTRUCTION(stack_load_i32_immediate);
 
 		/**
-		 * Moves the program counter by an offset similar to a jump, however only does so if the condition register is not zero
-		 * @param out register to store the address of the instruction that should be executed next.
-		 * @param a register storing a condition, zero indicates no jump while any other number indicates that a jump should occur
-		 * @param b register storing how many instructions to jump
-		 * @note \p b is interpreted as a signed integer, allowing for negative jumps
+		 * Loads a 16 bit integer from the stack at an immediate offset, sign extending it to 64 bits
+		 * @param out register to store the result in
+		 * @param b (branch immediate) offset to the current stack pointer in bytes
 		 */
-		void* branch_relative(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* stack_load_i16_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = (uint64_t)(pc + 1);
-			if(registers[pc->a])
-				pc += *(int64_t*)&registers[pc->b] - 1;
+			uint8_t* offset = sp + *(int16_t*)&pc->b;
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = (int64_t)*(int16_t*)offset;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(branch_relative);
+		MIZU_REGISTER_INSTRUCTION(stack_load_i16_immediate);
 
 		/**
-		 * Moves the program counter by an offset similar to a jump, however only does so if the condition register is not zero
-		 * @param out register to store the address of the instruction that should be executed next.
-		 * @param a register storing a condition, zero indicates no jump while any other number indicates that a jump should occur
-		 * @param b (branch immediate) how many instructions to jump
-		 * @note \p b is interpreted as a signed integer, allowing for negative jumps
+		 * Loads an 8 bit integer from the stack at an immediate offset, sign extending it to 64 bits
+		 * @param out register to store the result in
+		 * @param b (branch immediate) offset to the current stack pointer in bytes
 		 */
-		void* branch_relative_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* stack_load_i8_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = (uint64_t)(pc + 1);
-			if(registers[pc->a])
-				pc += *(int16_t*)&pc->b - 1;
+			uint8_t* offset = sp + *(int16_t*)&pc->b;
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = (int64_t)*(int8_t*)offset;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_load_i8_immediate);
+
+		/**
+		 * Copies a 64 bit integer from a register to the stack at an immediate offset.
+		 * @param out register to store another copy in
+		 * @param a register storing the value to copy
+		 * @param b (branch immediate) offset to the current stack pointer in bytes
+		 */
+		void* stack_store_u64_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			uint8_t* offset = sp + *(int16_t*)&pc->b;
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = *(uint64_t*)offset = *(uint64_t*)&registers[pc->a];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_store_u64_immediate);
+
+		/**
+		 * Copies a 32 bit integer from a register to the stack at an immediate offset.
+		 * @param out register to store another copy in
+		 * @param a register storing the value to copy
+		 * @param b (branch immediate) offset to the current stack pointer in bytes
+		 */
+		void* stack_store_u32_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			uint8_t* offset = sp + *(int16_t*)&pc->b;
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = *(uint32_t*)offset = *(uint32_t*)&registers[pc->a];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_store_u32_immediate);
+
+		/**
+		 * Copies a 16 bit integer from a register to the stack at an immediate offset.
+		 * @param out register to store another copy in
+		 * @param a register storing the value to copy
+		 * @param b (branch immediate) offset to the current stack pointer in bytes
+		 */
+		void* stack_store_u16_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			uint8_t* offset = sp + *(int16_t*)&pc->b;
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = *(uint16_t*)offset = *(uint16_t*)&registers[pc->a];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_store_u16_immediate);
+
+		/**
+		 * Copies an 8 bit integer from a register to the stack at an immediate offset.
+		 * @param out register to store another copy in
+		 * @param a register storing the value to copy
+		 * @param b (branch immediate) offset to the current stack pointer in bytes
+		 */
+		void* stack_store_u8_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			uint8_t* offset = sp + *(int16_t*)&pc->b;
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = *offset = *(uint8_t*)&registers[pc->a];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_store_u8_immediate);
+
+		/**
+		 * Subtracts a value from the stack pointer. In other words reserves some additional memory on the stack.
+		 * @param a register storing how many bytes to reserve
+		 */
+		void* stack_push(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			sp -= registers[pc->a];
+			assert(sp > env->stack_boundary);
+			assert(sp <= env->stack_bottom);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_push);
+
+		/**
+		 * Subtracts a value from the stack pointer. In other words reserves some additional memory on the stack.
+		 * @param immediate how many bytes to reserve
+		 */
+		void* stack_push_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto& size = *(uint32_t*)&pc->a;
+			sp -= size;
+			assert(sp > env->stack_boundary);
+			assert(sp <= env->stack_bottom);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_push_immediate);
+
+		/**
+		 * Adds a value to stack pointer. In other words releases reserved memory on the stack.
+		 * @param a register storing how many bytes to release
+		 */
+		void* stack_pop(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			sp += registers[pc->a];
+			assert(sp > env->stack_boundary);
+			assert(sp <= env->stack_bottom);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_pop);
+
+		/**
+		 * Adds a value to stack pointer. In other words releases reserved memory on the stack.
+		 * @param immediate how many bytes to release
+		 */
+		void* stack_pop_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto& size = *(uint32_t*)&pc->a;
+			sp += size;
+			assert(sp > env->stack_boundary);
+			assert(sp <= env->stack_bottom);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_pop_immediate);
+
+		/**
+		 * Reserves space on the stack and saves a contiguous range of registers into it (the first register ends up at the new stack pointer)
+		 * @note Meant for function prologues, saving several registers takes a single copy instead of an immediate load and store for each of them.
+		 * @param a first register to save
+		 * @param b last register to save (inclusive)
+		 */
+		void* stack_push_registers(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			sp = detail::push_registers(registers, env, sp, pc->a, pc->b);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_push_registers);
+
+		/**
+		 * Restores a contiguous range of registers saved by stack_push_registers and releases the space they took on the stack
+		 * @param a first register to restore
+		 * @param b last register to restore (inclusive)
+		 */
+		void* stack_pop_registers(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			sp = detail::pop_registers(registers, env, sp, pc->a, pc->b);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_pop_registers);
+
+		/**
+		 * Reserves space on the stack and saves the registers selected by a mask into it (lower registers end up closer to the new stack pointer)
+		 * @note Unlike stack_push_registers the saved registers don't need to be next to each other, so a function can save its return address and the registers it clobbers while leaving its arguments and results alone.
+		 * @param out first register the mask refers to
+		 * @param immediate mask where bit i selects register out + i
+		 */
+		void* stack_push_register_mask(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			sp = detail::push_register_mask(registers, env, sp, pc->out, *(uint32_t*)&pc->a);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_push_register_mask);
+
+		/**
+		 * Restores the registers saved by a stack_push_register_mask (with the same mask) and releases the space they took on the stack
+		 * @param out first register the mask refers to
+		 * @param immediate mask where bit i selects register out + i
+		 */
+		void* stack_pop_register_mask(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			sp = detail::pop_register_mask(registers, env, sp, pc->out, *(uint32_t*)&pc->a);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_pop_register_mask);
+
+		/**
+		 * Returns the offset needed to load/store to the bottom of the stack
+		 * @param out register to store the calculated offset in
+		 * @param a register storing a signed offset relative to the bottom of the stack
+		 */
+		void* offset_of_stack_bottom(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto offset = (int64_t&)registers[pc->a];
+			auto bottom = env->stack_bottom - offset;
+			assert(bottom > env->stack_boundary);
+			assert(bottom <= env->stack_bottom);
+			auto dbg = registers[pc->out] = sp - bottom;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(offset_of_stack_bottom);
+
+		/**
+		 * Moves the program counter by an offset. If the offset is zero this instruction is executed again. If it is one the next instruction is executed as usual.
+		 *	If it is negative a previous instruction is executed.
+		 * @param out register to store the address of the instruction that should be executed next.
+		 * @param a register storing how many instructions to jump
+		 * @note \p a is interpreted as a signed integer, allowing for negative jumps
+		 */
+		void* jump_relative(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto a = registers[pc->a];
+			auto dbg = registers[pc->out] = (uint64_t)(pc + 1);
+			pc += *(int64_t*)&a - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(jump_relative);
+
+		/**
+		 * Moves the program counter by an offset. If the offset is zero this instruction is executed again. If it is one the next instruction is executed as usual.
+		 *	If it is negative a previous instruction is executed.
+		 * @param out register to store the address of the instruction that should be executed next.
+		 * @param immediate how many instructions to jump
+		 * @note \p immediate is interpreted as a signed integer, allowing for negative jumps
+		 */
+		void* jump_relative_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = (uint64_t)(pc + 1);
+			pc += *(int32_t*)&pc->a - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(jump_relative_immediate);
+
+		/**
+		 * Sets the program counter to a value (usually the output of another jump)
+		 * @param out register to store the address of the instruction that should be executed next.
+		 * @param a register storing the address of the instruction to jump to.
+		 */
+		void* jump_to(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = (uint64_t)(pc + 1);
+			pc = (opcode*)registers[pc->a] - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(jump_to);
+
+		/**
+		 * Calls a function, setting the program counter to a value (usually found with mizu::find_label) and remembering where to return to on the environment's shadow stack
+		 * @note Should be paired with a mizu::return_to, since it has its own handler (unlike returns with jump_to) the host's branch predictor can tell returns apart from other indirect jumps
+		 * @param out register to store the address of the instruction that should be executed once the function returns (usually registers::return_address).
+		 * @param a register storing the address of the instruction to jump to.
+		 */
+		void* call_to(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = (uint64_t)(pc + 1);
+			detail::shadow_stack_push(env, pc + 1);
+			pc = (opcode*)registers[pc->a] - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(call_to);
+
+		/**
+		 * Returns from a function called with mizu::call_to, popping the return address off of the environment's shadow stack
+		 * @note The address stored in \p a is always jumped to, the shadow stack only keeps the calls and returns balanced.
+		 *	Every return_to should return from the innermost call_to which hasn't returned yet, when MIZU_CHECK_SHADOW_STACK is defined this is checked (throwing if it doesn't hold).
+		 * @param a register storing the address of the instruction to return to (usually registers::return_address).
+		 */
+		void* return_to(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			pc = (opcode*)detail::shadow_stack_pop(env, (const opcode*)registers[pc->a]) - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(return_to);
+
+		/**
+		 * Calls a function in a fresh register window, sliding the registers up by \p b so the callee's x0 is the caller's x(b)
+		 * @note Registers overlap between the windows, so the caller passes arguments in (and reads results from) a(b), a(b + 1), ... which the callee sees as a0, a1, ...
+		 *	The caller's registers below x(b) are left untouched (including its return address), so nothing needs to be saved on the stack.
+		 *	The caller's x(b) through x(b + 21) become the callee's zero, temporary, and return address registers.
+		 * @note Windows grow up into the stack's memory (the stack boundary moves up with them). If the new window would reach the stack pointer,
+		 *	the caller's registers below x(b) are instead spilled into memory owned by the environment and the rest moved down in place (as they are for every call nested inside of a spilled one).
+		 * @note Threads forked inside of a window start with the outermost window. Not supported alongside emulated (coroutine) threads.
+		 * @param out register (in the callee's window) to store the address of the instruction after the call in (usually registers::return_address).
+		 * @param a register storing the address of the function to call
+		 * @param b number of registers to slide the window by (must be at least 22 to keep the caller's return address and no more than 256, the size of a window)
+		 */
+		void* call_windowed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			assert(pc->b >= 22 && pc->b <= 256);
+			auto target = (opcode*)registers[pc->a];
+			auto size = pc->b * sizeof(uint64_t);
+			if(env->spilled_windows == 0 && env->stack_boundary + size < sp) {
+				registers += pc->b;
+				env->stack_boundary += size;
+			} else {
+				env->spilled_registers.insert(env->spilled_registers.end(), registers, registers + pc->b);
+				std::memmove(registers, registers + pc->b, env->stack_boundary - (uint8_t*)registers - size);
+				++env->spilled_windows;
+			}
+			registers[pc->out] = (size_t)(pc + 1);
+			pc = target - 1;
+#ifdef MIZU_LOOP_DISPATCH
+			env->register_window = registers;
+#endif
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(call_windowed);
+
+		/**
+		 * Returns from a function called with mizu::call_windowed, sliding the registers back to the caller's window
+		 * @param a register (in the callee's window) storing the address of the instruction to return to (usually registers::return_address).
+		 * @param b number of registers the call slid the window by (must match the call, so it is also between 22 and 256)
+		 */
+		void* return_windowed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			assert(pc->b >= 22 && pc->b <= 256);
+			auto target = (opcode*)registers[pc->a];
+			auto size = pc->b * sizeof(uint64_t);
+			if(env->spilled_windows == 0) {
+				registers -= pc->b;
+				env->stack_boundary -= size;
+			} else {
+				std::memmove(registers + pc->b, registers, env->stack_boundary - (uint8_t*)registers - size);
+				std::memcpy(registers, env->spilled_registers.data() + env->spilled_registers.size() - pc->b, size);
+				env->spilled_registers.resize(env->spilled_registers.size() - pc->b);
+				--env->spilled_windows;
+			}
+			pc = target - 1;
+#ifdef MIZU_LOOP_DISPATCH
+			env->register_window = registers;
+#endif
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(return_windowed);
+
+		/**
+		 * Moves the program counter by an offset similar to a jump, however only does so if the condition register is not zero
+		 * @param out register to store the address of the instruction that should be executed next.
+		 * @param a register storing a condition, zero indicates no jump while any other number indicates that a jump should occur
+		 * @param b register storing how many instructions to jump
+		 * @note \p b is interpreted as a signed integer, allowing for negative jumps
+		 */
+		void* branch_relative(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = (uint64_t)(pc + 1);
+			if(registers[pc->a])
+				pc += *(int64_t*)&registers[pc->b] - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(branch_relative);
+
+		/**
+		 * Moves the program counter by an offset similar to a jump, however only does so if the condition register is not zero
+		 * @param out register to store the address of the instruction that should be executed next.
+		 * @param a register storing a condition, zero indicates no jump while any other number indicates that a jump should occur
+		 * @param b (branch immediate) how many instructions to jump
+		 * @note \p b is interpreted as a signed integer, allowing for negative jumps
+		 */
+		void* branch_relative_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = (uint64_t)(pc + 1);
+			if(registers[pc->a])
+				pc += *(int16_t*)&pc->b - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(branch_relative_immediate);
+
+		/**
+		 * Sets the program counter to a value (usually the output of another jump), however only does so if the condition register is not zero
+		 * @param out register to store the address of the instruction that should be executed next.
+		 * @param a register storing a condition, zero indicates no jump while any other number indicates that a jump should occur
+		 * @param b register storing the address of the instruction to jump to.
+		 */
+		void* branch_to(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = (uint64_t)(pc + 1);
+			if(registers[pc->a])
+				pc = (opcode*)registers[pc->b] - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(branch_to);
+
+		/**
+		 * Moves the program counter by an offset if two registers are equal (comparing and branching with a single instruction)
+		 * @param out (out branch immediate) how many instructions to jump
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+		 */
+		void* branch_if_equal(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			if(registers[pc->a] == registers[pc->b])
+				pc += *(int16_t*)&pc->out - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(branch_if_equal);
+
+		/**
+		 * Moves the program counter by an offset if two registers are not equal (comparing and branching with a single instruction)
+		 * @param out (out branch immediate) how many instructions to jump
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+		 */
+		void* branch_if_not_equal(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			if(registers[pc->a] != registers[pc->b])
+				pc += *(int16_t*)&pc->out - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(branch_if_not_equal);
+
+		/**
+		 * Moves the program counter by an offset if a register is less than another (comparing and branching with a single instruction)
+		 * @param out (out branch immediate) how many instructions to jump
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+		 */
+		void* branch_if_less(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			if(registers[pc->a] < registers[pc->b])
+				pc += *(int16_t*)&pc->out - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(branch_if_less);
+
+		/**
+		 * Moves the program counter by an offset if a register is less than another (comparing and branching with a single instruction)
+		 * @param out (out branch immediate) how many instructions to jump
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+		 * @note Both \p a and \p b are treated as being signed
+		 */
+		void* branch_if_less_signed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			if(*(int64_t*)&registers[pc->a] < *(int64_t*)&registers[pc->b])
+				pc += *(int16_t*)&pc->out - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(branch_if_less_signed);
+
+		/**
+		 * Moves the program counter by an offset if a register is greater or equal to another (comparing and branching with a single instruction)
+		 * @param out (out branch immediate) how many instructions to jump
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+		 */
+		void* branch_if_greater_equal(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			if(registers[pc->a] >= registers[pc->b])
+				pc += *(int16_t*)&pc->out - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(branch_if_greater_equal);
+
+		/**
+		 * Moves the program counter by an offset if a register is greater or equal to another (comparing and branching with a single instruction)
+		 * @param out (out branch immediate) how many instructions to jump
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+		 * @note Both \p a and \p b are treated as being signed
+		 */
+		void* branch_if_greater_equal_signed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			if(*(int64_t*)&registers[pc->a] >= *(int64_t*)&registers[pc->b])
+				pc += *(int16_t*)&pc->out - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(branch_if_greater_equal_signed);
+
+		/**
+		 * Decrements a loop counter and moves the program counter by an offset while the counter isn't zero (a counted loop's bookkeeping in a single instruction)
+		 * @param out (out branch immediate) how many instructions to jump
+		 * @param a register storing the counter (decremented by one)
+		 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+		 */
+		void* loop_decrement_branch(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			if(--registers[pc->a] != 0)
+				pc += *(int16_t*)&pc->out - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(loop_decrement_branch);
+
+		/**
+		 * Subtracts a stride from a loop counter and moves the program counter by an offset while the counter is greater than zero (a counted loop's bookkeeping in a single instruction)
+		 * @param out (out branch immediate) how many instructions to jump
+		 * @param a register storing the counter (decremented by \p b)
+		 * @param b register storing the stride
+		 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+		 * @note The counter is treated as being signed, so loops whose count isn't a multiple of the stride still end
+		 */
+		void* loop_subtract_branch(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			registers[pc->a] -= registers[pc->b];
+			if(*(int64_t*)&registers[pc->a] > 0)
+				pc += *(int16_t*)&pc->out - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(loop_subtract_branch);
+
+		/**
+		 * Checks if two registers are equal
+		 * @param out register to be set to one if \p a == \p b or zero otherwise
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 */
+		void* set_if_equal(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] == registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(set_if_equal);
+
+		/**
+		 * Checks if two registers are not equal
+		 * @param out register to be set to one if \p a != \p b or zero otherwise
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 */
+		void* set_if_not_equal(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] != registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(set_if_not_equal);
+
+		/**
+		 * Checks if a register is less than another
+		 * @param out register to be set to one if \p a < \p b or zero otherwise
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 */
+		void* set_if_less(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] < registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(set_if_less);
+
+		/**
+		 * Checks if a register is less than another
+		 * @param out register to be set to one if \p a == \p b or zero otherwise
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note Both \p a and \p b are treated as being signed
+		 */
+		void* set_if_less_signed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = *(int64_t*)&registers[pc->a] < *(int64_t*)&registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(set_if_less_signed);
+
+		/**
+		 * Checks if a register is greater or equal to another
+		 * @param out register to be set to one if \p a >= \p b or zero otherwise
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 */
+		void* set_if_greater_equal(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] >= registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(set_if_greater_equal);
+
+		/**
+		 * Checks if a register is greater or equal to another
+		 * @param out register to be set to one if \p a >= \p b or zero otherwise
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note Both \p a and \p b are treated as being signed
+		 */
+		void* set_if_greater_equal_signed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = *(int64_t*)&registers[pc->a] >= *(int64_t*)&registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(set_if_greater_equal_signed);
+
+		/**
+		 * Adds two numbers
+		 * @param out register to store \p a + \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* add(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] + registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(add);
+
+		/**
+		 * Subtracts two numbers
+		 * @param out register to store \p a - \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* subtract(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] - registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(subtract);
+
+		/**
+		 * Multiplies two numbers
+		 * @param out register to store \p a * \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* multiply(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] * registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(multiply);
+
+		/**
+		 * Divides two numbers
+		 * @param out register to store \p a / \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* divide(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] / registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(divide);
+
+		/**
+		 * Finds the remainder of the division of two numbers
+		 * @param out register to store \p a % \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* modulus(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] % registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(modulus);
+
+		/**
+		 * Divides two signed numbers (rounding towards zero)
+		 * @note Dividing the smallest signed number by -1 wraps around to the smallest signed number, dividing by zero is undefined
+		 * @param out register to store \p a / \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* divide_signed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = detail::signed_quotient(registers[pc->a], registers[pc->b]);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(divide_signed);
+
+		/**
+		 * Finds the remainder of the division of two signed numbers (which has the same sign as \p a)
+		 * @note The remainder of dividing by -1 is always zero (even for the smallest signed number)
+		 * @param out register to store \p a % \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* modulus_signed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = detail::signed_remainder(registers[pc->a], registers[pc->b]);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(modulus_signed);
+
+		/**
+		 * Shifts one number left by another
+		 * @param out register to store \p a << \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* shift_left(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] << registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(shift_left);
+
+		/**
+		 * Shifts one number right by another
+		 * @param out register to store \p a >> \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* shift_right_logical(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] >> registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(shift_right_logical);
+
+		/**
+		 * Shifts one number right by another, sign extending it
+		 * @param out register to store \p a >> \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* shift_right_arithmetic(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = *(int64_t*)&registers[pc->a] >> registers[pc->b];
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(branch_relative_immediate);
+		MIZU_REGISTER_INSTRUCTION(shift_right_arithmetic);
 
 		/**
-		 * Sets the program counter to a value (usually the output of another jump), however only does so if the condition register is not zero
-		 * @param out register to store the address of the instruction that should be executed next.
-		 * @param a register storing a condition, zero indicates no jump while any other number indicates that a jump should occur
-		 * @param b register storing the address of the instruction to jump to.
+		 * Xor's two numbers
+		 * @param out register to store \p a ^ \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
 		 */
-		void* branch_to(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* bitwise_xor(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = (uint64_t)(pc + 1);
-			if(registers[pc->a])
-				pc = (opcode*)registers[pc->b] - 1;
+			auto dbg = registers[pc->out] = registers[pc->a] ^ registers[pc->b];
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(branch_to);
+		MIZU_REGISTER_INSTRUCTION(bitwise_xor);
 
 		/**
-		 * Checks if two registers are equal
+		 * And's two numbers
+		 * @param out register to store \p a & \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* bitwise_and(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] & registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(bitwise_and);
+
+		/**
+		 * Or's two numbers
+		 * @param out register to store \p a | \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* bitwise_or(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] | registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(bitwise_or);
+
+		/**
+		 * Chooses between two registers without branching
+		 * @param out register storing the condition, replaced with \p a if the condition is not zero or \p b otherwise
+		 * @param a register storing the value chosen when the condition is true
+		 * @param b register storing the value chosen when the condition is false
+		 * @note Pairs with the set_if_* instructions (e.g. set_if_less t0, x, y; select_if t0, x, y stores the smaller of x and y in t0)
+		 */
+		void* select_if(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->out] ? registers[pc->a] : registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(select_if);
+
+		/**
+		 * Finds the smaller of two numbers
+		 * @param out register to store the smaller of \p a and \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* min(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = std::min(registers[pc->a], registers[pc->b]);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(min);
+
+		/**
+		 * Finds the larger of two numbers
+		 * @param out register to store the larger of \p a and \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 */
+		void* max(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = std::max(registers[pc->a], registers[pc->b]);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(max);
+
+		/**
+		 * Finds the smaller of two numbers
+		 * @param out register to store the smaller of \p a and \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 * @note Both \p a and \p b are treated as being signed
+		 */
+		void* min_signed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = std::min(*(int64_t*)&registers[pc->a], *(int64_t*)&registers[pc->b]);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(min_signed);
+
+		/**
+		 * Finds the larger of two numbers
+		 * @param out register to store the larger of \p a and \p b in
+		 * @param a register storing first value
+		 * @param b register storing second value
+		 * @note Both \p a and \p b are treated as being signed
+		 */
+		void* max_signed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = std::max(*(int64_t*)&registers[pc->a], *(int64_t*)&registers[pc->b]);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(max_signed);
+
+		/**
+		 * Finds the absolute value of a signed number
+		 * @param out register to store |\p a| in
+		 * @param a register storing the value
+		 * @note The most negative number has no positive counterpart and is left unchanged
+		 */
+		void* abs_signed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] >> 63 ? 0 - registers[pc->a] : registers[pc->a];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(abs_signed);
+
+		/**
+		 * Checks if a register is equal to an immediate
 		 * @param out register to be set to one if \p a == \p b or zero otherwise
-		 * @param a register storing the first value to compare
-		 * @param b register storing the second value to compare
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 */
-		void* set_if_equal(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* set_if_equal_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = registers[pc->a] == registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = registers[pc->a] == immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(set_if_equal);
+		MIZU_REGISTER_INSTRUCTION(set_if_equal_immediate);
 
 		/**
-		 * Checks if two registers are not equal
+		 * Checks if a register is not equal to an immediate
 		 * @param out register to be set to one if \p a != \p b or zero otherwise
-		 * @param a register storing the first value to compare
-		 * @param b register storing the second value to compare
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 */
-		void* set_if_not_equal(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* set_if_not_equal_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = registers[pc->a] != registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = registers[pc->a] != immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(set_if_not_equal);
+		MIZU_REGISTER_INSTRUCTION(set_if_not_equal_immediate);
 
 		/**
-		 * Checks if a register is less than another
+		 * Checks if a register is less than an immediate
 		 * @param out register to be set to one if \p a < \p b or zero otherwise
-		 * @param a register storing the first value to compare
-		 * @param b register storing the second value to compare
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 */
-		void* set_if_less(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* set_if_less_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = registers[pc->a] < registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = registers[pc->a] < immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(set_if_less);
+		MIZU_REGISTER_INSTRUCTION(set_if_less_immediate);
 
 		/**
-		 * Checks if a register is less than another
-		 * @param out register to be set to one if \p a == \p b or zero otherwise
-		 * @param a register storing the first value to compare
-		 * @param b register storing the second value to compare
+		 * Checks if a register is less than an immediate
+		 * @param out register to be set to one if \p a < \p b or zero otherwise
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 * @note Both \p a and \p b are treated as being signed
 		 */
-		void* set_if_less_signed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* set_if_less_signed_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = *(int64_t*)&registers[pc->a] < *(int64_t*)&registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = *(int64_t*)&registers[pc->a] < *(int64_t*)&immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(set_if_less_signed);
+		MIZU_REGISTER_INSTRUCTION(set_if_less_signed_immediate);
 
 		/**
-		 * Checks if a register is greater or equal to another
+		 * Checks if a register is greater or equal to an immediate
 		 * @param out register to be set to one if \p a >= \p b or zero otherwise
-		 * @param a register storing the first value to compare
-		 * @param b register storing the second value to compare
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 */
-		void* set_if_greater_equal(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* set_if_greater_equal_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = registers[pc->a] >= registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = registers[pc->a] >= immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(set_if_greater_equal);
+		MIZU_REGISTER_INSTRUCTION(set_if_greater_equal_immediate);
 
 		/**
-		 * Checks if a register is greater or equal to another
+		 * Checks if a register is greater or equal to an immediate
 		 * @param out register to be set to one if \p a >= \p b or zero otherwise
-		 * @param a register storing the first value to compare
-		 * @param b register storing the second value to compare
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 * @note Both \p a and \p b are treated as being signed
 		 */
-		void* set_if_greater_equal_signed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* set_if_greater_equal_signed_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = *(int64_t*)&registers[pc->a] >= *(int64_t*)&registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = *(int64_t*)&registers[pc->a] >= *(int64_t*)&immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(set_if_greater_equal_signed);
+		MIZU_REGISTER_INSTRUCTION(set_if_greater_equal_signed_immediate);
 
 		/**
-		 * Adds two numbers
+		 * Adds an immediate to a number
 		 * @param out register to store \p a + \p b in
-		 * @param a register storing first value
-		 * @param b register storing second value
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 */
-		void* add(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* add_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = registers[pc->a] + registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = registers[pc->a] + immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(add);
+		MIZU_REGISTER_INSTRUCTION(add_immediate);
 
 		/**
-		 * Subtracts two numbers
+		 * Subtracts an immediate from a number
 		 * @param out register to store \p a - \p b in
-		 * @param a register storing first value
-		 * @param b register storing second value
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 */
-		void* subtract(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* subtract_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = registers[pc->a] - registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = registers[pc->a] - immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(subtract);
+		MIZU_REGISTER_INSTRUCTION(subtract_immediate);
 
 		/**
-		 * Multiplies two numbers
+		 * Multiplies a number by an immediate
 		 * @param out register to store \p a * \p b in
-		 * @param a register storing first value
-		 * @param b register storing second value
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 */
-		void* multiply(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* multiply_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = registers[pc->a] * registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = registers[pc->a] * immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(multiply);
+		MIZU_REGISTER_INSTRUCTION(multiply_immediate);
 
 		/**
-		 * Divides two numbers
+		 * Divides a number by an immediate
 		 * @param out register to store \p a / \p b in
-		 * @param a register storing first value
-		 * @param b register storing second value
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 */
-		void* divide(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* divide_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = registers[pc->a] / registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = registers[pc->a] / immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(divide);
+		MIZU_REGISTER_INSTRUCTION(divide_immediate);
 
 		/**
-		 * Finds the remainder of the division of two numbers
+		 * Finds the remainder of the division of a number by an immediate
 		 * @param out register to store \p a % \p b in
-		 * @param a register storing first value
-		 * @param b register storing second value
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 */
-		void* modulus(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* modulus_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = registers[pc->a] % registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = registers[pc->a] % immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(modulus);
+		MIZU_REGISTER_INSTRUCTION(modulus_immediate);
 
 		/**
-		 * Shifts one number left by another
+		 * Divides a signed number by an immediate (rounding towards zero)
+		 * @note Like mizu::divide_signed dividing the smallest signed number by -1 wraps around to the smallest signed number
+		 * @param out register to store \p a / \p b in
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
+		 */
+		void* divide_signed_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			int64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = detail::signed_quotient(registers[pc->a], immediate);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(divide_signed_immediate);
+
+		/**
+		 * Finds the remainder of the division of a signed number by an immediate (which has the same sign as \p a)
+		 * @note Like mizu::modulus_signed the remainder of dividing by -1 is always zero
+		 * @param out register to store \p a % \p b in
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
+		 */
+		void* modulus_signed_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			int64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = detail::signed_remainder(registers[pc->a], immediate);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(modulus_signed_immediate);
+
+		/**
+		 * Shifts a number left by an immediate
 		 * @param out register to store \p a << \p b in
-		 * @param a register storing first value
-		 * @param b register storing second value
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 */
-		void* shift_left(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* shift_left_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = registers[pc->a] << registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = registers[pc->a] << immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(shift_left);
+		MIZU_REGISTER_INSTRUCTION(shift_left_immediate);
 
 		/**
-		 * Shifts one number right by another
+		 * Shifts a number right by an immediate
 		 * @param out register to store \p a >> \p b in
-		 * @param a register storing first value
-		 * @param b register storing second value
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 */
-		void* shift_right_logical(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* shift_right_logical_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = registers[pc->a] >> registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = registers[pc->a] >> immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(shift_right_logical);
+		MIZU_REGISTER_INSTRUCTION(shift_right_logical_immediate);
 
 		/**
-		 * Shifts one number right by another, sign extending it
+		 * Shifts a number right by an immediate, sign extending it
 		 * @param out register to store \p a >> \p b in
-		 * @param a register storing first value
-		 * @param b register storing second value
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 */
-		void* shift_right_arithmetic(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* shift_right_arithmetic_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = *(int64_t*)&registers[pc->a] >> registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = *(int64_t*)&registers[pc->a] >> immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(shift_right_arithmetic);
+		MIZU_REGISTER_INSTRUCTION(shift_right_arithmetic_immediate);
 
 		/**
-		 * Xor's two numbers
+		 * Xor's a number with an immediate
 		 * @param out register to store \p a ^ \p b in
-		 * @param a register storing first value
-		 * @param b register storing second value
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 */
-		void* bitwise_xor(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* bitwise_xor_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = registers[pc->a] ^ registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = registers[pc->a] ^ immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(bitwise_xor);
+		MIZU_REGISTER_INSTRUCTION(bitwise_xor_immediate);
 
 		/**
-		 * And's two numbers
+		 * And's a number with an immediate
 		 * @param out register to store \p a & \p b in
-		 * @param a register storing first value
-		 * @param b register storing second value
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 */
-		void* bitwise_and(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* bitwise_and_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = registers[pc->a] & registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = registers[pc->a] & immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(bitwise_and);
+		MIZU_REGISTER_INSTRUCTION(bitwise_and_immediate);
 
 		/**
-		 * Or's two numbers
+		 * Or's a number with an immediate
 		 * @param out register to store \p a | \p b in
-		 * @param a register storing first value
-		 * @param b register storing second value
+		 * @param a register storing the first value
+		 * @param b (branch immediate) the second value (sign extended to 64 bits)
 		 */
-		void* bitwise_or(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+		void* bitwise_or_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION
 		{
-			auto dbg = registers[pc->out] = registers[pc->a] | registers[pc->b];
+			uint64_t immediate = *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = registers[pc->a] | immediate;
 			MIZU_NEXT();
 		}
 #else
 		;
 #endif
-		MIZU_REGISTER_INSTRUCTION(bitwise_or);
+		MIZU_REGISTER_INSTRUCTION(bitwise_or_immediate);
 	}}
 }
\ No newline at end of file
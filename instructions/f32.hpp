@@ -14,27 +14,83 @@ namespace mizu {
 
 	inline namespace instructions { extern "C" {
 
-// 		void* stack_load_f32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
-// #ifdef MIZU_IMPLEMENTATION
-// 		{
-// 			float_register<std::float32_t>(registers, pc->out) = *(std::float32_t*)(sp + registers[pc->a]);
-// 			MIZU_NEXT();
-// 		}
-// #else
-// 		;
-// #endif
-// 		MIZU_REGISTER_INSTRUCTION(stack_load_f32);
-
-// 		void* stack_store_f32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
-// #ifdef MIZU_IMPLEMENTATION
-// 		{
-// 			float_register<std::float32_t>(registers, pc->out) = *(std::float32_t*)(sp + registers[pc->a]) = (std::float32_t&)registers[pc->b];
-// 			MIZU_NEXT();
-// 		}
-// #else
-// 		;
-// #endif
-// 		MIZU_REGISTER_INSTRUCTION(stack_store_f32);
+		/**
+		 * Loads an f32 from the stack
+		 * @param out Register to store the result in
+		 * @param a Register storing an offset to the current stack pointer (defaults to zero bytes)
+		 */
+		void* stack_load_f32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			uint8_t* offset = sp + registers[pc->a];
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			float_register<std::float32_t>(registers, pc->out) = *(std::float32_t*)offset;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_load_f32);
+
+		/**
+		 * Copies an f32 from a register to the stack
+		 * @param out Register to store another copy in
+		 * @param a Register storing the value to copy
+		 * @param b Register storing an offset to the current stack pointer (defaults to zero bytes)
+		 */
+		void* stack_store_f32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			uint8_t* offset = sp + registers[pc->b];
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			float_register<std::float32_t>(registers, pc->out) = *(std::float32_t*)offset = float_register<std::float32_t>(registers, pc->a);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_store_f32);
+
+		/**
+		 * Loads an f32 from the stack at an immediate offset
+		 * @param out Register to store the result in
+		 * @param b (branch immediate) Offset to the current stack pointer in bytes
+		 */
+		void* stack_load_f32_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			uint8_t* offset = sp + *(int16_t*)&pc->b;
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			float_register<std::float32_t>(registers, pc->out) = *(std::float32_t*)offset;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_load_f32_immediate);
+
+		/**
+		 * Copies an f32 from a register to the stack at an immediate offset
+		 * @param out Register to store another copy in
+		 * @param a Register storing the value to copy
+		 * @param b (branch immediate) Offset to the current stack pointer in bytes
+		 */
+		void* stack_store_f32_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			uint8_t* offset = sp + *(int16_t*)&pc->b;
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			float_register<std::float32_t>(registers, pc->out) = *(std::float32_t*)offset = float_register<std::float32_t>(registers, pc->a);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(stack_store_f32_immediate);
 
 		/**
 		 * Converts the provided register into a float register
@@ -300,6 +356,86 @@ namespace mizu {
 #endif
 		MIZU_REGISTER_INSTRUCTION(set_if_greater_equal_f32);
 
+		/**
+		 * Moves the program counter by an offset if two f32 registers are equal (comparing and branching with a single instruction)
+		 * @param out (out branch immediate) how many instructions to jump
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+		 * @note Both \p a and \p b must be f32s. If they aren't they should be converted first
+		 */
+		void* branch_if_equal_f32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			if(float_register<std::float32_t>(registers, pc->a) == float_register<std::float32_t>(registers, pc->b))
+				pc += *(int16_t*)&pc->out - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(branch_if_equal_f32);
+
+		/**
+		 * Moves the program counter by an offset if two f32 registers are not equal (comparing and branching with a single instruction)
+		 * @param out (out branch immediate) how many instructions to jump
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+		 * @note Both \p a and \p b must be f32s. If they aren't they should be converted first
+		 */
+		void* branch_if_not_equal_f32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			if(float_register<std::float32_t>(registers, pc->a) != float_register<std::float32_t>(registers, pc->b))
+				pc += *(int16_t*)&pc->out - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(branch_if_not_equal_f32);
+
+		/**
+		 * Moves the program counter by an offset if one f32 register is less than another (comparing and branching with a single instruction)
+		 * @param out (out branch immediate) how many instructions to jump
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+		 * @note Both \p a and \p b must be f32s. If they aren't they should be converted first
+		 */
+		void* branch_if_less_f32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			if(float_register<std::float32_t>(registers, pc->a) < float_register<std::float32_t>(registers, pc->b))
+				pc += *(int16_t*)&pc->out - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(branch_if_less_f32);
+
+		/**
+		 * Moves the program counter by an offset if one f32 register is greater or equal to another (comparing and branching with a single instruction)
+		 * @param out (out branch immediate) how many instructions to jump
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+		 * @note Both \p a and \p b must be f32s. If they aren't they should be converted first
+		 */
+		void* branch_if_greater_equal_f32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			if(float_register<std::float32_t>(registers, pc->a) >= float_register<std::float32_t>(registers, pc->b))
+				pc += *(int16_t*)&pc->out - 1;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(branch_if_greater_equal_f32);
+
 
 		/**
 		 * Checks if a f32 register is negative
@@ -37,27 +37,83 @@ namespace mizu { inline namespace instructions { extern "C" {
 #endif
 	MIZU_REGISTER_INSTRUCTION(convert_f64_to_f32);
 
-// 	void* stack_load_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
-// #ifdef MIZU_IMPLEMENTATION
-// 	{
-// 		float_register<std::float32_t>(registers, pc->out) = *(std::float32_t*)(sp + registers[pc->a]);
-// 		MIZU_NEXT();
-// 	}
-// #else
-// 	;
-// #endif
-// 	MIZU_REGISTER_INSTRUCTION(stack_load_f64);
-
-// 	void* stack_store_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
-// #ifdef MIZU_IMPLEMENTATION
-// 	{
-// 		float_register<std::float32_t>(registers, pc->out) = *(std::float32_t*)(sp + registers[pc->a]) = (std::float32_t&)registers[pc->b];
-// 		MIZU_NEXT();
-// 	}
-// #else
-// 	;
-// #endif
-// 	MIZU_REGISTER_INSTRUCTION(stack_store_f64);
+	/**
+	 * Loads an f64 from the stack
+	 * @param out Register to store the result in
+	 * @param a Register storing an offset to the current stack pointer (defaults to zero bytes)
+	 */
+	void* stack_load_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+	{
+		uint8_t* offset = sp + registers[pc->a];
+		assert(offset > env->stack_boundary);
+		assert(offset <= env->stack_bottom);
+		float_register<std::float64_t>(registers, pc->out) = *(std::float64_t*)offset;
+		MIZU_NEXT();
+	}
+#else
+	;
+#endif
+	MIZU_REGISTER_INSTRUCTION(stack_load_f64);
+
+	/**
+	 * Copies an f64 from a register to the stack
+	 * @param out Register to store another copy in
+	 * @param a Register storing the value to copy
+	 * @param b Register storing an offset to the current stack pointer (defaults to zero bytes)
+	 */
+	void* stack_store_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+	{
+		uint8_t* offset = sp + registers[pc->b];
+		assert(offset > env->stack_boundary);
+		assert(offset <= env->stack_bottom);
+		float_register<std::float64_t>(registers, pc->out) = *(std::float64_t*)offset = float_register<std::float64_t>(registers, pc->a);
+		MIZU_NEXT();
+	}
+#else
+	;
+#endif
+	MIZU_REGISTER_INSTRUCTION(stack_store_f64);
+
+	/**
+	 * Loads an f64 from the stack at an immediate offset
+	 * @param out Register to store the result in
+	 * @param b (branch immediate) Offset to the current stack pointer in bytes
+	 */
+	void* stack_load_f64_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+	{
+		uint8_t* offset = sp + *(int16_t*)&pc->b;
+		assert(offset > env->stack_boundary);
+		assert(offset <= env->stack_bottom);
+		float_register<std::float64_t>(registers, pc->out) = *(std::float64_t*)offset;
+		MIZU_NEXT();
+	}
+#else
+	;
+#endif
+	MIZU_REGISTER_INSTRUCTION(stack_load_f64_immediate);
+
+	/**
+	 * Copies an f64 from a register to the stack at an immediate offset
+	 * @param out Register to store another copy in
+	 * @param a Register storing the value to copy
+	 * @param b (branch immediate) Offset to the current stack pointer in bytes
+	 */
+	void* stack_store_f64_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+	{
+		uint8_t* offset = sp + *(int16_t*)&pc->b;
+		assert(offset > env->stack_boundary);
+		assert(offset <= env->stack_bottom);
+		float_register<std::float64_t>(registers, pc->out) = *(std::float64_t*)offset = float_register<std::float64_t>(registers, pc->a);
+		MIZU_NEXT();
+	}
+#else
+	;
+#endif
+	MIZU_REGISTER_INSTRUCTION(stack_store_f64_immediate);
 
 	/**
 		* Converts the provided register into a float register
@@ -68,7 +124,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* convert_to_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		float_register<std::float32_t>(registers, pc->out) = registers[pc->a];
+		float_register<std::float64_t>(registers, pc->out) = registers[pc->a];
 		MIZU_NEXT();
 	}
 #else
@@ -85,7 +141,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* convert_signed_to_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		float_register<std::float32_t>(registers, pc->out) = (int64_t&)registers[pc->a];
+		float_register<std::float64_t>(registers, pc->out) = (int64_t&)registers[pc->a];
 		MIZU_NEXT();
 	}
 #else
@@ -102,7 +158,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* convert_from_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = registers[pc->out] = float_register<std::float32_t>(registers, pc->a);
+		auto dbg = registers[pc->out] = float_register<std::float64_t>(registers, pc->a);
 		MIZU_NEXT();
 	}
 #else
@@ -119,7 +175,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* convert_signed_from_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = (int64_t&)registers[pc->out] = float_register<std::float32_t>(registers, pc->a);
+		auto dbg = (int64_t&)registers[pc->out] = float_register<std::float64_t>(registers, pc->a);
 		MIZU_NEXT();
 	}
 #else
@@ -137,7 +193,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* add_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = float_register<std::float32_t>(registers, pc->out) = float_register<std::float32_t>(registers, pc->a) + float_register<std::float32_t>(registers, pc->b);
+		auto dbg = float_register<std::float64_t>(registers, pc->out) = float_register<std::float64_t>(registers, pc->a) + float_register<std::float64_t>(registers, pc->b);
 		MIZU_NEXT();
 	}
 #else
@@ -155,7 +211,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* subtract_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = float_register<std::float32_t>(registers, pc->out) = float_register<std::float32_t>(registers, pc->a) - float_register<std::float32_t>(registers, pc->b);
+		auto dbg = float_register<std::float64_t>(registers, pc->out) = float_register<std::float64_t>(registers, pc->a) - float_register<std::float64_t>(registers, pc->b);
 		MIZU_NEXT();
 	}
 #else
@@ -173,7 +229,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* multiply_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = float_register<std::float32_t>(registers, pc->out) = float_register<std::float32_t>(registers, pc->a) * float_register<std::float32_t>(registers, pc->b);
+		auto dbg = float_register<std::float64_t>(registers, pc->out) = float_register<std::float64_t>(registers, pc->a) * float_register<std::float64_t>(registers, pc->b);
 		MIZU_NEXT();
 	}
 #else
@@ -191,7 +247,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* divide_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = float_register<std::float32_t>(registers, pc->out) = float_register<std::float32_t>(registers, pc->a) / float_register<std::float32_t>(registers, pc->b);
+		auto dbg = float_register<std::float64_t>(registers, pc->out) = float_register<std::float64_t>(registers, pc->a) / float_register<std::float64_t>(registers, pc->b);
 		MIZU_NEXT();
 	}
 #else
@@ -209,7 +265,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* max_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = float_register<std::float32_t>(registers, pc->out) = std::max(float_register<std::float32_t>(registers, pc->a), float_register<std::float32_t>(registers, pc->b));
+		auto dbg = float_register<std::float64_t>(registers, pc->out) = std::max(float_register<std::float64_t>(registers, pc->a), float_register<std::float64_t>(registers, pc->b));
 		MIZU_NEXT();
 	}
 #else
@@ -227,7 +283,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* min_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
 #ifdef MIZU_IMPLEMENTATION 
 	{
-		auto dbg = float_register<std::float32_t>(registers, pc->out) = std::min(float_register<std::float32_t>(registers, pc->a), float_register<std::float32_t>(registers, pc->b));
+		auto dbg = float_register<std::float64_t>(registers, pc->out) = std::min(float_register<std::float64_t>(registers, pc->a), float_register<std::float64_t>(registers, pc->b));
 		MIZU_NEXT();
 	}
 #else
@@ -243,7 +299,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* sqrt_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = float_register<std::float32_t>(registers, pc->out) = std::sqrt(float_register<std::float32_t>(registers, pc->a));
+		auto dbg = float_register<std::float64_t>(registers, pc->out) = std::sqrt(float_register<std::float64_t>(registers, pc->a));
 		MIZU_NEXT();
 	}
 #else
@@ -261,7 +317,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* set_if_equal_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = registers[pc->out] = float_register<std::float32_t>(registers, pc->a) == float_register<std::float32_t>(registers, pc->b);
+		auto dbg = registers[pc->out] = float_register<std::float64_t>(registers, pc->a) == float_register<std::float64_t>(registers, pc->b);
 		MIZU_NEXT();
 	}
 #else
@@ -279,7 +335,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* set_if_not_equal_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = registers[pc->out] = float_register<std::float32_t>(registers, pc->a) != float_register<std::float32_t>(registers, pc->b);
+		auto dbg = registers[pc->out] = float_register<std::float64_t>(registers, pc->a) != float_register<std::float64_t>(registers, pc->b);
 		MIZU_NEXT();
 	}
 #else
@@ -297,7 +353,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* set_if_less_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = registers[pc->out] = float_register<std::float32_t>(registers, pc->a) < float_register<std::float32_t>(registers, pc->b);
+		auto dbg = registers[pc->out] = float_register<std::float64_t>(registers, pc->a) < float_register<std::float64_t>(registers, pc->b);
 		MIZU_NEXT();
 	}
 #else
@@ -315,7 +371,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* set_if_greater_equal_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = registers[pc->out] = float_register<std::float32_t>(registers, pc->a) >= float_register<std::float32_t>(registers, pc->b);
+		auto dbg = registers[pc->out] = float_register<std::float64_t>(registers, pc->a) >= float_register<std::float64_t>(registers, pc->b);
 		MIZU_NEXT();
 	}
 #else
@@ -323,6 +379,86 @@ namespace mizu { inline namespace instructions { extern "C" {
 #endif
 	MIZU_REGISTER_INSTRUCTION(set_if_greater_equal_f64);
 
+	/**
+	 * Moves the program counter by an offset if two f64 registers are equal (comparing and branching with a single instruction)
+	 * @param out (out branch immediate) how many instructions to jump
+	 * @param a register storing the first value to compare
+	 * @param b register storing the second value to compare
+	 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+	 * @note Both \p a and \p b must be f64s. If they aren't they should be converted first
+	 */
+	void* branch_if_equal_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+	{
+		if(float_register<std::float64_t>(registers, pc->a) == float_register<std::float64_t>(registers, pc->b))
+			pc += *(int16_t*)&pc->out - 1;
+		MIZU_NEXT();
+	}
+#else
+	;
+#endif
+	MIZU_REGISTER_INSTRUCTION(branch_if_equal_f64);
+
+	/**
+	 * Moves the program counter by an offset if two f64 registers are not equal (comparing and branching with a single instruction)
+	 * @param out (out branch immediate) how many instructions to jump
+	 * @param a register storing the first value to compare
+	 * @param b register storing the second value to compare
+	 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+	 * @note Both \p a and \p b must be f64s. If they aren't they should be converted first
+	 */
+	void* branch_if_not_equal_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+	{
+		if(float_register<std::float64_t>(registers, pc->a) != float_register<std::float64_t>(registers, pc->b))
+			pc += *(int16_t*)&pc->out - 1;
+		MIZU_NEXT();
+	}
+#else
+	;
+#endif
+	MIZU_REGISTER_INSTRUCTION(branch_if_not_equal_f64);
+
+	/**
+	 * Moves the program counter by an offset if one f64 register is less than another (comparing and branching with a single instruction)
+	 * @param out (out branch immediate) how many instructions to jump
+	 * @param a register storing the first value to compare
+	 * @param b register storing the second value to compare
+	 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+	 * @note Both \p a and \p b must be f64s. If they aren't they should be converted first
+	 */
+	void* branch_if_less_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+	{
+		if(float_register<std::float64_t>(registers, pc->a) < float_register<std::float64_t>(registers, pc->b))
+			pc += *(int16_t*)&pc->out - 1;
+		MIZU_NEXT();
+	}
+#else
+	;
+#endif
+	MIZU_REGISTER_INSTRUCTION(branch_if_less_f64);
+
+	/**
+	 * Moves the program counter by an offset if one f64 register is greater or equal to another (comparing and branching with a single instruction)
+	 * @param out (out branch immediate) how many instructions to jump
+	 * @param a register storing the first value to compare
+	 * @param b register storing the second value to compare
+	 * @note \p out is interpreted as a signed integer, allowing for negative jumps
+	 * @note Both \p a and \p b must be f64s. If they aren't they should be converted first
+	 */
+	void* branch_if_greater_equal_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+	{
+		if(float_register<std::float64_t>(registers, pc->a) >= float_register<std::float64_t>(registers, pc->b))
+			pc += *(int16_t*)&pc->out - 1;
+		MIZU_NEXT();
+	}
+#else
+	;
+#endif
+	MIZU_REGISTER_INSTRUCTION(branch_if_greater_equal_f64);
+
 
 	/**
 		* Checks if a f64 register is negative
@@ -332,7 +468,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* set_if_negative_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = registers[pc->out] = std::signbit(float_register<std::float32_t>(registers, pc->a));
+		auto dbg = registers[pc->out] = std::signbit(float_register<std::float64_t>(registers, pc->a));
 		MIZU_NEXT();
 	}
 #else
@@ -348,7 +484,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* set_if_positive_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = registers[pc->out] = !std::signbit(float_register<std::float32_t>(registers, pc->a));
+		auto dbg = registers[pc->out] = !std::signbit(float_register<std::float64_t>(registers, pc->a));
 		MIZU_NEXT();
 	}
 #else
@@ -364,7 +500,7 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* set_if_infinity_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = registers[pc->out] = std::isinf(float_register<std::float32_t>(registers, pc->a));
+		auto dbg = registers[pc->out] = std::isinf(float_register<std::float64_t>(registers, pc->a));
 		MIZU_NEXT();
 	}
 #else
@@ -380,11 +516,58 @@ namespace mizu { inline namespace instructions { extern "C" {
 	void* set_if_nan_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) 
 #ifdef MIZU_IMPLEMENTATION
 	{
-		auto dbg = registers[pc->out] = std::isnan(float_register<std::float32_t>(registers, pc->a));
+		auto dbg = registers[pc->out] = std::isnan(float_register<std::float64_t>(registers, pc->a));
 		MIZU_NEXT();
 	}
 #else
 	;
 #endif
 	MIZU_REGISTER_INSTRUCTION(set_if_nan_f64);
-}}}
\ No newline at end of file
+}}
+
+	namespace detail {
+		/**
+		 * Checks if an instruction compares two registers and then branches by the immediate stored in out (branch_if_equal, branch_if_less_f32, etc...)
+		 * @note Counted loops (loop_decrement_branch and loop_subtract_branch) also branch by the immediate stored in out, after updating their counter.
+		 */
+		inline bool is_compare_and_branch(instruction_t op) {
+			return op == loop_decrement_branch || op == loop_subtract_branch
+				|| op == branch_if_equal || op == branch_if_not_equal || op == branch_if_less || op == branch_if_less_signed
+				|| op == branch_if_greater_equal || op == branch_if_greater_equal_signed
+				|| op == branch_if_equal_f32 || op == branch_if_not_equal_f32 || op == branch_if_less_f32 || op == branch_if_greater_equal_f32
+				|| op == branch_if_equal_f64 || op == branch_if_not_equal_f64 || op == branch_if_less_f64 || op == branch_if_greater_equal_f64;
+		}
+
+		/**
+		 * Performs the comparison of a compare and branch instruction
+		 * @note The counter of counted loops is updated.
+		 *
+		 * @param pc the compare and branch opcode
+		 * @param registers the registers to compare
+		 * @return true if the branch should be taken
+		 */
+		inline bool compare_and_branch_taken(const opcode* pc, uint64_t* registers) {
+			instruction_t op = pc->op;
+			if(op == loop_decrement_branch) return --registers[pc->a] != 0;
+			if(op == loop_subtract_branch) return int64_t(registers[pc->a] -= registers[pc->b]) > 0;
+			auto a = registers[pc->a], b = registers[pc->b];
+			auto f32 = [&](reg_t r) { return float_register<std::float32_t>(registers, r); };
+			auto f64 = [&](reg_t r) { return float_register<std::float64_t>(registers, r); };
+			if(op == branch_if_equal) return a == b;
+			if(op == branch_if_not_equal) return a != b;
+			if(op == branch_if_less) return a < b;
+			if(op == branch_if_less_signed) return int64_t(a) < int64_t(b);
+			if(op == branch_if_greater_equal) return a >= b;
+			if(op == branch_if_greater_equal_signed) return int64_t(a) >= int64_t(b);
+			if(op == branch_if_equal_f32) return f32(pc->a) == f32(pc->b);
+			if(op == branch_if_not_equal_f32) return f32(pc->a) != f32(pc->b);
+			if(op == branch_if_less_f32) return f32(pc->a) < f32(pc->b);
+			if(op == branch_if_greater_equal_f32) return f32(pc->a) >= f32(pc->b);
+			if(op == branch_if_equal_f64) return f64(pc->a) == f64(pc->b);
+			if(op == branch_if_not_equal_f64) return f64(pc->a) != f64(pc->b);
+			if(op == branch_if_less_f64) return f64(pc->a) < f64(pc->b);
+			if(op == branch_if_greater_equal_f64) return f64(pc->a) >= f64(pc->b);
+			return false;
+		}
+	}
+}
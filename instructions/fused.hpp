@@ -0,0 +1,305 @@
+#pragma once
+
+#include "../mizu/opcode.hpp"
+
+namespace mizu {
+	namespace detail {
+		/**
+		 * Performs the branch_relative_immediate which was fused into the previous instruction
+		 *
+		 * @param branch the branch's opcode
+		 * @param registers the registers to branch with
+		 * @return opcode* the opcode before the next instruction to execute
+		 */
+		inline opcode* fused_branch_relative_immediate(opcode* branch, uint64_t* registers) {
+			registers[branch->out] = (uint64_t)(branch + 1);
+			if(registers[branch->a])
+				return branch + *(int16_t*)&branch->b - 1;
+			return branch;
+		}
+
+		/**
+		 * Performs the branch_to which was fused into the previous instruction
+		 *
+		 * @param branch the branch's opcode
+		 * @param registers the registers to branch with
+		 * @return opcode* the opcode before the next instruction to execute
+		 */
+		inline opcode* fused_branch_to(opcode* branch, uint64_t* registers) {
+			registers[branch->out] = (uint64_t)(branch + 1);
+			if(registers[branch->a])
+				return (opcode*)registers[branch->b] - 1;
+			return branch;
+		}
+	}
+
+	/**
+	 * Superinstructions which perform the work of two consecutive instructions with a single dispatch
+	 * @note These instructions are placed by mizu::optimize::fuse in place of the first instruction of the pair, reading their second half from the opcode that follows them.
+	 *	That opcode is left in place (so jumps to it still work) but is skipped when the pair is executed together.
+	 * @note Since they read the following opcode these instructions depend on the program counter, thus fused programs should be interpreted (single stepping and JIT compilation treat them as program counter dependent and fall back to the interpreter).
+	 */
+	namespace fused { inline namespace instructions { extern "C" {
+
+		/**
+		 * load_immediate followed by stack_load_u64
+		 * @param out register to store the immediate in
+		 * @param immediate the value to store in \p out
+		 * @note The next opcode provides the operands of the stack_load_u64
+		 */
+		void* load_immediate_stack_load_u64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			registers[pc->out] = *(uint32_t*)&pc->a;
+			registers[0] = 0;
+			++pc;
+			uint8_t* offset = (uint8_t*)(sp + registers[pc->a]);
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = *(uint64_t*)offset;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(load_immediate_stack_load_u64);
+
+		/**
+		 * load_immediate followed by stack_store_u64
+		 * @param out register to store the immediate in
+		 * @param immediate the value to store in \p out
+		 * @note The next opcode provides the operands of the stack_store_u64
+		 */
+		void* load_immediate_stack_store_u64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			registers[pc->out] = *(uint32_t*)&pc->a;
+			registers[0] = 0;
+			++pc;
+			uint8_t* offset = (uint8_t*)(sp + registers[pc->b]);
+			assert(offset > env->stack_boundary);
+			assert(offset <= env->stack_bottom);
+			auto dbg = registers[pc->out] = *(uint64_t*)offset = *(uint64_t*)&registers[pc->a];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(load_immediate_stack_store_u64);
+
+		/**
+		 * load_immediate followed by add
+		 * @param out register to store the immediate in
+		 * @param immediate the value to store in \p out
+		 * @note The next opcode provides the operands of the add
+		 */
+		void* load_immediate_add(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			registers[pc->out] = *(uint32_t*)&pc->a;
+			registers[0] = 0;
+			++pc;
+			auto dbg = registers[pc->out] = registers[pc->a] + registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(load_immediate_add);
+
+		/**
+		 * load_immediate followed by subtract
+		 * @param out register to store the immediate in
+		 * @param immediate the value to store in \p out
+		 * @note The next opcode provides the operands of the subtract
+		 */
+		void* load_immediate_subtract(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			registers[pc->out] = *(uint32_t*)&pc->a;
+			registers[0] = 0;
+			++pc;
+			auto dbg = registers[pc->out] = registers[pc->a] - registers[pc->b];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(load_immediate_subtract);
+
+		/**
+		 * set_if_equal followed by branch_relative_immediate
+		 * @param out register to be set to one if \p a == \p b or zero otherwise
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note The next opcode provides the operands of the branch_relative_immediate
+		 */
+		void* set_if_equal_branch_relative_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			registers[pc->out] = registers[pc->a] == registers[pc->b];
+			registers[0] = 0;
+			pc = detail::fused_branch_relative_immediate(pc + 1, registers);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(set_if_equal_branch_relative_immediate);
+
+		/**
+		 * set_if_not_equal followed by branch_relative_immediate
+		 * @param out register to be set to one if \p a != \p b or zero otherwise
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note The next opcode provides the operands of the branch_relative_immediate
+		 */
+		void* set_if_not_equal_branch_relative_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			registers[pc->out] = registers[pc->a] != registers[pc->b];
+			registers[0] = 0;
+			pc = detail::fused_branch_relative_immediate(pc + 1, registers);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(set_if_not_equal_branch_relative_immediate);
+
+		/**
+		 * set_if_less followed by branch_relative_immediate
+		 * @param out register to be set to one if \p a < \p b or zero otherwise
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note The next opcode provides the operands of the branch_relative_immediate
+		 */
+		void* set_if_less_branch_relative_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			registers[pc->out] = registers[pc->a] < registers[pc->b];
+			registers[0] = 0;
+			pc = detail::fused_branch_relative_immediate(pc + 1, registers);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(set_if_less_branch_relative_immediate);
+
+		/**
+		 * set_if_greater_equal followed by branch_relative_immediate
+		 * @param out register to be set to one if \p a >= \p b or zero otherwise
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note The next opcode provides the operands of the branch_relative_immediate
+		 */
+		void* set_if_greater_equal_branch_relative_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			registers[pc->out] = registers[pc->a] >= registers[pc->b];
+			registers[0] = 0;
+			pc = detail::fused_branch_relative_immediate(pc + 1, registers);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(set_if_greater_equal_branch_relative_immediate);
+
+		/**
+		 * set_if_equal followed by branch_to
+		 * @param out register to be set to one if \p a == \p b or zero otherwise
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note The next opcode provides the operands of the branch_to
+		 */
+		void* set_if_equal_branch_to(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			registers[pc->out] = registers[pc->a] == registers[pc->b];
+			registers[0] = 0;
+			pc = detail::fused_branch_to(pc + 1, registers);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(set_if_equal_branch_to);
+
+		/**
+		 * set_if_not_equal followed by branch_to
+		 * @param out register to be set to one if \p a != \p b or zero otherwise
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note The next opcode provides the operands of the branch_to
+		 */
+		void* set_if_not_equal_branch_to(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			registers[pc->out] = registers[pc->a] != registers[pc->b];
+			registers[0] = 0;
+			pc = detail::fused_branch_to(pc + 1, registers);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(set_if_not_equal_branch_to);
+
+		/**
+		 * set_if_less followed by branch_to
+		 * @param out register to be set to one if \p a < \p b or zero otherwise
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note The next opcode provides the operands of the branch_to
+		 */
+		void* set_if_less_branch_to(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			registers[pc->out] = registers[pc->a] < registers[pc->b];
+			registers[0] = 0;
+			pc = detail::fused_branch_to(pc + 1, registers);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(set_if_less_branch_to);
+
+		/**
+		 * set_if_greater_equal followed by branch_to
+		 * @param out register to be set to one if \p a >= \p b or zero otherwise
+		 * @param a register storing the first value to compare
+		 * @param b register storing the second value to compare
+		 * @note The next opcode provides the operands of the branch_to
+		 */
+		void* set_if_greater_equal_branch_to(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			registers[pc->out] = registers[pc->a] >= registers[pc->b];
+			registers[0] = 0;
+			pc = detail::fused_branch_to(pc + 1, registers);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(set_if_greater_equal_branch_to);
+
+	}}}
+
+	// Register all the fused functions with the lookup system
+	MIZU_REGISTER_INSTRUCTION(fused::load_immediate_stack_load_u64);
+	MIZU_REGISTER_INSTRUCTION(fused::load_immediate_stack_store_u64);
+	MIZU_REGISTER_INSTRUCTION(fused::load_immediate_add);
+	MIZU_REGISTER_INSTRUCTION(fused::load_immediate_subtract);
+	MIZU_REGISTER_INSTRUCTION(fused::set_if_equal_branch_relative_immediate);
+	MIZU_REGISTER_INSTRUCTION(fused::set_if_not_equal_branch_relative_immediate);
+	MIZU_REGISTER_INSTRUCTION(fused::set_if_less_branch_relative_immediate);
+	MIZU_REGISTER_INSTRUCTION(fused::set_if_greater_equal_branch_relative_immediate);
+	MIZU_REGISTER_INSTRUCTION(fused::set_if_equal_branch_to);
+	MIZU_REGISTER_INSTRUCTION(fused::set_if_not_equal_branch_to);
+	MIZU_REGISTER_INSTRUCTION(fused::set_if_less_branch_to);
+	MIZU_REGISTER_INSTRUCTION(fused::set_if_greater_equal_branch_to);
+}
@@ -0,0 +1,323 @@
+#pragma once
+
+#include "../mizu/opcode.hpp"
+#include "f32.hpp"
+
+namespace mizu {
+	namespace detail {
+		/**
+		 * Where an environment running under mizu::interleave::execute stopped when it gave up the host thread
+		 */
+		struct interleave_state {
+			bool active = false; // Weather or not the current thread is running an interleaved executor
+			bool yielded = false; // Weather or not the last environment to run stopped at a yield (rather than halting)
+			bool resumed = false; // Weather or not the environment being run is resuming from the yield point it stopped at (so that yield point shouldn't yield again)
+			opcode* pc = nullptr; // The instruction the environment should resume from (the yield point itself)
+			uint8_t* sp = nullptr; // The environment's stack pointer when it yielded
+		};
+		inline thread_local interleave_state interleave_state_for_thread = {};
+
+		/**
+		 * Decides weather the yield point being executed should switch to the next environment
+		 * @note When interleaved, each yield point yields the first time it is reached and then lets the environment continue once it resumes (from the yield point)
+		 * @return bool true if the yield point should call interleave_yield
+		 */
+		inline bool interleave_should_yield() {
+#ifndef MIZU_NO_HARDWARE_THREADS
+			auto& state = interleave_state_for_thread;
+			if(!state.active) return false;
+			if(state.resumed) {
+				state.resumed = false;
+				return false;
+			}
+			return true;
+#else
+			return false;
+#endif
+		}
+
+		/**
+		 * Records that execution should resume from \p pc
+		 * @return void* nullptr (stopping execution so that the executor can move on to the next environment)
+		 */
+		inline void* interleave_yield(opcode* pc, uint8_t* sp) {
+			auto& state = interleave_state_for_thread;
+			state.yielded = true;
+			state.pc = pc;
+			state.sp = sp;
+			return nullptr;
+		}
+
+		/**
+		 * Address a yielding load (like \ref interleave::yielding_load_u64) loads from
+		 */
+		inline const uint8_t* interleave_load_address(opcode* pc, uint64_t* registers) {
+			return (const uint8_t*)registers[pc->a] + *(int16_t*)&pc->b;
+		}
+	}
+
+	/**
+	 * Instructions marking the points where an interleaved executor (mizu::interleave::execute) may switch to another environment
+	 * @note When the current thread isn't running an interleaved executor (or threads are emulated with coroutines) these instructions never yield.
+	 * @note The loads in this namespace behave like their \ref unsafe counterparts, except that (when interleaved) they start fetching their address and switch to the next environment before loading
+	 */
+	namespace interleave { inline namespace instructions { extern "C" {
+
+		/**
+		 * Starts fetching the memory pointed to by a register into the cache, and then (when interleaved) switches to the next environment,
+		 *	so that the fetch overlaps with the other environments' work instead of stalling the thread
+		 * @note Should be placed right before a load through the pointer which doesn't have a yielding variant (like a \ref unsafe::copy_memory)
+		 *
+		 * @param a Register storing a pointer to the memory which is about to be loaded
+		 */
+		void* prefetch_and_yield(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			if(detail::interleave_should_yield()) {
+				__builtin_prefetch((void*)registers[pc->a]);
+				return detail::interleave_yield(pc, sp);
+			}
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(prefetch_and_yield);
+
+		/**
+		 * Switches to the next environment (when interleaved)
+		 * @note Can be placed in long running loops which don't load through pointers so that they don't starve the other environments
+		 */
+		void* yield_execution(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			if(detail::interleave_should_yield())
+				return detail::interleave_yield(pc, sp);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(yield_execution);
+
+		/**
+		 * Loads a 64 bit integer from host memory, first (when interleaved) starting to fetch it and switching to the next environment
+		 *
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* yielding_load_u64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = detail::interleave_load_address(pc, registers);
+			if(detail::interleave_should_yield()) {
+				__builtin_prefetch(address);
+				return detail::interleave_yield(pc, sp);
+			}
+			auto dbg = registers[pc->out] = *(uint64_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(yielding_load_u64);
+
+		/**
+		 * Loads a 32 bit integer from host memory, first (when interleaved) starting to fetch it and switching to the next environment
+		 *
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* yielding_load_u32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = detail::interleave_load_address(pc, registers);
+			if(detail::interleave_should_yield()) {
+				__builtin_prefetch(address);
+				return detail::interleave_yield(pc, sp);
+			}
+			auto dbg = registers[pc->out] = *(uint32_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(yielding_load_u32);
+
+		/**
+		 * Loads a 16 bit integer from host memory, first (when interleaved) starting to fetch it and switching to the next environment
+		 *
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* yielding_load_u16(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = detail::interleave_load_address(pc, registers);
+			if(detail::interleave_should_yield()) {
+				__builtin_prefetch(address);
+				return detail::interleave_yield(pc, sp);
+			}
+			auto dbg = registers[pc->out] = *(uint16_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(yielding_load_u16);
+
+		/**
+		 * Loads an 8 bit integer from host memory, first (when interleaved) starting to fetch it and switching to the next environment
+		 *
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* yielding_load_u8(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = detail::interleave_load_address(pc, registers);
+			if(detail::interleave_should_yield()) {
+				__builtin_prefetch(address);
+				return detail::interleave_yield(pc, sp);
+			}
+			auto dbg = registers[pc->out] = *(uint8_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(yielding_load_u8);
+
+		/**
+		 * Loads a 32 bit integer (sign extending it) from host memory, first (when interleaved) starting to fetch it and switching to the next environment
+		 *
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* yielding_load_i32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = detail::interleave_load_address(pc, registers);
+			if(detail::interleave_should_yield()) {
+				__builtin_prefetch(address);
+				return detail::interleave_yield(pc, sp);
+			}
+			auto dbg = registers[pc->out] = *(int32_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(yielding_load_i32);
+
+		/**
+		 * Loads a 16 bit integer (sign extending it) from host memory, first (when interleaved) starting to fetch it and switching to the next environment
+		 *
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* yielding_load_i16(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = detail::interleave_load_address(pc, registers);
+			if(detail::interleave_should_yield()) {
+				__builtin_prefetch(address);
+				return detail::interleave_yield(pc, sp);
+			}
+			auto dbg = registers[pc->out] = *(int16_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(yielding_load_i16);
+
+		/**
+		 * Loads an 8 bit integer (sign extending it) from host memory, first (when interleaved) starting to fetch it and switching to the next environment
+		 *
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* yielding_load_i8(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = detail::interleave_load_address(pc, registers);
+			if(detail::interleave_should_yield()) {
+				__builtin_prefetch(address);
+				return detail::interleave_yield(pc, sp);
+			}
+			auto dbg = registers[pc->out] = *(int8_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(yielding_load_i8);
+
+		/**
+		 * Loads an f32 from host memory, first (when interleaved) starting to fetch it and switching to the next environment
+		 *
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* yielding_load_f32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = detail::interleave_load_address(pc, registers);
+			if(detail::interleave_should_yield()) {
+				__builtin_prefetch(address);
+				return detail::interleave_yield(pc, sp);
+			}
+			float_register<std::float32_t>(registers, pc->out) = *(std::float32_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(yielding_load_f32);
+
+		/**
+		 * Loads an f64 from host memory, first (when interleaved) starting to fetch it and switching to the next environment
+		 *
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* yielding_load_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = detail::interleave_load_address(pc, registers);
+			if(detail::interleave_should_yield()) {
+				__builtin_prefetch(address);
+				return detail::interleave_yield(pc, sp);
+			}
+			float_register<std::float64_t>(registers, pc->out) = *(std::float64_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(yielding_load_f64);
+	}}}
+
+	// Register all the interleave functions with the lookup system
+	MIZU_REGISTER_INSTRUCTION(interleave::prefetch_and_yield);
+	MIZU_REGISTER_INSTRUCTION(interleave::yield_execution);
+	MIZU_REGISTER_INSTRUCTION(interleave::yielding_load_u64);
+	MIZU_REGISTER_INSTRUCTION(interleave::yielding_load_u32);
+	MIZU_REGISTER_INSTRUCTION(interleave::yielding_load_u16);
+	MIZU_REGISTER_INSTRUCTION(interleave::yielding_load_u8);
+	MIZU_REGISTER_INSTRUCTION(interleave::yielding_load_i32);
+	MIZU_REGISTER_INSTRUCTION(interleave::yielding_load_i16);
+	MIZU_REGISTER_INSTRUCTION(interleave::yielding_load_i8);
+	MIZU_REGISTER_INSTRUCTION(interleave::yielding_load_f32);
+	MIZU_REGISTER_INSTRUCTION(interleave::yielding_load_f64);
+}
@@ -14,6 +14,11 @@
 #include <optional>
 #include <string_view>
 #include <unordered_map>
+#ifdef MIZU_COMPACT_OPCODES
+	#include <cassert>
+	#include <limits>
+	#include <vector>
+#endif
 #include <fp/string.h>
 
 
@@ -36,6 +41,13 @@ namespace mizu {
 		#endif
 		std::unordered_map<id_t, std::pair<std::string_view, mizu::instruction_t>> lookup;
 
+#ifdef MIZU_COMPACT_OPCODES
+		#ifndef MIZU_IMPLEMENTATION
+		extern
+		#endif
+		std::vector<mizu::instruction_t> handler_table;
+#endif
+
 
 		inline id_t register_instruction(std::string_view name, mizu::instruction_t ptr) {
 			static id_t counter = 0;
@@ -44,6 +56,11 @@ namespace mizu {
 			reverse_name_lookup[name] = id;
 			reverse_function_lookup[ptr] = id;
 			lookup[id] = {name, ptr};
+#ifdef MIZU_COMPACT_OPCODES
+			assert(id <= std::numeric_limits<uint16_t>::max()); // Compact opcodes can only index 2^16 instructions
+			if(handler_table.size() <= id) handler_table.resize(id + 1);
+			handler_table[id] = ptr;
+#endif
 			return id;
 		}
 	}
@@ -151,6 +168,7 @@ namespace mizu {
 	 * Releases all of the lookup tables used lookup instructions
 	 * @note After lookup is no longer needed (say if the program has been loaded from disk and does not need to be written to disk again)
 	 * 	this function can be called to free up memory in constrained scenarios.
+	 * @note When MIZU_COMPACT_OPCODES is defined the handler table is kept (it is needed to execute programs), however new opcodes can no longer be created.
 	 */
 	inline void release_lookup_data() {
 		detail::reverse_name_lookup.clear();
@@ -158,6 +176,14 @@ namespace mizu {
 		detail::lookup.clear();
 	}
 /** @}*/
+
+#ifdef MIZU_COMPACT_OPCODES
+	inline instruction_index::instruction_index(instruction_t ptr) {
+		auto found = lookup_id(ptr);
+		assert(found.has_value()); // Instructions must be registered before they can be stored in a compact opcode!
+		id = found.value_or(0);
+	}
+#endif
 }
 
 #endif // MIZU_INSTRUCTIONS_LOOKUP_IS_AVAILABLE
\ No newline at end of file
@@ -18,10 +18,11 @@ namespace mizu {
 #ifndef MIZU_NO_HARDWARE_THREADS
 		registers_and_stack new_env;
 		std::copy(env->memory.begin(), env->memory.end(), new_env.memory.begin());
+		new_env.constants = env->constants;
 
 		return (uint64_t)new std::thread([pc, env = std::move(new_env)]() mutable {
 			setup_environment(env);
-			return pc->op(pc, env.memory.data(), &env, env.stack_bottom);
+			return execute(pc, env.memory.data(), &env, env.stack_bottom);
 		});
 #else // MIZU_NO_HARDWARE_THREADS
 		auto new_env = (registers_and_stack*)malloc(sizeof(registers_and_stack));
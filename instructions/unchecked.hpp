@@ -0,0 +1,320 @@
+#pragma once
+
+#include "../mizu/opcode.hpp"
+
+namespace mizu {
+	// Versions of core instructions with their runtime checks removed
+	// NOTE: These instructions don't reset x0 (so out must never be x0) and the stack instructions don't check that they stay within the stack.
+	//	mizu::optimize::remove_checks swaps them in for the instructions mizu::verify can prove are safe.
+	inline namespace instructions { extern "C" {
+
+		/**
+		 * Version of mizu::load_immediate which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_load_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = *(uint32_t*)&pc->a;
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_load_immediate);
+
+		/**
+		 * Version of mizu::convert_to_u64 which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_convert_to_u64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_convert_to_u64);
+
+		/**
+		 * Version of mizu::add which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_add(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] + registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_add);
+
+		/**
+		 * Version of mizu::subtract which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_subtract(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] - registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_subtract);
+
+		/**
+		 * Version of mizu::multiply which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_multiply(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] * registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_multiply);
+
+		/**
+		 * Version of mizu::divide which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_divide(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] / registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_divide);
+
+		/**
+		 * Version of mizu::modulus which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_modulus(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] % registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_modulus);
+
+		/**
+		 * Version of mizu::shift_left which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_shift_left(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] << registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_shift_left);
+
+		/**
+		 * Version of mizu::shift_right_logical which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_shift_right_logical(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] >> registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_shift_right_logical);
+
+		/**
+		 * Version of mizu::shift_right_arithmetic which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_shift_right_arithmetic(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = *(int64_t*)&registers[pc->a] >> registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_shift_right_arithmetic);
+
+		/**
+		 * Version of mizu::bitwise_xor which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_bitwise_xor(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] ^ registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_bitwise_xor);
+
+		/**
+		 * Version of mizu::bitwise_and which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_bitwise_and(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] & registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_bitwise_and);
+
+		/**
+		 * Version of mizu::bitwise_or which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_bitwise_or(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] | registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_bitwise_or);
+
+		/**
+		 * Version of mizu::set_if_equal which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_set_if_equal(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] == registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_set_if_equal);
+
+		/**
+		 * Version of mizu::set_if_not_equal which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_set_if_not_equal(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] != registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_set_if_not_equal);
+
+		/**
+		 * Version of mizu::set_if_less which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_set_if_less(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] < registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_set_if_less);
+
+		/**
+		 * Version of mizu::set_if_less_signed which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_set_if_less_signed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = *(int64_t*)&registers[pc->a] < *(int64_t*)&registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_set_if_less_signed);
+
+		/**
+		 * Version of mizu::set_if_greater_equal which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_set_if_greater_equal(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = registers[pc->a] >= registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_set_if_greater_equal);
+
+		/**
+		 * Version of mizu::set_if_greater_equal_signed which doesn't reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_set_if_greater_equal_signed(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = *(int64_t*)&registers[pc->a] >= *(int64_t*)&registers[pc->b];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_set_if_greater_equal_signed);
+
+		/**
+		 * Version of mizu::stack_load_u64 which doesn't check the stack bounds or reset x0 (\p out must not be x0)
+		 */
+		void* unchecked_stack_load_u64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto dbg = registers[pc->out] = *(uint64_t*)(sp + registers[pc->a]);
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_stack_load_u64);
+
+		/**
+		 * Version of mizu::stack_store_u64 which doesn't check the stack bounds
+		 * @note Unlike mizu::stack_store_u64 the stored value is not copied into \p out (which should be x0)
+		 */
+		void* unchecked_stack_store_u64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			*(uint64_t*)(sp + registers[pc->b]) = registers[pc->a];
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_stack_store_u64);
+
+		/**
+		 * Version of mizu::stack_pop_immediate which doesn't check the stack bounds
+		 */
+		void* unchecked_stack_pop_immediate(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			sp += *(uint32_t*)&pc->a;
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION(unchecked_stack_pop_immediate);
+	}}
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../mizu/opcode.hpp"
+#include "f32.hpp"
 #include <fp/pointer.h>
 
 namespace mizu {
@@ -218,6 +219,291 @@ namespace mizu {
 		;
 #endif
 		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(set_memory_immediate);
+
+		/**
+		 * Loads a 64 bit integer from host memory
+		 * 
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* load_u64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = (uint8_t*)registers[pc->a] + *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = *(uint64_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(load_u64);
+
+		/**
+		 * Loads a 32 bit integer from host memory
+		 * 
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* load_u32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = (uint8_t*)registers[pc->a] + *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = *(uint32_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(load_u32);
+
+		/**
+		 * Loads a 16 bit integer from host memory
+		 * 
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* load_u16(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = (uint8_t*)registers[pc->a] + *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = *(uint16_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(load_u16);
+
+		/**
+		 * Loads an 8 bit integer from host memory
+		 * 
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* load_u8(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = (uint8_t*)registers[pc->a] + *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = *(uint8_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(load_u8);
+
+		/**
+		 * Loads a 32 bit integer (sign extending it) from host memory
+		 * 
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* load_i32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = (uint8_t*)registers[pc->a] + *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = *(int32_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(load_i32);
+
+		/**
+		 * Loads a 16 bit integer (sign extending it) from host memory
+		 * 
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* load_i16(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = (uint8_t*)registers[pc->a] + *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = *(int16_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(load_i16);
+
+		/**
+		 * Loads an 8 bit integer (sign extending it) from host memory
+		 * 
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* load_i8(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = (uint8_t*)registers[pc->a] + *(int16_t*)&pc->b;
+			auto dbg = registers[pc->out] = *(int8_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(load_i8);
+
+		/**
+		 * Loads an f32 from host memory
+		 * 
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* load_f32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = (uint8_t*)registers[pc->a] + *(int16_t*)&pc->b;
+			float_register<std::float32_t>(registers, pc->out) = *(std::float32_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(load_f32);
+
+		/**
+		 * Loads an f64 from host memory
+		 * 
+		 * @param out Register to store the result in
+		 * @param a Register storing a pointer to load from
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* load_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = (uint8_t*)registers[pc->a] + *(int16_t*)&pc->b;
+			float_register<std::float64_t>(registers, pc->out) = *(std::float64_t*)address;
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(load_f64);
+
+		/**
+		 * Stores a 64 bit integer from a register in host memory
+		 * 
+		 * @param out Register storing a pointer to store to
+		 * @param a Register storing the value to store
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* store_u64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = (uint8_t*)registers[pc->out] + *(int16_t*)&pc->b;
+			*(uint64_t*)address = registers[pc->a];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(store_u64);
+
+		/**
+		 * Stores a 32 bit integer from a register in host memory
+		 * 
+		 * @param out Register storing a pointer to store to
+		 * @param a Register storing the value to store
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* store_u32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = (uint8_t*)registers[pc->out] + *(int16_t*)&pc->b;
+			*(uint32_t*)address = registers[pc->a];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(store_u32);
+
+		/**
+		 * Stores a 16 bit integer from a register in host memory
+		 * 
+		 * @param out Register storing a pointer to store to
+		 * @param a Register storing the value to store
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* store_u16(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = (uint8_t*)registers[pc->out] + *(int16_t*)&pc->b;
+			*(uint16_t*)address = registers[pc->a];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(store_u16);
+
+		/**
+		 * Stores an 8 bit integer from a register in host memory
+		 * 
+		 * @param out Register storing a pointer to store to
+		 * @param a Register storing the value to store
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* store_u8(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = (uint8_t*)registers[pc->out] + *(int16_t*)&pc->b;
+			*(uint8_t*)address = registers[pc->a];
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(store_u8);
+
+		/**
+		 * Stores an f32 from a register in host memory
+		 * 
+		 * @param out Register storing a pointer to store to
+		 * @param a Register storing the value to store
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* store_f32(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = (uint8_t*)registers[pc->out] + *(int16_t*)&pc->b;
+			*(std::float32_t*)address = float_register<std::float32_t>(registers, pc->a);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(store_f32);
+
+		/**
+		 * Stores an f64 from a register in host memory
+		 * 
+		 * @param out Register storing a pointer to store to
+		 * @param a Register storing the value to store
+		 * @param b (branch immediate) Offset to add to the pointer in bytes
+		 */
+		void* store_f64(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+		{
+			auto address = (uint8_t*)registers[pc->out] + *(int16_t*)&pc->b;
+			*(std::float64_t*)address = float_register<std::float64_t>(registers, pc->a);
+			MIZU_NEXT();
+		}
+#else
+		;
+#endif
+		MIZU_REGISTER_INSTRUCTION_PROTOTYPE(store_f64);
 	}}}
 
 	// Register all the unsafe functions with the lookup system
@@ -232,4 +518,19 @@ namespace mizu {
 	MIZU_REGISTER_INSTRUCTION(unsafe::copy_memory_immediate);
 	MIZU_REGISTER_INSTRUCTION(unsafe::set_memory);
 	MIZU_REGISTER_INSTRUCTION(unsafe::set_memory_immediate);
+	MIZU_REGISTER_INSTRUCTION(unsafe::load_u64);
+	MIZU_REGISTER_INSTRUCTION(unsafe::load_u32);
+	MIZU_REGISTER_INSTRUCTION(unsafe::load_u16);
+	MIZU_REGISTER_INSTRUCTION(unsafe::load_u8);
+	MIZU_REGISTER_INSTRUCTION(unsafe::load_i32);
+	MIZU_REGISTER_INSTRUCTION(unsafe::load_i16);
+	MIZU_REGISTER_INSTRUCTION(unsafe::load_i8);
+	MIZU_REGISTER_INSTRUCTION(unsafe::load_f32);
+	MIZU_REGISTER_INSTRUCTION(unsafe::load_f64);
+	MIZU_REGISTER_INSTRUCTION(unsafe::store_u64);
+	MIZU_REGISTER_INSTRUCTION(unsafe::store_u32);
+	MIZU_REGISTER_INSTRUCTION(unsafe::store_u16);
+	MIZU_REGISTER_INSTRUCTION(unsafe::store_u8);
+	MIZU_REGISTER_INSTRUCTION(unsafe::store_f32);
+	MIZU_REGISTER_INSTRUCTION(unsafe::store_f64);
 }
\ No newline at end of file
@@ -0,0 +1,348 @@
+#pragma once
+
+#include "portable_format.hpp"
+#include "step.hpp"
+#include "../instructions/debug.hpp"
+#include "../instructions/unsafe.hpp"
+#include "../instructions/bits.hpp"
+#include "../instructions/bigint.hpp"
+
+#include <set>
+#include <string>
+
+namespace mizu::detail {
+	/**
+	 * Set of instructions which let a program access its registers through pointers (preventing registers from being kept in local variables)
+	 * @note Custom instructions which take the address of a register should be added to this set before programs using them are ahead of time compiled.
+	 */
+	inline std::unordered_set<instruction_t>& register_aliasing_instructions() {
+		static std::unordered_set<instruction_t> set = { unsafe::pointer_to_register };
+		return set;
+	}
+}
+
+namespace mizu { inline namespace portable {
+
+	/**
+	 * @brief Generates a C++ file which runs the provided Mizu \p program ahead of time compiled into a native function
+	 * @note Every basic block becomes a labeled region and jumps become gotos (jumps to computed addresses go through a switch over every label and return address),
+	 *	instructions which the generator doesn't understand are called on a copy of their opcode and instructions which need the program counter fall back to the interpreter.
+	 * @note Unless the program contains instructions which take pointers to registers, every register the program's own instructions reference is kept in a local variable
+	 *	(these are written back to the register file before calling out to an instruction and reloaded afterwards).
+	 * @note find_label instructions are resolved during generation, searching the whole program.
+	 * @note Instruction names are found through the lookup system, so this header must be included before mizu/instructions.hpp (and any custom instruction headers) in the implementation file.
+	 *	Otherwise the instructions don't register themselves and generation asserts when it can't find their names.
+	 *
+	 * @param program The program to generate a source file for.
+	 * @param env The enviornment the program should begin executing in.
+	 * @param extra_includes If the program requires extra instruction headers (like SIMD or custom) they should be listed (one per line, including the #include) here
+	 * @return fp::string a string storing the resulting source file.
+	 */
+	inline fp::string generate_aot_source_file(fp::view<const opcode> program, registers_and_stack& env, fp::string_view extra_includes = fp::string_view::from_cstr("")) {
+		const auto n = program.size();
+		auto index_of = [&](const opcode* pc) { return size_t(pc - program.data()); };
+		auto in_program = [&](size_t i, int64_t offset) { return int64_t(i) + offset >= 0 && int64_t(i) + offset < int64_t(n); };
+		auto immediate = [](const opcode& op) { return *(uint32_t*)&op.a; };
+		auto is_jump = [](instruction_t op) {
+			return op == jump_relative || op == jump_relative_immediate || op == jump_to || op == call_to || op == return_to
+				|| op == branch_relative || op == branch_relative_immediate || op == branch_to;
+		};
+		auto is_stack_immediate = [](instruction_t op) {
+			return op == stack_load_u64_immediate || op == stack_load_u32_immediate || op == stack_load_u16_immediate || op == stack_load_u8_immediate
+				|| op == stack_load_i32_immediate || op == stack_load_i16_immediate || op == stack_load_i8_immediate
+				|| op == stack_store_u64_immediate || op == stack_store_u32_immediate || op == stack_store_u16_immediate || op == stack_store_u8_immediate;
+		};
+		auto is_host_load = [](instruction_t op) {
+			return op == unsafe::load_u64 || op == unsafe::load_u32 || op == unsafe::load_u16 || op == unsafe::load_u8
+				|| op == unsafe::load_i32 || op == unsafe::load_i16 || op == unsafe::load_i8 || op == unsafe::load_f32 || op == unsafe::load_f64;
+		};
+		auto is_host_store = [](instruction_t op) {
+			return op == unsafe::store_u64 || op == unsafe::store_u32 || op == unsafe::store_u16 || op == unsafe::store_u8 || op == unsafe::store_f32 || op == unsafe::store_f64;
+		};
+		auto is_native = [&](instruction_t op) {
+			return is_jump(op) || op == label || op == debug::breakpoint || op == find_label || op == load_relative_address || op == halt
+				|| op == load_immediate || op == load_upper_immediate || op == load_constant
+				|| op == convert_to_u64 || op == convert_to_u32 || op == convert_to_u16 || op == convert_to_u8
+				|| op == convert_to_i64 || op == convert_to_i32 || op == convert_to_i16 || op == convert_to_i8
+				|| op == stack_load_u64 || op == stack_load_u32 || op == stack_load_u16 || op == stack_load_u8
+				|| op == stack_store_u64 || op == stack_store_u32 || op == stack_store_u16 || op == stack_store_u8
+				|| op == stack_load_i32 || op == stack_load_i16 || op == stack_load_i8 || is_stack_immediate(op) || is_host_load(op) || is_host_store(op)
+				|| op == stack_push || op == stack_pop || op == stack_push_immediate || op == stack_pop_immediate
+				|| op == set_if_equal || op == set_if_not_equal || op == set_if_less || op == set_if_less_signed
+				|| op == set_if_greater_equal || op == set_if_greater_equal_signed
+				|| op == add || op == subtract || op == multiply || op == divide || op == modulus || op == divide_signed || op == modulus_signed
+				|| op == shift_left || op == shift_right_logical || op == shift_right_arithmetic
+				|| op == bitwise_xor || op == bitwise_and || op == bitwise_or
+				|| op == select_if || op == min || op == max || op == min_signed || op == max_signed || op == abs_signed
+				|| op == count_ones || op == count_leading_zeros || op == count_trailing_zeros || op == byte_swap
+				|| op == rotate_left || op == rotate_right || op == rotate_left_immediate || op == rotate_right_immediate || op == multiply_high || op == multiply_high_signed
+				|| op == add_carry || op == subtract_borrow || op == multiply_wide
+				|| op == branch_if_equal || op == branch_if_not_equal || op == branch_if_less || op == branch_if_less_signed
+				|| op == branch_if_greater_equal || op == branch_if_greater_equal_signed
+				|| op == loop_decrement_branch || op == loop_subtract_branch;
+		};
+
+		// Figure out which registers can live in local variables
+		bool promote = true;
+		std::set<reg_t> locals;
+		for(auto& op: program) {
+			if(detail::register_aliasing_instructions().contains(op.op)) promote = false;
+			if(!is_native(op.op) || op.op == label || op.op == debug::breakpoint || op.op == halt) continue;
+			if(op.out && !detail::is_compare_and_branch(op.op)) locals.insert(op.out); // NOTE: Compare and branch instructions store their offset in out
+			if(op.op == add_carry || op.op == subtract_borrow || op.op == multiply_wide) locals.insert(op.out + 1); // NOTE: Multi-precision instructions also use the register after out
+			bool immediate_operands = op.op == find_label || op.op == load_relative_address || op.op == load_immediate || op.op == load_upper_immediate || op.op == load_constant
+				|| op.op == stack_push_immediate || op.op == stack_pop_immediate || op.op == jump_relative_immediate;
+			if(!immediate_operands && op.a) locals.insert(op.a);
+			if(!immediate_operands && op.b && op.op != branch_relative_immediate && op.op != rotate_left_immediate && op.op != rotate_right_immediate && !is_stack_immediate(op.op) && !is_host_load(op.op) && !is_host_store(op.op)) locals.insert(op.b);
+		}
+		if(!promote) locals.clear();
+
+		auto reg = [&](reg_t r) -> std::string {
+			if(r == 0) return "uint64_t(0)";
+			if(locals.contains(r)) return "x" + std::to_string(r);
+			return "registers[" + std::to_string(r) + "]";
+		};
+		// Writes to x0 are dropped since it is reset after every instruction
+		auto assign = [&](reg_t r, const std::string& value) -> std::string {
+			if(r == 0) return "(void)(" + value + ");";
+			return reg(r) + " = " + value + ";";
+		};
+		auto address = [](size_t i) { return "uint64_t(program + " + std::to_string(i) + ")"; };
+
+		std::string save, load;
+		for(auto r: locals) {
+			save += "registers[" + std::to_string(r) + "] = x" + std::to_string(r) + "; ";
+			load += "x" + std::to_string(r) + " = registers[" + std::to_string(r) + "]; ";
+		}
+		auto leave = [&](const std::string& pc) { return save + "return mizu::execute(const_cast<mizu::opcode*>(" + pc + "), registers, env, sp);"; };
+
+		// Find the opcodes which need labels and those which computed jumps are likely to target (labels and return addresses)
+		std::vector<bool> targeted(n + 1, false), dispatchable(n + 1, false);
+		targeted[0] = true;
+		for(size_t i = 0; i < n; ++i) {
+			auto& op = program[i];
+			if(op.op == label) dispatchable[i] = targeted[i] = true;
+			if(op.op == jump_relative_immediate && in_program(i, *(int32_t*)&op.a))
+				targeted[i + *(int32_t*)&op.a] = true;
+			if(op.op == branch_relative_immediate && in_program(i, *(int16_t*)&op.b))
+				targeted[i + *(int16_t*)&op.b] = true;
+			if(detail::is_compare_and_branch(op.op) && in_program(i, *(int16_t*)&op.out))
+				targeted[i + *(int16_t*)&op.out] = true;
+			if(is_jump(op.op)) dispatchable[i + 1] = targeted[i + 1] = true;
+		}
+		targeted[n] = dispatchable[n] = false;
+
+		fp::builder::string out;
+		out << "#define MIZU_IMPLEMENTATION\n"
+			<< "#include <mizu/instructions.hpp>\n"
+			<< "#include <mizu/step.hpp>\n"
+			<< extra_includes
+			<< "\n"
+			<< "const static mizu::opcode program[] = {\n";
+
+		for(auto& op: program) {
+			auto name = lookup(op.op);
+			assert(name.has_value());
+			out << "\tmizu::opcode{mizu::" << *name << ", " << op.out << ", " << op.a << ", " << op.b << "},\n";
+		}
+
+		out << "};\n"
+			<< "\n"
+			<< "void* run_program(uint64_t* registers, mizu::registers_and_stack* env, uint8_t* sp) {\n"
+			<< "\tusing namespace mizu;\n"
+			<< "\tconst opcode* target = nullptr;\n";
+		for(auto r: locals)
+			out << "\tuint64_t x" << r << " = registers[" << r << "];\n";
+
+		for(size_t i = 0; i < n; ++i) {
+			auto& op = program[i];
+			auto pc = "program + " + std::to_string(i);
+			auto next = address(i + 1);
+			if(targeted[i]) out << "op_" << i << ":\n";
+			out << "\t";
+
+			if(op.op == label || op.op == debug::breakpoint) {
+				out << "// " << *lookup(op.op) << "\n";
+				continue;
+			} else if(op.op == find_label) {
+				auto found = mizu::detail::find_label_target(&op, program.data(), program.data() + n);
+				out << assign(op.out, found ? address(index_of(found)) : "uint64_t(0)");
+			} else if(op.op == load_relative_address) {
+				out << assign(op.out, "uint64_t(" + pc + " + " + std::to_string(*(int32_t*)&op.a) + ")");
+			} else if(op.op == load_immediate) {
+				out << assign(op.out, "uint64_t(" + std::to_string(immediate(op)) + "u)");
+			} else if(op.op == load_upper_immediate) {
+				if(op.out) out << reg(op.out) << " |= uint64_t(" << immediate(op) << "u) << 32;";
+			} else if(op.op == load_constant) {
+				out << assign(op.out, "env->constants[" + std::to_string(immediate(op)) + "]");
+			} else if(op.op == convert_to_u64 || op.op == convert_to_i64) {
+				out << assign(op.out, reg(op.a));
+			} else if(op.op == convert_to_u32 || op.op == convert_to_u16 || op.op == convert_to_u8) {
+				// Only the bottom bits of the output are replaced
+				std::string mask = op.op == convert_to_u32 ? "0xFFFFFFFFull" : op.op == convert_to_u16 ? "0xFFFFull" : "0xFFull";
+				if(op.out) out << assign(op.out, "(" + reg(op.out) + " & ~" + mask + ") | (" + reg(op.a) + " & " + mask + ")");
+			} else if(op.op == convert_to_i32 || op.op == convert_to_i16 || op.op == convert_to_i8) {
+				std::string type = op.op == convert_to_i32 ? "int32_t" : op.op == convert_to_i16 ? "int16_t" : "int8_t";
+				out << assign(op.out, "uint64_t(int64_t(" + type + "(" + reg(op.a) + ")))");
+			} else if(op.op == stack_load_u64 || op.op == stack_load_u32 || op.op == stack_load_u16 || op.op == stack_load_u8) {
+				std::string type = op.op == stack_load_u64 ? "uint64_t" : op.op == stack_load_u32 ? "uint32_t" : op.op == stack_load_u16 ? "uint16_t" : "uint8_t";
+				out << assign(op.out, "*(" + type + "*)(sp + " + reg(op.a) + ")");
+			} else if(op.op == stack_store_u64 || op.op == stack_store_u32 || op.op == stack_store_u16 || op.op == stack_store_u8) {
+				std::string type = op.op == stack_store_u64 ? "uint64_t" : op.op == stack_store_u32 ? "uint32_t" : op.op == stack_store_u16 ? "uint16_t" : "uint8_t";
+				out << "{ auto value = " << type << "(" << reg(op.a) << "); *(" << type << "*)(sp + " << reg(op.b) << ") = value; " << assign(op.out, "value") << " }";
+			} else if(op.op == stack_load_i32 || op.op == stack_load_i16 || op.op == stack_load_i8) {
+				std::string type = op.op == stack_load_i32 ? "int32_t" : op.op == stack_load_i16 ? "int16_t" : "int8_t";
+				out << assign(op.out, "uint64_t(int64_t(*(" + type + "*)(sp + " + reg(op.a) + ")))");
+			} else if(op.op == stack_load_u64_immediate || op.op == stack_load_u32_immediate || op.op == stack_load_u16_immediate || op.op == stack_load_u8_immediate
+				|| op.op == stack_load_i32_immediate || op.op == stack_load_i16_immediate || op.op == stack_load_i8_immediate) {
+				std::string type = op.op == stack_load_u64_immediate ? "uint64_t" : op.op == stack_load_u32_immediate ? "uint32_t" : op.op == stack_load_u16_immediate ? "uint16_t"
+					: op.op == stack_load_u8_immediate ? "uint8_t" : op.op == stack_load_i32_immediate ? "int32_t" : op.op == stack_load_i16_immediate ? "int16_t" : "int8_t";
+				out << assign(op.out, "uint64_t(int64_t(*(" + type + "*)(sp + " + std::to_string(*(int16_t*)&op.b) + ")))");
+			} else if(op.op == stack_store_u64_immediate || op.op == stack_store_u32_immediate || op.op == stack_store_u16_immediate || op.op == stack_store_u8_immediate) {
+				std::string type = op.op == stack_store_u64_immediate ? "uint64_t" : op.op == stack_store_u32_immediate ? "uint32_t" : op.op == stack_store_u16_immediate ? "uint16_t" : "uint8_t";
+				out << "{ auto value = " << type << "(" << reg(op.a) << "); *(" << type << "*)(sp + " << *(int16_t*)&op.b << ") = value; " << assign(op.out, "value") << " }";
+			} else if(op.op == stack_push || op.op == stack_pop) {
+				out << "sp " << (op.op == stack_push ? "-" : "+") << "= " << reg(op.a) << ";";
+			} else if(op.op == unsafe::load_f32) {
+				// Only the bottom bits of the output are replaced
+				std::string address = "(uint8_t*)" + reg(op.a) + " + " + std::to_string(*(int16_t*)&op.b);
+				if(op.out) out << assign(op.out, "(" + reg(op.out) + " & ~0xFFFFFFFFull) | *(uint32_t*)(" + address + ")");
+			} else if(is_host_load(op.op)) {
+				std::string type = op.op == unsafe::load_u64 || op.op == unsafe::load_f64 ? "uint64_t" : op.op == unsafe::load_u32 ? "uint32_t" : op.op == unsafe::load_u16 ? "uint16_t"
+					: op.op == unsafe::load_u8 ? "uint8_t" : op.op == unsafe::load_i32 ? "int32_t" : op.op == unsafe::load_i16 ? "int16_t" : "int8_t";
+				out << assign(op.out, "uint64_t(*(" + type + "*)((uint8_t*)" + reg(op.a) + " + " + std::to_string(*(int16_t*)&op.b) + "))");
+			} else if(is_host_store(op.op)) {
+				std::string type = op.op == unsafe::store_u64 || op.op == unsafe::store_f64 ? "uint64_t" : op.op == unsafe::store_u32 || op.op == unsafe::store_f32 ? "uint32_t" : op.op == unsafe::store_u16 ? "uint16_t" : "uint8_t";
+				out << "*(" << type << "*)((uint8_t*)" << reg(op.out) << " + " << *(int16_t*)&op.b << ") = " << type << "(" << reg(op.a) << ");";
+			} else if(op.op == stack_push_immediate || op.op == stack_pop_immediate) {
+				out << "sp " << (op.op == stack_push_immediate ? "-" : "+") << "= " << immediate(op) << "u;";
+			} else if(op.op == jump_relative_immediate) {
+				auto offset = *(int32_t*)&op.a;
+				out << assign(op.out, next) << " ";
+				if(in_program(i, offset)) out << "goto op_" << (i + offset) << ";";
+				else out << leave(pc + " + " + std::to_string(offset));
+			} else if(op.op == branch_relative_immediate) {
+				auto offset = *(int16_t*)&op.b;
+				auto jump = in_program(i, offset) ? "goto op_" + std::to_string(i + offset) + ";" : "{ " + leave(pc + " + " + std::to_string(offset)) + " }";
+				out << assign(op.out, next) << " ";
+				// NOTE: The condition is read after the return address is written (so if they are the same register the branch is always taken)
+				if(op.a == op.out) out << jump;
+				else if(op.a != 0) out << "if(" << reg(op.a) << ") " << jump;
+			} else if(op.op == jump_relative || op.op == jump_to || op.op == branch_relative || op.op == branch_to) {
+				// NOTE: jump_relative reads its offset before writing the return address, the others write the return address first
+				auto read = [&](reg_t r) { return op.op != jump_relative && r == op.out ? next : reg(r); };
+				bool relative = op.op == jump_relative || op.op == branch_relative;
+				auto destination = relative ? "target = " + pc + " + int64_t(offset);" : "target = (const opcode*)offset;";
+				if(op.op == jump_relative || op.op == jump_to) {
+					out << "{ auto offset = " << read(op.a) << "; " << assign(op.out, next) << " " << destination << " goto dispatch; }";
+				} else {
+					out << assign(op.out, next) << " ";
+					out << "if(" << read(op.a) << ") { auto offset = " << read(op.b) << "; " << destination << " goto dispatch; }";
+				}
+			} else if(op.op == call_to) {
+				auto offset = op.a == op.out ? next : reg(op.a); // NOTE: The return address is written before the target is read
+				out << "{ auto offset = " << offset << "; " << assign(op.out, next) << " mizu::detail::shadow_stack_push(env, " << pc << " + 1); target = (const opcode*)offset; goto dispatch; }";
+			} else if(op.op == return_to) {
+				out << "target = mizu::detail::shadow_stack_pop(env, (const opcode*)" << reg(op.a) << "); goto dispatch;";
+			} else if(detail::is_compare_and_branch(op.op)) {
+				auto offset = *(int16_t*)&op.out;
+				auto jump = in_program(i, offset) ? "goto op_" + std::to_string(i + offset) + ";" : "{ " + leave(pc + " + " + std::to_string(offset)) + " }";
+				if(op.op == loop_decrement_branch || op.op == loop_subtract_branch) {
+					auto counter = reg(op.a) + (op.op == loop_decrement_branch ? " - 1" : " - " + reg(op.b));
+					auto condition = op.op == loop_decrement_branch ? "counter != 0" : "int64_t(counter) > 0";
+					out << "{ uint64_t counter = " << counter << "; " << assign(op.a, "counter") << " if(" << condition << ") " << jump << " }";
+				} else if(is_native(op.op)) {
+					bool is_signed = op.op == branch_if_less_signed || op.op == branch_if_greater_equal_signed;
+					std::string comparison = op.op == branch_if_equal ? " == " : op.op == branch_if_not_equal ? " != " : op.op == branch_if_less || op.op == branch_if_less_signed ? " < " : " >= ";
+					if(is_signed) out << "if(int64_t(" << reg(op.a) << ")" << comparison << "int64_t(" << reg(op.b) << ")) " << jump;
+					else out << "if(" << reg(op.a) << comparison << reg(op.b) << ") " << jump;
+				} else // Floating point comparisons are performed on the register file
+					out << "{ " << save << "bool taken = mizu::detail::compare_and_branch_taken(" << pc << ", registers); " << load << "if(taken) " << jump << " }";
+			} else if(op.op == set_if_equal || op.op == set_if_not_equal || op.op == set_if_less || op.op == set_if_greater_equal) {
+				std::string comparison = op.op == set_if_equal ? " == " : op.op == set_if_not_equal ? " != " : op.op == set_if_less ? " < " : " >= ";
+				out << assign(op.out, "uint64_t(" + reg(op.a) + comparison + reg(op.b) + ")");
+			} else if(op.op == set_if_less_signed || op.op == set_if_greater_equal_signed) {
+				std::string comparison = op.op == set_if_less_signed ? " < " : " >= ";
+				out << assign(op.out, "uint64_t(int64_t(" + reg(op.a) + ")" + comparison + "int64_t(" + reg(op.b) + "))");
+			} else if(op.op == add || op.op == subtract || op.op == multiply || op.op == divide || op.op == modulus
+				|| op.op == shift_left || op.op == shift_right_logical || op.op == bitwise_xor || op.op == bitwise_and || op.op == bitwise_or
+			) {
+				std::string operation = op.op == add ? " + " : op.op == subtract ? " - " : op.op == multiply ? " * " : op.op == divide ? " / " : op.op == modulus ? " % "
+					: op.op == shift_left ? " << " : op.op == shift_right_logical ? " >> " : op.op == bitwise_xor ? " ^ " : op.op == bitwise_and ? " & " : " | ";
+				out << assign(op.out, reg(op.a) + operation + reg(op.b));
+			} else if(op.op == divide_signed || op.op == modulus_signed) {
+				out << assign(op.out, std::string("uint64_t(mizu::detail::") + (op.op == divide_signed ? "signed_quotient(" : "signed_remainder(") + reg(op.a) + ", " + reg(op.b) + "))");
+			} else if(op.op == shift_right_arithmetic) {
+				out << assign(op.out, "uint64_t(int64_t(" + reg(op.a) + ") >> " + reg(op.b) + ")");
+			} else if(op.op == select_if) {
+				out << assign(op.out, reg(op.out) + " ? " + reg(op.a) + " : " + reg(op.b));
+			} else if(op.op == min || op.op == max) {
+				out << assign(op.out, std::string(op.op == min ? "std::min(" : "std::max(") + reg(op.a) + ", " + reg(op.b) + ")");
+			} else if(op.op == min_signed || op.op == max_signed) {
+				out << assign(op.out, std::string(op.op == min_signed ? "uint64_t(std::min(" : "uint64_t(std::max(") + "int64_t(" + reg(op.a) + "), int64_t(" + reg(op.b) + ")))");
+			} else if(op.op == abs_signed) {
+				out << assign(op.out, "(" + reg(op.a) + " >> 63 ? 0 - " + reg(op.a) + " : " + reg(op.a) + ")");
+			} else if(op.op == count_ones || op.op == count_leading_zeros || op.op == count_trailing_zeros || op.op == byte_swap) {
+				std::string function = op.op == count_ones ? "std::popcount(" : op.op == count_leading_zeros ? "std::countl_zero(" : op.op == count_trailing_zeros ? "std::countr_zero(" : "std::byteswap(";
+				out << assign(op.out, "uint64_t(" + function + reg(op.a) + "))");
+			} else if(op.op == rotate_left || op.op == rotate_right) {
+				out << assign(op.out, std::string(op.op == rotate_left ? "std::rotl(" : "std::rotr(") + reg(op.a) + ", int(" + reg(op.b) + " & 63))");
+			} else if(op.op == rotate_left_immediate || op.op == rotate_right_immediate) {
+				out << assign(op.out, std::string(op.op == rotate_left_immediate ? "std::rotl(" : "std::rotr(") + reg(op.a) + ", " + std::to_string(*(int16_t*)&op.b & 63) + ")");
+			} else if(op.op == multiply_high) {
+				out << assign(op.out, "mizu::detail::upper_product(" + reg(op.a) + ", " + reg(op.b) + ")");
+			} else if(op.op == multiply_high_signed) {
+				out << assign(op.out, "uint64_t(mizu::detail::upper_product_signed(int64_t(" + reg(op.a) + "), int64_t(" + reg(op.b) + ")))");
+			} else if(op.op == add_carry || op.op == subtract_borrow) {
+				std::string function = op.op == add_carry ? "mizu::detail::add_with_carry(" : "mizu::detail::subtract_with_borrow(";
+				out << "{ uint64_t carry = " << reg(op.out) << "; " << assign(op.out, function + reg(op.a) + ", " + reg(op.b) + ", carry)") << " " << assign(op.out + 1, "carry") << " }";
+			} else if(op.op == multiply_wide) {
+				out << "{ uint64_t a = " << reg(op.a) << ", b = " << reg(op.b) << "; " << assign(op.out, "a * b") << " " << assign(op.out + 1, "mizu::detail::upper_product(a, b)") << " }";
+			} else if(op.op == halt) {
+				out << save << "return halt(const_cast<opcode*>(" << pc << "), registers, env, sp);";
+			} else if(op.op == nullptr || mizu::detail::requires_program_counter(op.op)) {
+				out << leave(pc);
+			} else {
+				out << "{ static opcode copy[2] = {program[" << i << "], opcode{mizu::detail::resume_caller}}; "
+					<< save << "sp = mizu::detail::run_copy(copy, registers, env, sp); " << load << "}";
+			}
+			out << " // " << *lookup(op.op) << "\n";
+		}
+
+		// Falling off the end of the program continues in the interpreter, as do computed jumps to unexpected places
+		out << "\t" << leave("program + " + std::to_string(n)) << "\n"
+			<< "dispatch:\n"
+			<< "\tif((uintptr_t(target) - uintptr_t(program)) % sizeof(opcode) == 0)\n"
+			<< "\t\tswitch((uintptr_t(target) - uintptr_t(program)) / sizeof(opcode)) {\n";
+		for(size_t i = 0; i < n; ++i)
+			if(dispatchable[i]) out << "\t\t\tcase " << i << ": goto op_" << i << ";\n";
+		out << "\t\t\tdefault: break;\n"
+			<< "\t\t}\n"
+			<< "\t" << leave("target") << "\n"
+			<< "}\n"
+			<< "\n"
+			<< "int main() {\n"
+			<< "\tmizu::registers_and_stack environment = { .memory = { {},\n";
+
+		for(size_t i = 0; i < memory_size; ) {
+			out << "\t\t";
+			for(size_t j = 0; j < 20 && i < memory_size; ++j, ++i)
+				out << env.memory[i] << "ull, ";
+			out << "\n";
+		}
+
+		out << "\t}};\n"
+			<< "\tsetup_environment(environment, program, program + " << n << ");\n";
+		if(!env.constants.empty()) {
+			out << "\tenvironment.constants = {";
+			for(auto constant: env.constants)
+				out << constant << "ull, ";
+			out << "};\n";
+		}
+		out << "\n"
+			<< "\trun_program(environment.memory.data(), &environment, environment.stack_bottom);\n"
+			<< "}\n";
+
+		return fp::string{out.release()};
+	}
+}}
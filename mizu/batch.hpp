@@ -0,0 +1,548 @@
+#pragma once
+
+#include "../instructions/core.hpp"
+#include "../instructions/f64.hpp"
+#include "exception.hpp"
+#include "optimize.hpp"
+#include "step.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#if defined(_MSC_VER) && !defined(__clang__)
+	#error "Batch execution relies on GCC/Clang vector extensions"
+#endif
+
+namespace mizu {
+	namespace detail {
+		/**
+		 * Operations the batch executor implements for every lane at once
+		 */
+		enum class batch_operation : uint8_t {
+			call_out, // Runs the original instruction one lane at a time
+			nop, load_constant, load_upper_immediate, convert_to_u64, convert_to_i32, convert_to_i16, convert_to_i8, halt,
+			stack_load_u64, stack_store_u64, stack_push_immediate, stack_pop_immediate,
+			jump_relative, jump_relative_immediate, jump_to, call_to, return_to, branch_relative, branch_relative_immediate, branch_to,
+			branch_if_equal, branch_if_not_equal, branch_if_less, branch_if_less_signed, branch_if_greater_equal, branch_if_greater_equal_signed,
+			branch_if_equal_f32, branch_if_not_equal_f32, branch_if_less_f32, branch_if_greater_equal_f32,
+			branch_if_equal_f64, branch_if_not_equal_f64, branch_if_less_f64, branch_if_greater_equal_f64,
+			loop_decrement_branch, loop_subtract_branch,
+			set_if_equal, set_if_not_equal, set_if_less, set_if_less_signed, set_if_greater_equal, set_if_greater_equal_signed,
+			add, subtract, multiply, divide, modulus, divide_signed, modulus_signed, shift_left, shift_right_logical, shift_right_arithmetic, bitwise_xor, bitwise_and, bitwise_or,
+			select_if, min, max, min_signed, max_signed, abs_signed,
+			add_f32, subtract_f32, multiply_f32, divide_f32, max_f32, min_f32,
+			set_if_equal_f32, set_if_not_equal_f32, set_if_less_f32, set_if_greater_equal_f32,
+			convert_to_f64, convert_signed_to_f64, convert_from_f64, convert_signed_from_f64,
+			add_f64, subtract_f64, multiply_f64, divide_f64, max_f64, min_f64,
+			set_if_equal_f64, set_if_not_equal_f64, set_if_less_f64, set_if_greater_equal_f64,
+		};
+
+		/**
+		 * Map from instructions to the batch operations implementing them
+		 */
+		inline const std::unordered_map<instruction_t, batch_operation>& batch_operations() {
+			using op = batch_operation;
+			static const std::unordered_map<instruction_t, batch_operation> map = {
+				{label, op::nop}, {load_immediate, op::load_constant}, {load_upper_immediate, op::load_upper_immediate}, {convert_to_u64, op::convert_to_u64}, {halt, op::halt},
+				{convert_to_i64, op::convert_to_u64}, {convert_to_i32, op::convert_to_i32}, {convert_to_i16, op::convert_to_i16}, {convert_to_i8, op::convert_to_i8},
+				{stack_load_u64, op::stack_load_u64}, {stack_store_u64, op::stack_store_u64}, {stack_push_immediate, op::stack_push_immediate}, {stack_pop_immediate, op::stack_pop_immediate},
+				{jump_relative, op::jump_relative}, {jump_relative_immediate, op::jump_relative_immediate}, {jump_to, op::jump_to}, {call_to, op::call_to}, {return_to, op::return_to},
+				{branch_relative, op::branch_relative}, {branch_relative_immediate, op::branch_relative_immediate}, {branch_to, op::branch_to},
+				{branch_if_equal, op::branch_if_equal}, {branch_if_not_equal, op::branch_if_not_equal}, {branch_if_less, op::branch_if_less}, {branch_if_less_signed, op::branch_if_less_signed},
+				{branch_if_greater_equal, op::branch_if_greater_equal}, {branch_if_greater_equal_signed, op::branch_if_greater_equal_signed},
+				{branch_if_equal_f32, op::branch_if_equal_f32}, {branch_if_not_equal_f32, op::branch_if_not_equal_f32}, {branch_if_less_f32, op::branch_if_less_f32}, {branch_if_greater_equal_f32, op::branch_if_greater_equal_f32},
+				{branch_if_equal_f64, op::branch_if_equal_f64}, {branch_if_not_equal_f64, op::branch_if_not_equal_f64}, {branch_if_less_f64, op::branch_if_less_f64}, {branch_if_greater_equal_f64, op::branch_if_greater_equal_f64},
+				{loop_decrement_branch, op::loop_decrement_branch}, {loop_subtract_branch, op::loop_subtract_branch},
+				{set_if_equal, op::set_if_equal}, {set_if_not_equal, op::set_if_not_equal}, {set_if_less, op::set_if_less}, {set_if_less_signed, op::set_if_less_signed},
+				{set_if_greater_equal, op::set_if_greater_equal}, {set_if_greater_equal_signed, op::set_if_greater_equal_signed},
+				{add, op::add}, {subtract, op::subtract}, {multiply, op::multiply}, {divide, op::divide}, {modulus, op::modulus}, {divide_signed, op::divide_signed}, {modulus_signed, op::modulus_signed},
+				{shift_left, op::shift_left}, {shift_right_logical, op::shift_right_logical}, {shift_right_arithmetic, op::shift_right_arithmetic},
+				{bitwise_xor, op::bitwise_xor}, {bitwise_and, op::bitwise_and}, {bitwise_or, op::bitwise_or},
+				{select_if, op::select_if}, {min, op::min}, {max, op::max}, {min_signed, op::min_signed}, {max_signed, op::max_signed}, {abs_signed, op::abs_signed},
+				{add_f32, op::add_f32}, {subtract_f32, op::subtract_f32}, {multiply_f32, op::multiply_f32}, {divide_f32, op::divide_f32}, {max_f32, op::max_f32}, {min_f32, op::min_f32},
+				{set_if_equal_f32, op::set_if_equal_f32}, {set_if_not_equal_f32, op::set_if_not_equal_f32}, {set_if_less_f32, op::set_if_less_f32}, {set_if_greater_equal_f32, op::set_if_greater_equal_f32},
+				{convert_to_f64, op::convert_to_f64}, {convert_signed_to_f64, op::convert_signed_to_f64}, {convert_from_f64, op::convert_from_f64}, {convert_signed_from_f64, op::convert_signed_from_f64},
+				{add_f64, op::add_f64}, {subtract_f64, op::subtract_f64}, {multiply_f64, op::multiply_f64}, {divide_f64, op::divide_f64}, {max_f64, op::max_f64}, {min_f64, op::min_f64},
+				{set_if_equal_f64, op::set_if_equal_f64}, {set_if_not_equal_f64, op::set_if_not_equal_f64}, {set_if_less_f64, op::set_if_less_f64}, {set_if_greater_equal_f64, op::set_if_greater_equal_f64},
+			};
+			return map;
+		}
+
+		/**
+		 * Vector holding a value for every lane of a batch (arithmetic on it is performed with SIMD)
+		 */
+		template<size_t Lanes>
+		struct batch_lanes {
+			typedef uint64_t type __attribute__((vector_size(Lanes * sizeof(uint64_t))));
+			typedef int64_t signed_type __attribute__((vector_size(Lanes * sizeof(uint64_t))));
+			typedef std::float64_t f64_type __attribute__((vector_size(Lanes * sizeof(uint64_t))));
+		};
+
+		/**
+		 * Reads the float stored in (the start of) a register
+		 * @note Matches mizu::float_register
+		 */
+		template<std::floating_point F>
+		inline F batch_float(uint64_t value) {
+			F out;
+			std::memcpy(&out, &value, sizeof(F));
+			return out;
+		}
+
+		/**
+		 * Stores a float in (the start of) a register, leaving the rest of the register unchanged
+		 * @note Matches mizu::float_register
+		 */
+		template<std::floating_point F>
+		inline uint64_t batch_float(uint64_t value, F f) {
+			std::memcpy(&value, &f, sizeof(F));
+			return value;
+		}
+	}
+
+	/**
+	 * Execution of one program over many independent inputs at once (one lane per input)
+	 * @note Registers are stored as a structure of arrays (every register holds one value per lane), so instructions operating on registers are performed for every lane with SIMD.
+	 */
+	namespace batch {
+		/**
+		 * How many registers each lane has (the rest of a Mizu environment's memory is its stack)
+		 */
+		constexpr static size_t register_count = 256;
+
+		/**
+		 * A single translated opcode
+		 */
+		struct batch_opcode {
+			detail::batch_operation op;
+			reg_t out, a, b;
+			/**
+			 * Immediate (or value resolved during translation) used by the operation
+			 */
+			uint64_t immediate;
+			/**
+			 * Original instruction (used by instructions without a batch operation)
+			 */
+			instruction_t original;
+		};
+
+		/**
+		 * A Mizu program translated for batch execution
+		 * @note Construct using mizu::batch::translate
+		 * @note Addresses stored in registers (return addresses, found labels) point into the source program, which must thus outlive the translated program.
+		 */
+		struct program {
+			/**
+			 * Program the batch program was translated from
+			 */
+			fp::view<const opcode> source = {nullptr, 0};
+			/**
+			 * Translated opcodes (one for each opcode of the source program)
+			 */
+			std::vector<batch_opcode> opcodes;
+		};
+
+		/**
+		 * Registers and stacks for every lane of a batch
+		 * @note Large, thus it is recommended to allocate it on the heap.
+		 *
+		 * @tparam Lanes how many inputs are processed at once (must be a power of two)
+		 */
+		template<size_t Lanes>
+		struct environment {
+			/**
+			 * Register file, indexed [register][lane]
+			 * @note The inputs of each lane should be placed here before execution, and its outputs read back once it is finished
+			 */
+			std::array<typename detail::batch_lanes<Lanes>::type, register_count> registers = {};
+			/**
+			 * Index of the opcode each lane will execute next (or done once the lane halts)
+			 */
+			typename detail::batch_lanes<Lanes>::type program_counters;
+			/**
+			 * Stack pointer of each lane
+			 */
+			std::array<uint8_t*, Lanes> stack_pointers;
+			/**
+			 * Stack of each lane
+			 * @note The register portion of these environments is only used while an instruction without a batch operation runs
+			 */
+			std::array<registers_and_stack, Lanes> lanes;
+
+			/**
+			 * Program counter of lanes which have halted
+			 */
+			constexpr static uint64_t done = std::numeric_limits<uint64_t>::max();
+		};
+
+		/**
+		 * Configures a batch environment to run a program from its start
+		 * @note sets register x0 to zero in every lane
+		 *
+		 * @param env the environment to configure
+		 * @param program the program the environment will run
+		 */
+		template<size_t Lanes>
+		void setup_environment(environment<Lanes>& env, const program& program) {
+			env.registers[0] = typename detail::batch_lanes<Lanes>::type{};
+			env.program_counters = typename detail::batch_lanes<Lanes>::type{};
+			for(size_t l = 0; l < Lanes; ++l) {
+				mizu::setup_environment(env.lanes[l], program.source);
+				env.stack_pointers[l] = env.lanes[l].stack_bottom;
+			}
+		}
+
+		/**
+		 * Translates a program for batch execution
+		 * @note find_label instructions are resolved during translation (searching the whole program), and fused instructions are unfused.
+		 *
+		 * @param source The program to translate (which must outlive the translated program)
+		 * @param constants The constants the program loads (see mizu::constant_pool), load_constant instructions are resolved during translation
+		 * @throws std::runtime_error if the program contains an instruction that depends on the program counter and doesn't have a batch operation (such as fork_relative), or a relative jump or branch leaving the program
+		 * @return program the translated program
+		 */
+		inline program translate(fp::view<const opcode> source, fp::view<const uint64_t> constants = {nullptr, 0}) {
+			auto in_program = [&](size_t i, int64_t offset) { return int64_t(i) + offset >= 0 && int64_t(i) + offset < int64_t(source.size()); };
+
+			program out;
+			out.source = source;
+			out.opcodes.resize(source.size());
+			for(size_t i = 0; i < source.size(); ++i) {
+				auto& op = source[i];
+				instruction_t instruction = MIZU_INSTRUCTION(&op);
+				for(auto& rule: detail::fusion_rules())
+					if(instruction == rule.fused)
+						instruction = rule.first; // NOTE: The second half of the pair is still in place
+
+				auto& translated = out.opcodes[i];
+				translated = {detail::batch_operation::call_out, op.out, op.a, op.b, *(uint32_t*)&op.a, instruction};
+				if(instruction == find_label) {
+					translated.op = detail::batch_operation::load_constant;
+					translated.immediate = (uint64_t)detail::find_label_target(&op, source.data(), source.data() + source.size());
+				} else if(instruction == load_relative_address) {
+					translated.op = detail::batch_operation::load_constant;
+					translated.immediate = (uint64_t)(&op + *(int32_t*)&op.a);
+				} else if(instruction == load_constant && *(uint32_t*)&op.a < constants.size()) {
+					translated.op = detail::batch_operation::load_constant;
+					translated.immediate = constants[*(uint32_t*)&op.a];
+				} else if(auto found = detail::batch_operations().find(instruction); found != detail::batch_operations().end())
+					translated.op = found->second;
+				else if(detail::requires_program_counter(instruction))
+					MIZU_THROW(std::runtime_error("Opcode " + std::to_string(i) + " depends on the program counter and can't be run in a batch."));
+
+				if(translated.op == detail::batch_operation::jump_relative_immediate) translated.immediate = *(int32_t*)&op.a;
+				if(translated.op == detail::batch_operation::branch_relative_immediate) translated.immediate = *(int16_t*)&op.b;
+				if(detail::is_compare_and_branch(instruction)) translated.immediate = *(int16_t*)&op.out;
+				if((translated.op == detail::batch_operation::jump_relative_immediate || translated.op == detail::batch_operation::branch_relative_immediate || detail::is_compare_and_branch(instruction))
+					&& !in_program(i, (int64_t)translated.immediate))
+					MIZU_THROW(std::runtime_error("Opcode " + std::to_string(i) + " jumps outside the program."));
+			}
+			return out;
+		}
+
+		/**
+		 * Runs every lane of a batch until they have all halted
+		 * @note Each step runs the earliest opcode any lane is waiting on for every lane waiting on it (the other lanes are masked off),
+		 *	thus lanes which diverge at a branch reconverge once they reach the same opcode again.
+		 *
+		 * @param program The translated program to execute
+		 * @param env The environment (set up using mizu::batch::setup_environment) to execute in
+		 * @throws std::runtime_error if a lane jumps to an address outside of the program
+		 */
+		template<size_t Lanes>
+		void execute(const program& program, environment<Lanes>& env) {
+			using lanes_t = typename detail::batch_lanes<Lanes>::type;
+			using signed_lanes_t = typename detail::batch_lanes<Lanes>::signed_type;
+			using f64_lanes_t = typename detail::batch_lanes<Lanes>::f64_type; // NOTE: Casting between vectors reinterprets their bits
+			using op = detail::batch_operation;
+			auto& registers = env.registers;
+			auto& pcs = env.program_counters;
+			auto start = program.source.data();
+
+			uint64_t pc;
+			lanes_t mask;
+			bool converged, rescan = true;
+			while(true) {
+				if(rescan) {
+					// Find the earliest opcode any lane is waiting on
+					pc = environment<Lanes>::done;
+					for(size_t l = 0; l < Lanes; ++l)
+						pc = std::min<uint64_t>(pc, pcs[l]);
+					if(pc == environment<Lanes>::done) return;
+
+					mask = (lanes_t)(pcs == pc);
+					lanes_t waiting = ~mask & (lanes_t)(pcs != environment<Lanes>::done);
+					converged = true;
+					for(size_t l = 0; l < Lanes; ++l)
+						if(waiting[l]) converged = false;
+					rescan = false;
+				}
+
+				auto& code = program.opcodes[pc];
+				auto& a = registers[code.a];
+				auto& b = registers[code.b];
+				auto next = (uint64_t)(start + pc + 1);
+
+				// Writes a value computed for every lane into the lanes which are running (writes to x0 are dropped)
+				auto store = [&](lanes_t result) {
+					if(code.out == 0) return;
+					auto& out = registers[code.out];
+					out = (result & mask) | (out & ~mask);
+				};
+				// Comparisons produce -1 in lanes where they are true
+				auto store_condition = [&](auto condition) { store((lanes_t)condition & 1); };
+				// Computes a value one lane at a time (for operations which don't have a vector form)
+				auto lanewise = [&](auto f) {
+					lanes_t result;
+					for(size_t l = 0; l < Lanes; ++l)
+						result[l] = f(l);
+					store(result);
+				};
+				// NOTE: Division is only performed in running lanes (masked off lanes might divide by zero)
+				auto lanewise_guarded = [&](auto f) {
+					lanes_t result = {};
+					for(size_t l = 0; l < Lanes; ++l)
+						if(mask[l]) result[l] = f(l);
+					store(result);
+				};
+				// NOTE: While every running lane is at the same opcode only the shared program counter is advanced (control flow updates the lanes' program counters)
+				auto advance = [&] {
+					++pc;
+					if(converged) return;
+					// Every other lane is waiting further ahead, so the lanes which just ran are still the earliest (joined by any lanes waiting on the next opcode)
+					pcs += mask & 1;
+					mask = (lanes_t)(pcs == pc);
+				};
+				// Finds the index of the opcode at an address a lane jumped to
+				auto index_of = [&](size_t l, uint64_t address) -> uint64_t {
+					auto target = (const opcode*)address;
+					if(target < start || target >= start + program.source.size())
+						MIZU_THROW(std::runtime_error("Lane " + std::to_string(l) + " jumped outside the program."));
+					return target - start;
+				};
+				// Moves every running lane to the opcode (index) it jumped to
+				// NOTE: While the lanes haven't diverged and they all jump to the same place only the shared program counter needs to move
+				auto go = [&](lanes_t targets) {
+					if(converged) {
+						size_t first = 0;
+						while(!mask[first]) ++first;
+						bool uniform = true;
+						for(size_t l = first + 1; l < Lanes; ++l)
+							if(mask[l] && targets[l] != targets[first]) uniform = false;
+						if(uniform) {
+							pc = targets[first];
+							return;
+						}
+					}
+					pcs = (targets & mask) | (pcs & ~mask);
+					rescan = true;
+				};
+
+				// Moves the running lanes where a comparison is true by the opcode's offset (and the rest to the next opcode)
+				auto branch_if = [&](auto condition) {
+					lanes_t taken = (lanes_t)condition;
+					go((taken & (pc + code.immediate)) | (~taken & (pc + 1)));
+				};
+				// Compares floats one lane at a time (producing -1 in lanes where the comparison is true)
+				auto lanewise_condition = [&](auto f) {
+					lanes_t condition;
+					for(size_t l = 0; l < Lanes; ++l)
+						condition[l] = f(l) ? -1 : 0;
+					return condition;
+				};
+
+				switch(code.op) {
+				break; case op::call_out:
+					for(size_t l = 0; l < Lanes; ++l) {
+						if(!mask[l]) continue;
+						auto& lane = env.lanes[l];
+						for(size_t r = 0; r < register_count; ++r)
+							lane.memory[r] = registers[r][l];
+						opcode copy[2] = {opcode{code.original, code.out, code.a, code.b}, opcode{detail::resume_caller}};
+						env.stack_pointers[l] = detail::run_copy(copy, lane.memory.data(), &lane, env.stack_pointers[l]);
+						for(size_t r = 0; r < register_count; ++r)
+							registers[r][l] = lane.memory[r];
+					}
+					advance();
+				break; case op::nop: advance();
+				break; case op::load_constant: store(lanes_t{} + code.immediate); advance();
+				break; case op::load_upper_immediate: store(registers[code.out] | (code.immediate << 32)); advance();
+				break; case op::convert_to_u64: store(a); advance();
+				// NOTE: Sign extension shifts the value to the top of the lane and arithmetically back down
+				break; case op::convert_to_i32: store((lanes_t)((signed_lanes_t)(a << 32) >> 32)); advance();
+				break; case op::convert_to_i16: store((lanes_t)((signed_lanes_t)(a << 48) >> 48)); advance();
+				break; case op::convert_to_i8: store((lanes_t)((signed_lanes_t)(a << 56) >> 56)); advance();
+				break; case op::halt:
+					rescan = true;
+					pcs |= mask;
+
+				// Stack
+				break; case op::stack_load_u64:
+					lanewise_guarded([&](size_t l) {
+						uint8_t* offset = env.stack_pointers[l] + a[l];
+						assert(offset > env.lanes[l].stack_boundary);
+						assert(offset <= env.lanes[l].stack_bottom);
+						return *(uint64_t*)offset;
+					});
+					advance();
+				break; case op::stack_store_u64:
+					lanewise_guarded([&](size_t l) {
+						uint8_t* offset = env.stack_pointers[l] + b[l];
+						assert(offset > env.lanes[l].stack_boundary);
+						assert(offset <= env.lanes[l].stack_bottom);
+						return *(uint64_t*)offset = a[l];
+					});
+					advance();
+				break; case op::stack_push_immediate: case op::stack_pop_immediate:
+					for(size_t l = 0; l < Lanes; ++l)
+						if(mask[l]) {
+							auto& sp = env.stack_pointers[l];
+							sp += code.op == op::stack_push_immediate ? -int64_t(code.immediate) : int64_t(code.immediate);
+							assert(sp > env.lanes[l].stack_boundary);
+							assert(sp <= env.lanes[l].stack_bottom);
+						}
+					advance();
+
+				// Control flow (return addresses are written before targets and conditions are read, matching the interpreter)
+				break; case op::jump_relative: {
+					lanes_t offsets = a;
+					store(lanes_t{} + next);
+					lanes_t targets = {};
+					for(size_t l = 0; l < Lanes; ++l)
+						if(mask[l]) targets[l] = index_of(l, (uint64_t)(start + pc + (int64_t)offsets[l]));
+					go(targets);
+				}
+				break; case op::jump_relative_immediate:
+					store(lanes_t{} + next);
+					go(lanes_t{} + (pc + code.immediate));
+				break; case op::jump_to: {
+					store(lanes_t{} + next);
+					lanes_t targets = {};
+					for(size_t l = 0; l < Lanes; ++l)
+						if(mask[l]) targets[l] = index_of(l, a[l]);
+					go(targets);
+				}
+				break; case op::call_to: {
+					store(lanes_t{} + next);
+					lanes_t targets = {};
+					for(size_t l = 0; l < Lanes; ++l)
+						if(mask[l]) {
+							detail::shadow_stack_push(&env.lanes[l], (const opcode*)next);
+							targets[l] = index_of(l, a[l]);
+						}
+					go(targets);
+				}
+				break; case op::return_to: {
+					lanes_t targets = {};
+					for(size_t l = 0; l < Lanes; ++l)
+						if(mask[l]) targets[l] = index_of(l, (uint64_t)detail::shadow_stack_pop(&env.lanes[l], (const opcode*)a[l]));
+					go(targets);
+				}
+				break; case op::branch_relative: {
+					store(lanes_t{} + next);
+					lanes_t targets = lanes_t{} + (pc + 1);
+					for(size_t l = 0; l < Lanes; ++l)
+						if(mask[l] && a[l]) targets[l] = index_of(l, (uint64_t)(start + pc + (int64_t)b[l]));
+					go(targets);
+				}
+				break; case op::branch_relative_immediate: {
+					store(lanes_t{} + next);
+					lanes_t taken = (lanes_t)(a != 0);
+					go((taken & (pc + code.immediate)) | (~taken & (pc + 1)));
+				}
+				break; case op::branch_to: {
+					store(lanes_t{} + next);
+					lanes_t targets = lanes_t{} + (pc + 1);
+					for(size_t l = 0; l < Lanes; ++l)
+						if(mask[l] && a[l]) targets[l] = index_of(l, b[l]);
+					go(targets);
+				}
+
+				break; case op::branch_if_equal: branch_if(a == b);
+				break; case op::branch_if_not_equal: branch_if(a != b);
+				break; case op::branch_if_less: branch_if(a < b);
+				break; case op::branch_if_less_signed: branch_if((signed_lanes_t)a < (signed_lanes_t)b);
+				break; case op::branch_if_greater_equal: branch_if(a >= b);
+				break; case op::branch_if_greater_equal_signed: branch_if((signed_lanes_t)a >= (signed_lanes_t)b);
+				break; case op::branch_if_equal_f32: branch_if(lanewise_condition([&](size_t l) { return detail::batch_float<std::float32_t>(a[l]) == detail::batch_float<std::float32_t>(b[l]); }));
+				break; case op::branch_if_not_equal_f32: branch_if(lanewise_condition([&](size_t l) { return detail::batch_float<std::float32_t>(a[l]) != detail::batch_float<std::float32_t>(b[l]); }));
+				break; case op::branch_if_less_f32: branch_if(lanewise_condition([&](size_t l) { return detail::batch_float<std::float32_t>(a[l]) < detail::batch_float<std::float32_t>(b[l]); }));
+				break; case op::branch_if_greater_equal_f32: branch_if(lanewise_condition([&](size_t l) { return detail::batch_float<std::float32_t>(a[l]) >= detail::batch_float<std::float32_t>(b[l]); }));
+				break; case op::branch_if_equal_f64: branch_if((f64_lanes_t)a == (f64_lanes_t)b);
+				break; case op::branch_if_not_equal_f64: branch_if((f64_lanes_t)a != (f64_lanes_t)b);
+				break; case op::branch_if_less_f64: branch_if((f64_lanes_t)a < (f64_lanes_t)b);
+				break; case op::branch_if_greater_equal_f64: branch_if((f64_lanes_t)a >= (f64_lanes_t)b);
+				break; case op::loop_decrement_branch: case op::loop_subtract_branch: {
+					lanes_t counter = code.op == op::loop_decrement_branch ? a - 1 : a - b;
+					if(code.a != 0) a = (counter & mask) | (a & ~mask); // NOTE: Only the running lanes' counters are updated
+					if(code.op == op::loop_decrement_branch) branch_if(counter != 0);
+					else branch_if((signed_lanes_t)counter > 0);
+				}
+
+				// Integer
+				break; case op::set_if_equal: store_condition(a == b); advance();
+				break; case op::set_if_not_equal: store_condition(a != b); advance();
+				break; case op::set_if_less: store_condition(a < b); advance();
+				break; case op::set_if_less_signed: store_condition((signed_lanes_t)a < (signed_lanes_t)b); advance();
+				break; case op::set_if_greater_equal: store_condition(a >= b); advance();
+				break; case op::set_if_greater_equal_signed: store_condition((signed_lanes_t)a >= (signed_lanes_t)b); advance();
+				break; case op::add: store(a + b); advance();
+				break; case op::subtract: store(a - b); advance();
+				break; case op::multiply: store(a * b); advance();
+				break; case op::divide: lanewise_guarded([&](size_t l) { return a[l] / b[l]; }); advance();
+				break; case op::modulus: lanewise_guarded([&](size_t l) { return a[l] % b[l]; }); advance();
+				break; case op::divide_signed: lanewise_guarded([&](size_t l) { return uint64_t(detail::signed_quotient(a[l], b[l])); }); advance();
+				break; case op::modulus_signed: lanewise_guarded([&](size_t l) { return uint64_t(detail::signed_remainder(a[l], b[l])); }); advance();
+				break; case op::shift_left: store(a << b); advance();
+				break; case op::shift_right_logical: store(a >> b); advance();
+				break; case op::shift_right_arithmetic: store((lanes_t)((signed_lanes_t)a >> (signed_lanes_t)b)); advance();
+				break; case op::bitwise_xor: store(a ^ b); advance();
+				break; case op::bitwise_and: store(a & b); advance();
+				break; case op::bitwise_or: store(a | b); advance();
+				break; case op::select_if: store(registers[code.out] != 0 ? a : b); advance();
+				break; case op::min: store(a < b ? a : b); advance();
+				break; case op::max: store(a > b ? a : b); advance();
+				break; case op::min_signed: store((signed_lanes_t)a < (signed_lanes_t)b ? a : b); advance();
+				break; case op::max_signed: store((signed_lanes_t)a > (signed_lanes_t)b ? a : b); advance();
+				break; case op::abs_signed: store((signed_lanes_t)a < 0 ? 0 - a : a); advance();
+
+				// Floating point (f32s only occupy half of each lane, so they are computed one lane at a time)
+				#define MIZU_BATCH_LANEWISE_FLOAT_CASES(F, suffix)\
+					break; case op::add_##suffix: lanewise([&, &out = registers[code.out]](size_t l) { return detail::batch_float<F>(out[l], detail::batch_float<F>(a[l]) + detail::batch_float<F>(b[l])); }); advance();\
+					break; case op::subtract_##suffix: lanewise([&, &out = registers[code.out]](size_t l) { return detail::batch_float<F>(out[l], detail::batch_float<F>(a[l]) - detail::batch_float<F>(b[l])); }); advance();\
+					break; case op::multiply_##suffix: lanewise([&, &out = registers[code.out]](size_t l) { return detail::batch_float<F>(out[l], detail::batch_float<F>(a[l]) * detail::batch_float<F>(b[l])); }); advance();\
+					break; case op::divide_##suffix: lanewise([&, &out = registers[code.out]](size_t l) { return detail::batch_float<F>(out[l], detail::batch_float<F>(a[l]) / detail::batch_float<F>(b[l])); }); advance();\
+					break; case op::set_if_equal_##suffix: lanewise([&](size_t l) -> uint64_t { return detail::batch_float<F>(a[l]) == detail::batch_float<F>(b[l]); }); advance();\
+					break; case op::set_if_not_equal_##suffix: lanewise([&](size_t l) -> uint64_t { return detail::batch_float<F>(a[l]) != detail::batch_float<F>(b[l]); }); advance();\
+					break; case op::set_if_less_##suffix: lanewise([&](size_t l) -> uint64_t { return detail::batch_float<F>(a[l]) < detail::batch_float<F>(b[l]); }); advance();\
+					break; case op::set_if_greater_equal_##suffix: lanewise([&](size_t l) -> uint64_t { return detail::batch_float<F>(a[l]) >= detail::batch_float<F>(b[l]); }); advance();
+				MIZU_BATCH_LANEWISE_FLOAT_CASES(std::float32_t, f32)
+				#undef MIZU_BATCH_LANEWISE_FLOAT_CASES
+				break; case op::max_f32: lanewise([&, &out = registers[code.out]](size_t l) { return detail::batch_float<std::float32_t>(out[l], std::max(detail::batch_float<std::float32_t>(a[l]), detail::batch_float<std::float32_t>(b[l]))); }); advance();
+				break; case op::min_f32: lanewise([&, &out = registers[code.out]](size_t l) { return detail::batch_float<std::float32_t>(out[l], std::min(detail::batch_float<std::float32_t>(a[l]), detail::batch_float<std::float32_t>(b[l]))); }); advance();
+				break; case op::convert_to_f64: store((lanes_t)__builtin_convertvector(a, f64_lanes_t)); advance();
+				break; case op::convert_signed_to_f64: store((lanes_t)__builtin_convertvector((signed_lanes_t)a, f64_lanes_t)); advance();
+				break; case op::convert_from_f64: store(__builtin_convertvector((f64_lanes_t)a, lanes_t)); advance();
+				break; case op::convert_signed_from_f64: store((lanes_t)__builtin_convertvector((f64_lanes_t)a, signed_lanes_t)); advance();
+				break; case op::add_f64: store((lanes_t)((f64_lanes_t)a + (f64_lanes_t)b)); advance();
+				break; case op::subtract_f64: store((lanes_t)((f64_lanes_t)a - (f64_lanes_t)b)); advance();
+				break; case op::multiply_f64: store((lanes_t)((f64_lanes_t)a * (f64_lanes_t)b)); advance();
+				break; case op::divide_f64: store((lanes_t)((f64_lanes_t)a / (f64_lanes_t)b)); advance();
+				break; case op::max_f64: lanewise([&](size_t l) { return std::bit_cast<uint64_t>(std::max(std::bit_cast<std::float64_t>(a[l]), std::bit_cast<std::float64_t>(b[l]))); }); advance();
+				break; case op::min_f64: lanewise([&](size_t l) { return std::bit_cast<uint64_t>(std::min(std::bit_cast<std::float64_t>(a[l]), std::bit_cast<std::float64_t>(b[l]))); }); advance();
+				break; case op::set_if_equal_f64: store_condition((f64_lanes_t)a == (f64_lanes_t)b); advance();
+				break; case op::set_if_not_equal_f64: store_condition((f64_lanes_t)a != (f64_lanes_t)b); advance();
+				break; case op::set_if_less_f64: store_condition((f64_lanes_t)a < (f64_lanes_t)b); advance();
+				break; case op::set_if_greater_equal_f64: store_condition((f64_lanes_t)a >= (f64_lanes_t)b); advance();
+				}
+			}
+		}
+	}
+}
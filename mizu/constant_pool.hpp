@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../instructions/core.hpp"
+
+#include <bit>
+#include <unordered_map>
+#include <vector>
+
+namespace mizu {
+	/**
+	 * Builds the pool of 64 bit constants a program loads using mizu::load_constant
+	 * @note Adding a value which is already in the pool returns the index it was first given, so every distinct constant is only stored once.
+	 * @note The pool should be copied into the environment's constants before the program runs:
+	 *	env.constants = pool.values;
+	 */
+	struct constant_pool {
+		/**
+		 * The constants, in the order they were first added
+		 */
+		std::vector<uint64_t> values;
+		/**
+		 * Index of every constant in \p values
+		 */
+		std::unordered_map<uint64_t, uint32_t> indices;
+
+		/**
+		 * Adds a constant to the pool
+		 *
+		 * @param value the constant to add
+		 * @return uint32_t the index mizu::load_constant should be given to load \p value
+		 */
+		uint32_t add(uint64_t value) {
+			auto [found, added] = indices.try_emplace(value, values.size());
+			if(added) values.push_back(value);
+			return found->second;
+		}
+		/**
+		 * Adds a floating point constant to the pool
+		 *
+		 * @param value the constant to add
+		 * @return uint32_t the index mizu::load_constant should be given to load \p value
+		 */
+		uint32_t add_f64(double value) { return add(std::bit_cast<uint64_t>(value)); }
+		/**
+		 * Adds a host pointer to the pool
+		 *
+		 * @param ptr the pointer to add
+		 * @return uint32_t the index mizu::load_constant should be given to load \p ptr
+		 */
+		uint32_t add_host_pointer(const void* ptr) { return add((size_t)ptr); }
+
+		/**
+		 * Creates an opcode loading a constant (adding it to the pool if necessary)
+		 *
+		 * @param out the register to load \p value into
+		 * @param value the constant to load
+		 * @return opcode the load_constant opcode
+		 */
+		opcode load(reg_t out, uint64_t value) { return opcode{load_constant, out}.set_immediate(add(value)); }
+		/**
+		 * Creates an opcode loading a floating point constant (adding it to the pool if necessary)
+		 *
+		 * @param out the register to load \p value into
+		 * @param value the constant to load
+		 * @return opcode the load_constant opcode
+		 */
+		opcode load_f64(reg_t out, double value) { return opcode{load_constant, out}.set_immediate(add_f64(value)); }
+		/**
+		 * Creates an opcode loading a host pointer (adding it to the pool if necessary)
+		 *
+		 * @param out the register to load \p ptr into
+		 * @param ptr the pointer to load
+		 * @return opcode the load_constant opcode
+		 */
+		opcode load_host_pointer(reg_t out, const void* ptr) { return opcode{load_constant, out}.set_immediate(add_host_pointer(ptr)); }
+	};
+}
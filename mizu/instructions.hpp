@@ -1,8 +1,18 @@
 #pragma once
 
+#ifdef MIZU_COMPACT_OPCODES
+	// Compact opcodes dispatch through the lookup system's handler table, so every instruction must be registered with it
+	#include "../instructions/lookup.hpp"
+#endif
+
 #include "../instructions/core.hpp"
+#include "../instructions/bits.hpp"
+#include "../instructions/bigint.hpp"
 #include "../instructions/debug.hpp"
 #include "../instructions/f32.hpp"
 #include "../instructions/f64.hpp"
 #include "../instructions/unsafe.hpp"
-#include "../instructions/parallel.hpp"
\ No newline at end of file
+#include "../instructions/interleave.hpp"
+#include "../instructions/parallel.hpp"
+#include "../instructions/fused.hpp"
+#include "../instructions/unchecked.hpp"
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "../instructions/interleave.hpp"
+
+#include <fp/pointer.h>
+
+#ifdef MIZU_NO_HARDWARE_THREADS
+	#error "Interleaved execution switches environments by returning to mizu::execute, which isn't available when threads are emulated with coroutines"
+#endif
+
+namespace mizu::interleave {
+	/**
+	 * One of the independent environments an interleaved executor switches between
+	 */
+	struct context {
+		/**
+		 * The next instruction this context will execute (nullptr once it has halted)
+		 */
+		opcode* pc;
+		/**
+		 * The environment this context executes in
+		 */
+		registers_and_stack* env;
+		/**
+		 * The context's current stack pointer
+		 */
+		uint8_t* sp;
+		/**
+		 * Weather the context stopped at a yield point (which it resumes from, without yielding there again)
+		 */
+		bool yielded = false;
+
+		/**
+		 * Creates a context which will execute \p program from its start in \p env
+		 * @note \p env should already be setup (see setup_environment)
+		 */
+		context(const opcode* program, registers_and_stack& env) : pc(const_cast<opcode*>(program)), env(&env), sp(env.stack_bottom) {}
+	};
+
+	/**
+	 * Time-multiplexes several independent environments on the current thread, running each until it reaches a yield point (see \ref prefetch_and_yield, \ref yield_execution, and the yielding loads like \ref yielding_load_u64) and then moving on to the next (round robin) until every one of them has halted
+	 * @note Since \ref prefetch_and_yield (and the yielding loads) start fetching their pointer before switching, the cache misses of up to \p contexts.size() environments are overlapped instead of each stalling the thread in turn
+	 * @note The contexts are updated in place as they run (each one's pc is nullptr once it has halted)
+	 *
+	 * @param contexts The environments to execute
+	 * @return size_t how many times the executor switched between environments
+	 */
+	inline size_t execute(fp::view<context> contexts) {
+		auto& state = detail::interleave_state_for_thread;
+		struct restore { detail::interleave_state& state; detail::interleave_state outer; ~restore() { state = outer; } } restore{state, state}; // Restored afterwards (even if an instruction throws) so that interleaved executors can be nested
+		state.active = true;
+
+		size_t switches = 0, remaining = 0;
+		for(auto& context: contexts)
+			if(context.pc) ++remaining;
+
+		while(remaining > 0)
+			for(auto& context: contexts) {
+				if(!context.pc) continue;
+
+				state.yielded = false;
+				state.resumed = context.yielded;
+				mizu::execute(context.pc, context.env->memory.data(), context.env, context.sp);
+				if(state.yielded) {
+					context.pc = state.pc;
+					context.sp = state.sp;
+					context.yielded = true;
+					++switches;
+				} else {
+					context.pc = nullptr;
+					--remaining;
+				}
+			}
+
+		return switches;
+	}
+}
@@ -0,0 +1,640 @@
+#pragma once
+
+#include "../instructions/bits.hpp"
+#include "../instructions/bigint.hpp"
+#include "../instructions/debug.hpp"
+#include "../instructions/unsafe.hpp"
+#include "exception.hpp"
+#include "step.hpp"
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if !(defined(__x86_64__) && defined(__linux__))
+	#error "Mizu's JIT currently only supports x86-64 Linux"
+#endif
+
+#include <sys/mman.h>
+
+namespace mizu {
+	namespace detail {
+		/**
+		 * Where compiled code stopped executing
+		 */
+		struct exit_state {
+			/**
+			 * Opcode the interpreter should continue from
+			 */
+			opcode* pc;
+			/**
+			 * Stack pointer at the time of exit
+			 */
+			uint8_t* sp;
+		};
+
+		/**
+		 * Signature of the entry stub at the beginning of every compiled program
+		 */
+		using entry_t = exit_state(*)(uint64_t* registers, registers_and_stack* env, uint8_t* sp, const void* target, const void* const* native_table, const opcode* program_start);
+
+		/**
+		 * Stitches together the machine code stencils for each instruction
+		 * @note Register assignments used in compiled code:
+		 *	rbx = registers, r12 = env, r13 = stack pointer, r14 = native address table, r15 = program start.
+		 *	rax, rcx, and rdx are scratch, the shared exit expects the opcode to resume from in rax.
+		 */
+		struct assembler {
+			std::vector<uint8_t> code;
+
+			/**
+			 * Location of a 32bit relative jump which needs to be patched once every instruction has been placed
+			 */
+			struct fixup {
+				size_t location;
+				size_t target; // Index of the target opcode, or exit_target for the shared exit
+			};
+			constexpr static size_t exit_target = -1;
+			std::vector<fixup> fixups;
+
+			void bytes(std::initializer_list<uint8_t> b) { code.insert(code.end(), b); }
+			void imm32(uint32_t value) { auto end = code.size(); code.resize(end + 4); std::memcpy(code.data() + end, &value, 4); }
+			void imm64(uint64_t value) { auto end = code.size(); code.resize(end + 8); std::memcpy(code.data() + end, &value, 8); }
+			void displacement(reg_t r) { imm32(uint32_t(r) * sizeof(uint64_t)); }
+
+			// rax = registers[r]
+			void load_rax(reg_t r) { if(r == 0) bytes({0x31, 0xC0}); else { bytes({0x48, 0x8B, 0x83}); displacement(r); } }
+			// rcx = registers[r]
+			void load_rcx(reg_t r) { if(r == 0) bytes({0x31, 0xC9}); else { bytes({0x48, 0x8B, 0x8B}); displacement(r); } }
+			// registers[r] = rax (writes to x0 are dropped since it is reset after every instruction)
+			void store_rax(reg_t r) { if(r == 0) return; bytes({0x48, 0x89, 0x83}); displacement(r); }
+			// rsi = registers[r]
+			void load_rsi(reg_t r) { if(r == 0) bytes({0x31, 0xF6}); else { bytes({0x48, 0x8B, 0xB3}); displacement(r); } }
+			// rax = value
+			void move_rax(uint64_t value) {
+				if(value <= UINT32_MAX) { bytes({0xB8}); imm32(value); }
+				else { bytes({0x48, 0xB8}); imm64(value); }
+			}
+			// rax = registers[a] <op> registers[b] where op is the rax, r/m64 form of a two operand ALU instruction
+			void alu(std::initializer_list<uint8_t> op, reg_t a, reg_t b) {
+				load_rax(a);
+				bytes(op); bytes({0x83}); displacement(b);
+			}
+
+			// jmp/jcc rel32 to the native code of an opcode (or the shared exit)
+			void jump(size_t target) { bytes({0xE9}); fixups.push_back({code.size(), target}); imm32(0); }
+			void jump_if_not_zero(size_t target) { bytes({0x0F, 0x85}); fixups.push_back({code.size(), target}); imm32(0); }
+			void jump_if_above_equal(size_t target) { bytes({0x0F, 0x83}); fixups.push_back({code.size(), target}); imm32(0); }
+			// Exits to the interpreter at a known opcode
+			void exit(const opcode* pc) { bytes({0x48, 0xB8}); imm64((size_t)pc); jump(exit_target); }
+			// Exits to the interpreter at a known opcode, jumping through a (writable) slot so the exit can later be redirected
+			void exit_through(const opcode* pc, const void* const* slot) {
+				bytes({0x48, 0xB8}); imm64((size_t)pc); // mov rax, pc
+				bytes({0x48, 0xB9}); imm64((size_t)slot); // mov rcx, slot
+				bytes({0xFF, 0x21}); // jmp [rcx]
+			}
+			constexpr static uint8_t exit_through_size = 22;
+			// rax = pc + rcx (measured in opcodes)
+			void relative_target(const opcode* pc) {
+				bytes({0x48, 0xC1, 0xE1, std::countr_zero(sizeof(opcode))}); // shl rcx, log2(sizeof(opcode))
+				bytes({0x48, 0xB8}); imm64((size_t)pc); // mov rax, pc
+				bytes({0x48, 0x01, 0xC8}); // add rax, rcx
+			}
+			// Jumps to the native code of the opcode stored in rax (exiting to the interpreter if it isn't part of the compiled program)
+			void dispatch_rax(size_t program_size) {
+				bytes({0x48, 0x89, 0xC1}); // mov rcx, rax
+				bytes({0x4C, 0x29, 0xF9}); // sub rcx, r15
+				bytes({0x48, 0x81, 0xF9}); imm32(program_size * sizeof(opcode)); // cmp rcx, size
+				jump_if_above_equal(exit_target);
+				bytes({0xF6, 0xC1, sizeof(opcode) - 1}); // test cl, alignment
+				jump_if_not_zero(exit_target);
+				bytes({0x48, 0xC1, 0xE9, std::countr_zero(sizeof(opcode))}); // shr rcx, log2(sizeof(opcode))
+				bytes({0x41, 0xFF, 0x24, 0xCE}); // jmp [r14 + rcx * 8]
+			}
+
+			void entry() {
+				bytes({0x53, 0x55, 0x41, 0x54, 0x41, 0x55, 0x41, 0x56, 0x41, 0x57}); // push rbx, rbp, r12, r13, r14, r15
+				bytes({0x48, 0x83, 0xEC, 0x08}); // sub rsp, 8 (keep the native stack 16 byte aligned for call outs)
+				bytes({0x48, 0x89, 0xFB}); // mov rbx, rdi
+				bytes({0x49, 0x89, 0xF4}); // mov r12, rsi
+				bytes({0x49, 0x89, 0xD5}); // mov r13, rdx
+				bytes({0x4D, 0x89, 0xC6}); // mov r14, r8
+				bytes({0x4D, 0x89, 0xCF}); // mov r15, r9
+				bytes({0xFF, 0xE1}); // jmp rcx
+			}
+			void shared_exit() {
+				bytes({0x4C, 0x89, 0xEA}); // mov rdx, r13
+				bytes({0x48, 0x83, 0xC4, 0x08}); // add rsp, 8
+				bytes({0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5D, 0x41, 0x5C, 0x5D, 0x5B}); // pop r15, r14, r13, r12, rbp, rbx
+				bytes({0xC3}); // ret
+			}
+
+			// Calls an instruction on a copy of its opcode which is followed by resume_caller
+			void call_out(const opcode* copy) {
+				bytes({0x48, 0xBF}); imm64((size_t)copy); // mov rdi, copy
+				bytes({0x48, 0x89, 0xDE}); // mov rsi, rbx
+				bytes({0x4C, 0x89, 0xE2}); // mov rdx, r12
+				bytes({0x4C, 0x89, 0xE9}); // mov rcx, r13
+				bytes({0x48, 0xB8}); imm64((size_t)copy->op); // mov rax, instruction
+				bytes({0xFF, 0xD0}); // call rax
+#ifndef MIZU_LOOP_DISPATCH
+				bytes({0x49, 0x89, 0xC5}); // mov r13, rax (resume_caller returns the stack pointer)
+#else
+				bytes({0x4D, 0x8B, 0xAC, 0x24}); imm32(offsetof(registers_and_stack, stack_pointer)); // mov r13, [r12 + stack_pointer]
+#endif
+			}
+
+			// rax = function(env, rsi)
+			void call_with_env(const void* function) {
+				bytes({0x4C, 0x89, 0xE7}); // mov rdi, r12
+				bytes({0x48, 0xB8}); imm64((size_t)function); // mov rax, function
+				bytes({0xFF, 0xD0}); // call rax
+			}
+
+			void patch(const std::vector<size_t>& native_offsets, size_t exit_offset) {
+				for(auto& fix: fixups) {
+					size_t target = fix.target == exit_target ? exit_offset : native_offsets[fix.target];
+					int32_t relative = int64_t(target) - int64_t(fix.location + 4);
+					std::memcpy(code.data() + fix.location, &relative, 4);
+				}
+			}
+		};
+
+		/**
+		 * Emits the stencil for an instruction which doesn't change the flow of execution
+		 * @note Instructions without a stencil are called on \p copy (which must live as long as the generated code) if they don't depend on the program counter.
+		 *
+		 * @param as the assembler to emit into
+		 * @param pc the opcode to emit
+		 * @param copy space for two opcodes to call the instruction on (if needed)
+		 * @return true if the instruction was emitted, false if it depends on the program counter
+		 */
+		inline bool emit_straight_line(assembler& as, const opcode* pc, opcode* copy) {
+			auto op = pc->op;
+			if(op == label || op == debug::breakpoint) {
+				// Noops
+			} else if(op == load_immediate) {
+				as.move_rax(*(uint32_t*)&pc->a);
+				as.store_rax(pc->out);
+			} else if(op == load_upper_immediate) {
+				as.bytes({0x48, 0xB8}); as.imm64(uint64_t(*(uint32_t*)&pc->a) << 32); // mov rax, immediate << 32
+				if(pc->out) { as.bytes({0x48, 0x09, 0x83}); as.displacement(pc->out); } // or [rbx + out], rax
+			} else if(op == convert_to_u64 || op == convert_to_i64) {
+				as.load_rax(pc->a);
+				as.store_rax(pc->out);
+			} else if(op == convert_to_i32 || op == convert_to_i16 || op == convert_to_i8) {
+				if(op == convert_to_i32) as.bytes({0x48, 0x63, 0x83}); // movsxd rax, dword [rbx + a]
+				else if(op == convert_to_i16) as.bytes({0x48, 0x0F, 0xBF, 0x83}); // movsx rax, word [rbx + a]
+				else as.bytes({0x48, 0x0F, 0xBE, 0x83}); // movsx rax, byte [rbx + a]
+				as.displacement(pc->a);
+				as.store_rax(pc->out);
+			} else if(op == convert_to_u32 || op == convert_to_u16 || op == convert_to_u8) {
+				// Only the bottom bits of the output are replaced
+				if(pc->out) {
+					if(op == convert_to_u32) as.bytes({0x8B, 0x83}); // mov eax, [rbx + a]
+					else if(op == convert_to_u16) as.bytes({0x66, 0x8B, 0x83}); // mov ax, [rbx + a]
+					else as.bytes({0x8A, 0x83}); // mov al, [rbx + a]
+					as.displacement(pc->a);
+					if(op == convert_to_u32) as.bytes({0x89, 0x83}); // mov [rbx + out], eax
+					else if(op == convert_to_u16) as.bytes({0x66, 0x89, 0x83}); // mov [rbx + out], ax
+					else as.bytes({0x88, 0x83}); // mov [rbx + out], al
+					as.displacement(pc->out);
+				}
+			} else if(op == stack_load_u64 || op == stack_load_u32 || op == stack_load_u16 || op == stack_load_u8 || op == stack_load_i32 || op == stack_load_i16 || op == stack_load_i8
+				|| op == stack_load_u64_immediate || op == stack_load_u32_immediate || op == stack_load_u16_immediate || op == stack_load_u8_immediate
+				|| op == stack_load_i32_immediate || op == stack_load_i16_immediate || op == stack_load_i8_immediate) {
+				if(op == stack_load_u64 || op == stack_load_u32 || op == stack_load_u16 || op == stack_load_u8 || op == stack_load_i32 || op == stack_load_i16 || op == stack_load_i8)
+					as.load_rax(pc->a);
+				else as.move_rax(int64_t(*(int16_t*)&pc->b));
+				if(op == stack_load_u64 || op == stack_load_u64_immediate) as.bytes({0x49, 0x8B, 0x44, 0x05, 0x00}); // mov rax, [r13 + rax]
+				else if(op == stack_load_u32 || op == stack_load_u32_immediate) as.bytes({0x41, 0x8B, 0x44, 0x05, 0x00}); // mov eax, [r13 + rax]
+				else if(op == stack_load_u16 || op == stack_load_u16_immediate) as.bytes({0x41, 0x0F, 0xB7, 0x44, 0x05, 0x00}); // movzx eax, word [r13 + rax]
+				else if(op == stack_load_u8 || op == stack_load_u8_immediate) as.bytes({0x41, 0x0F, 0xB6, 0x44, 0x05, 0x00}); // movzx eax, byte [r13 + rax]
+				else if(op == stack_load_i32 || op == stack_load_i32_immediate) as.bytes({0x49, 0x63, 0x44, 0x05, 0x00}); // movsxd rax, dword [r13 + rax]
+				else if(op == stack_load_i16 || op == stack_load_i16_immediate) as.bytes({0x49, 0x0F, 0xBF, 0x44, 0x05, 0x00}); // movsx rax, word [r13 + rax]
+				else as.bytes({0x49, 0x0F, 0xBE, 0x44, 0x05, 0x00}); // movsx rax, byte [r13 + rax]
+				as.store_rax(pc->out);
+			} else if(op == stack_store_u64 || op == stack_store_u32 || op == stack_store_u16 || op == stack_store_u8
+				|| op == stack_store_u64_immediate || op == stack_store_u32_immediate || op == stack_store_u16_immediate || op == stack_store_u8_immediate) {
+				if(op == stack_store_u64 || op == stack_store_u32 || op == stack_store_u16 || op == stack_store_u8)
+					as.load_rcx(pc->b);
+				else { as.bytes({0x48, 0xC7, 0xC1}); as.imm32(int32_t(*(int16_t*)&pc->b)); } // mov rcx, immediate (sign extended)
+				as.load_rax(pc->a);
+				if(op == stack_store_u64 || op == stack_store_u64_immediate) as.bytes({0x49, 0x89, 0x44, 0x0D, 0x00}); // mov [r13 + rcx], rax
+				else if(op == stack_store_u32 || op == stack_store_u32_immediate) as.bytes({0x89, 0xC0, 0x41, 0x89, 0x44, 0x0D, 0x00}); // mov eax, eax; mov [r13 + rcx], eax
+				else if(op == stack_store_u16 || op == stack_store_u16_immediate) as.bytes({0x0F, 0xB7, 0xC0, 0x66, 0x41, 0x89, 0x44, 0x0D, 0x00}); // movzx eax, ax; mov [r13 + rcx], ax
+				else as.bytes({0x0F, 0xB6, 0xC0, 0x41, 0x88, 0x44, 0x0D, 0x00}); // movzx eax, al; mov [r13 + rcx], al
+				as.store_rax(pc->out);
+			} else if(op == stack_push || op == stack_pop) {
+				as.load_rax(pc->a);
+				if(op == stack_push) as.bytes({0x49, 0x29, 0xC5}); // sub r13, rax
+				else as.bytes({0x49, 0x01, 0xC5}); // add r13, rax
+			} else if(op == unsafe::load_u64 || op == unsafe::load_u32 || op == unsafe::load_u16 || op == unsafe::load_u8
+				|| op == unsafe::load_i32 || op == unsafe::load_i16 || op == unsafe::load_i8 || op == unsafe::load_f32 || op == unsafe::load_f64) {
+				as.load_rax(pc->a);
+				if(op == unsafe::load_u64 || op == unsafe::load_f64) as.bytes({0x48, 0x8B, 0x80}); // mov rax, [rax + offset]
+				else if(op == unsafe::load_u32 || op == unsafe::load_f32) as.bytes({0x8B, 0x80}); // mov eax, [rax + offset]
+				else if(op == unsafe::load_u16) as.bytes({0x0F, 0xB7, 0x80}); // movzx eax, word [rax + offset]
+				else if(op == unsafe::load_u8) as.bytes({0x0F, 0xB6, 0x80}); // movzx eax, byte [rax + offset]
+				else if(op == unsafe::load_i32) as.bytes({0x48, 0x63, 0x80}); // movsxd rax, dword [rax + offset]
+				else if(op == unsafe::load_i16) as.bytes({0x48, 0x0F, 0xBF, 0x80}); // movsx rax, word [rax + offset]
+				else as.bytes({0x48, 0x0F, 0xBE, 0x80}); // movsx rax, byte [rax + offset]
+				as.imm32(int32_t(*(int16_t*)&pc->b));
+				// NOTE: f32s only replace the bottom bits of the output
+				if(op != unsafe::load_f32) as.store_rax(pc->out);
+				else if(pc->out) { as.bytes({0x89, 0x83}); as.displacement(pc->out); } // mov [rbx + out], eax
+			} else if(op == unsafe::store_u64 || op == unsafe::store_u32 || op == unsafe::store_u16 || op == unsafe::store_u8 || op == unsafe::store_f32 || op == unsafe::store_f64) {
+				as.load_rcx(pc->out);
+				as.load_rax(pc->a);
+				if(op == unsafe::store_u64 || op == unsafe::store_f64) as.bytes({0x48, 0x89, 0x81}); // mov [rcx + offset], rax
+				else if(op == unsafe::store_u32 || op == unsafe::store_f32) as.bytes({0x89, 0x81}); // mov [rcx + offset], eax
+				else if(op == unsafe::store_u16) as.bytes({0x66, 0x89, 0x81}); // mov [rcx + offset], ax
+				else as.bytes({0x88, 0x81}); // mov [rcx + offset], al
+				as.imm32(int32_t(*(int16_t*)&pc->b));
+			} else if(op == stack_push_immediate || op == stack_pop_immediate) {
+				as.move_rax(*(uint32_t*)&pc->a);
+				if(op == stack_push_immediate) as.bytes({0x49, 0x29, 0xC5}); // sub r13, rax
+				else as.bytes({0x49, 0x01, 0xC5}); // add r13, rax
+			} else if(op == set_if_equal || op == set_if_not_equal || op == set_if_less || op == set_if_less_signed || op == set_if_greater_equal || op == set_if_greater_equal_signed) {
+				uint8_t condition = op == set_if_equal ? 0x94 : op == set_if_not_equal ? 0x95 : op == set_if_less ? 0x92
+					: op == set_if_less_signed ? 0x9C : op == set_if_greater_equal ? 0x93 : 0x9D;
+				as.alu({0x48, 0x3B}, pc->a, pc->b); // cmp rax, [rbx + b]
+				as.bytes({0x0F, condition, 0xC0}); // setcc al
+				as.bytes({0x0F, 0xB6, 0xC0}); // movzx eax, al
+				as.store_rax(pc->out);
+			} else if(op == add) { as.alu({0x48, 0x03}, pc->a, pc->b); as.store_rax(pc->out); }
+			else if(op == subtract) { as.alu({0x48, 0x2B}, pc->a, pc->b); as.store_rax(pc->out); }
+			else if(op == multiply) { as.alu({0x48, 0x0F, 0xAF}, pc->a, pc->b); as.store_rax(pc->out); }
+			else if(op == bitwise_and) { as.alu({0x48, 0x23}, pc->a, pc->b); as.store_rax(pc->out); }
+			else if(op == bitwise_or) { as.alu({0x48, 0x0B}, pc->a, pc->b); as.store_rax(pc->out); }
+			else if(op == bitwise_xor) { as.alu({0x48, 0x33}, pc->a, pc->b); as.store_rax(pc->out); }
+			else if(op == select_if) {
+				as.load_rax(pc->b);
+				as.bytes({0x48, 0x83, 0xBB}); as.displacement(pc->out); as.bytes({0x00}); // cmp qword [rbx + out], 0
+				as.bytes({0x48, 0x0F, 0x45, 0x83}); as.displacement(pc->a); // cmovne rax, [rbx + a]
+				as.store_rax(pc->out);
+			} else if(op == min || op == max || op == min_signed || op == max_signed) {
+				uint8_t condition = op == min ? 0x47 : op == max ? 0x42 : op == min_signed ? 0x4F : 0x4C; // Take b if a is above/below/greater/less
+				as.alu({0x48, 0x3B}, pc->a, pc->b); // cmp rax, [rbx + b]
+				as.bytes({0x48, 0x0F, condition, 0x83}); as.displacement(pc->b); // cmovcc rax, [rbx + b]
+				as.store_rax(pc->out);
+			} else if(op == rotate_left || op == rotate_right) {
+				as.load_rcx(pc->b);
+				as.load_rax(pc->a);
+				as.bytes({0x48, 0xD3, uint8_t(op == rotate_left ? 0xC0 : 0xC8)}); // rol/ror rax, cl
+				as.store_rax(pc->out);
+			} else if(op == rotate_left_immediate || op == rotate_right_immediate) {
+				as.load_rax(pc->a);
+				as.bytes({0x48, 0xC1, uint8_t(op == rotate_left_immediate ? 0xC0 : 0xC8), uint8_t(*(int16_t*)&pc->b & 63)}); // rol/ror rax, imm8
+				as.store_rax(pc->out);
+			} else if(op == byte_swap) {
+				as.load_rax(pc->a);
+				as.bytes({0x48, 0x0F, 0xC8}); // bswap rax
+				as.store_rax(pc->out);
+			} else if(op == multiply_high || op == multiply_high_signed) {
+				as.load_rax(pc->a);
+				as.bytes({0x48, 0xF7, uint8_t(op == multiply_high ? 0xA3 : 0xAB)}); as.displacement(pc->b); // mul/imul qword [rbx + b] (rdx:rax = rax * [rbx + b])
+				as.bytes({0x48, 0x89, 0xD0}); // mov rax, rdx
+				as.store_rax(pc->out);
+			} else if(op == add_carry || op == subtract_borrow) {
+				// NOTE: Both carries (or borrows) are accumulated in rdx, at most one of them can be set
+				uint8_t operation = op == add_carry ? 0x03 : 0x2B;
+				as.bytes({0x31, 0xD2}); // xor edx, edx
+				as.load_rax(pc->a);
+				as.bytes({0x48, operation, 0x83}); as.displacement(pc->b); // add/sub rax, [rbx + b]
+				as.bytes({0x83, 0xD2, 0x00}); // adc edx, 0
+				as.bytes({0x48, operation, 0x83}); as.displacement(pc->out); // add/sub rax, [rbx + out] (the carry in)
+				as.bytes({0x83, 0xD2, 0x00}); // adc edx, 0
+				as.store_rax(pc->out);
+				as.bytes({0x48, 0x89, 0x93}); as.displacement(pc->out + 1); // mov [rbx + out + 1], rdx
+			} else if(op == multiply_wide) {
+				as.load_rax(pc->a);
+				as.bytes({0x48, 0xF7, 0xA3}); as.displacement(pc->b); // mul qword [rbx + b] (rdx:rax = rax * [rbx + b])
+				as.store_rax(pc->out);
+				as.bytes({0x48, 0x89, 0x93}); as.displacement(pc->out + 1); // mov [rbx + out + 1], rdx
+			} else if(op == abs_signed) {
+				as.load_rax(pc->a);
+				as.bytes({0x48, 0x89, 0xC1}); // mov rcx, rax
+				as.bytes({0x48, 0xF7, 0xD9}); // neg rcx
+				as.bytes({0x48, 0x0F, 0x49, 0xC1}); // cmovns rax, rcx
+				as.store_rax(pc->out);
+			}
+			else if(op == divide || op == modulus) {
+				as.load_rax(pc->a);
+				as.bytes({0x31, 0xD2}); // xor edx, edx
+				as.bytes({0x48, 0xF7, 0xB3}); as.displacement(pc->b); // div qword [rbx + b]
+				if(op == modulus) as.bytes({0x48, 0x89, 0xD0}); // mov rax, rdx
+				as.store_rax(pc->out);
+			} else if(op == divide_signed || op == modulus_signed) {
+				// NOTE: Dividing by -1 skips the idiv (which would trap for the smallest signed number)
+				as.load_rcx(pc->b);
+				as.load_rax(pc->a);
+				as.bytes({0x48, 0x83, 0xF9, 0xFF}); // cmp rcx, -1
+				if(op == divide_signed) {
+					as.bytes({0x75, 5}); // jne (over the negation)
+					as.bytes({0x48, 0xF7, 0xD8}); // neg rax
+					as.bytes({0xEB, 5}); // jmp (over the division)
+					as.bytes({0x48, 0x99}); // cqo
+					as.bytes({0x48, 0xF7, 0xF9}); // idiv rcx
+				} else {
+					as.bytes({0x75, 4}); // jne (over the zeroing)
+					as.bytes({0x31, 0xC0}); // xor eax, eax
+					as.bytes({0xEB, 8}); // jmp (over the division)
+					as.bytes({0x48, 0x99}); // cqo
+					as.bytes({0x48, 0xF7, 0xF9}); // idiv rcx
+					as.bytes({0x48, 0x89, 0xD0}); // mov rax, rdx
+				}
+				as.store_rax(pc->out);
+			} else if(op == shift_left || op == shift_right_logical || op == shift_right_arithmetic) {
+				as.load_rcx(pc->b);
+				as.load_rax(pc->a);
+				as.bytes({0x48, 0xD3, uint8_t(op == shift_left ? 0xE0 : op == shift_right_logical ? 0xE8 : 0xF8)}); // shl/shr/sar rax, cl
+				as.store_rax(pc->out);
+			} else if(op == nullptr || detail::requires_program_counter(op)) {
+				return false;
+			} else {
+				copy[0] = *pc;
+				copy[1] = opcode{detail::resume_caller};
+				as.call_out(copy);
+			}
+			return true;
+		}
+
+		/**
+		 * Emits code which compares the registers of a compare and branch instruction, leaving rax = 1 if the branch should be taken (or 0 otherwise)
+		 *
+		 * @param as the assembler to emit into
+		 * @param pc the compare and branch opcode (see mizu::detail::is_compare_and_branch)
+		 */
+		inline void emit_compare_and_branch_condition(assembler& as, const opcode* pc) {
+			auto op = pc->op;
+			if(op == loop_decrement_branch || op == loop_subtract_branch) {
+				as.load_rax(pc->a);
+				if(op == loop_decrement_branch) as.bytes({0x48, 0x83, 0xE8, 0x01}); // sub rax, 1
+				else { as.bytes({0x48, 0x2B, 0x83}); as.displacement(pc->b); } // sub rax, [rbx + b]
+				as.store_rax(pc->a);
+				as.bytes({0x48, 0x85, 0xC0}); // test rax, rax
+				as.bytes({0x0F, uint8_t(op == loop_decrement_branch ? 0x95 : 0x9F), 0xC0}); // setne/setg al
+			} else if(op == branch_if_equal || op == branch_if_not_equal || op == branch_if_less || op == branch_if_less_signed || op == branch_if_greater_equal || op == branch_if_greater_equal_signed) {
+				uint8_t condition = op == branch_if_equal ? 0x94 : op == branch_if_not_equal ? 0x95 : op == branch_if_less ? 0x92
+					: op == branch_if_less_signed ? 0x9C : op == branch_if_greater_equal ? 0x93 : 0x9D;
+				as.alu({0x48, 0x3B}, pc->a, pc->b); // cmp rax, [rbx + b]
+				as.bytes({0x0F, condition, 0xC0}); // setcc al
+			} else {
+				bool f64 = op == branch_if_equal_f64 || op == branch_if_not_equal_f64 || op == branch_if_less_f64 || op == branch_if_greater_equal_f64;
+				bool less = op == branch_if_less_f32 || op == branch_if_less_f64;
+				// NOTE: Comparisons with NaN are unordered (setting ZF, PF, and CF) and must be false (true for not equal)
+				auto [first, second] = less ? std::pair{pc->b, pc->a} : std::pair{pc->a, pc->b}; // a < b is checked as b > a
+				if(f64) as.bytes({0xF2, 0x0F, 0x10, 0x83}); // movsd xmm0, [rbx + first]
+				else as.bytes({0xF3, 0x0F, 0x10, 0x83}); // movss xmm0, [rbx + first]
+				as.displacement(first);
+				if(f64) as.bytes({0x66, 0x0F, 0x2E, 0x83}); // ucomisd xmm0, [rbx + second]
+				else as.bytes({0x0F, 0x2E, 0x83}); // ucomiss xmm0, [rbx + second]
+				as.displacement(second);
+				if(less) as.bytes({0x0F, 0x97, 0xC0}); // seta al
+				else if(op == branch_if_greater_equal_f32 || op == branch_if_greater_equal_f64) as.bytes({0x0F, 0x93, 0xC0}); // setae al
+				else if(op == branch_if_equal_f32 || op == branch_if_equal_f64) as.bytes({0x0F, 0x94, 0xC0, 0x0F, 0x9B, 0xC1, 0x20, 0xC8}); // sete al; setnp cl; and al, cl
+				else as.bytes({0x0F, 0x95, 0xC0, 0x0F, 0x9A, 0xC1, 0x08, 0xC8}); // setne al; setp cl; or al, cl
+			}
+			as.bytes({0x0F, 0xB6, 0xC0}); // movzx eax, al
+		}
+
+		/**
+		 * Emits code which performs a call_to or return_to (maintaining the shadow stack), leaving rax = the address of the opcode to continue from
+		 *
+		 * @param as the assembler to emit into
+		 * @param pc the call_to or return_to opcode
+		 */
+		inline void emit_call_or_return(assembler& as, const opcode* pc) {
+			if(pc->op == call_to) {
+				as.move_rax((size_t)(pc + 1));
+				as.store_rax(pc->out);
+				as.bytes({0x48, 0xBE}); as.imm64((size_t)(pc + 1)); // mov rsi, pc + 1
+				as.call_with_env((const void*)&shadow_stack_push);
+				as.load_rax(pc->a);
+			} else {
+				as.load_rsi(pc->a);
+				as.call_with_env((const void*)&shadow_stack_pop);
+			}
+		}
+
+		/**
+		 * Read only executable memory holding generated code
+		 */
+		struct executable_memory {
+			uint8_t* code = nullptr;
+			size_t size = 0;
+
+			executable_memory() = default;
+			/**
+			 * Copies generated \p code into newly allocated executable memory
+			 */
+			executable_memory(const std::vector<uint8_t>& generated) : size(generated.size()) {
+				void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+				if(memory == MAP_FAILED) MIZU_THROW(std::runtime_error("Failed to allocate memory for JIT compiled code"));
+				std::memcpy(memory, generated.data(), size);
+				if(mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+					munmap(memory, size);
+					MIZU_THROW(std::runtime_error("Failed to make JIT compiled code executable"));
+				}
+				code = (uint8_t*)memory;
+			}
+			executable_memory(const executable_memory&) = delete;
+			executable_memory(executable_memory&& o) { *this = std::move(o); }
+			executable_memory& operator=(const executable_memory&) = delete;
+			executable_memory& operator=(executable_memory&& o) {
+				std::swap(code, o.code);
+				std::swap(size, o.size);
+				return *this;
+			}
+			~executable_memory() { if(code) munmap(code, size); }
+
+			/**
+			 * Enters the generated code (which must start with an entry stub)
+			 */
+			exit_state enter(uint64_t* registers, registers_and_stack* env, uint8_t* sp, const void* target, const void* const* native_table = nullptr, const opcode* program_start = nullptr) const {
+				return ((entry_t)code)(registers, env, sp, target, native_table, program_start);
+			}
+		};
+	}
+}
+
+namespace mizu { inline namespace jit {
+	/**
+	 * A Mizu program which has been compiled to native machine code
+	 * @note Construct using mizu::jit::compile
+	 * @note The compiled code references the opcodes of the source program, which thus must outlive it.
+	 */
+	struct compiled_program {
+		/**
+		 * Program the machine code was generated from
+		 */
+		fp::view<const opcode> program = {nullptr, 0};
+		/**
+		 * Executable memory holding the compiled code
+		 */
+		detail::executable_memory code;
+		/**
+		 * Native address of each opcode in the program
+		 */
+		std::vector<const void*> native;
+		/**
+		 * Copies of the opcodes which are called out to (each followed by a resume_caller opcode)
+		 */
+		std::vector<opcode> call_outs;
+
+		/**
+		 * Checks if an opcode is part of the compiled program
+		 */
+		bool contains(const opcode* pc) const { return pc >= program.data() && pc < program.data() + program.size(); }
+	};
+
+	/**
+	 * Compiles a Mizu program to x86-64 machine code by stitching together precompiled stencils for each instruction and patching their operands in place
+	 * @note The compiled code keeps Mizu's registers in memory so it can freely exit back into the interpreter,
+	 *	instructions without a stencil that don't use the program counter are called directly from the compiled code
+	 *	while those which do (halt, fork_relative, etc...) exit to the interpreter.
+	 * @note find_label instructions are resolved during compilation, searching the whole program.
+	 * @note Stack bound assertions are not checked by compiled code.
+	 *
+	 * @param program The program to compile (which must outlive the compiled program)
+	 * @return compiled_program the compiled program
+	 */
+	inline compiled_program compile(fp::view<const opcode> program) {
+		compiled_program out;
+		out.program = program;
+		out.call_outs.resize(program.size() * 2);
+
+		detail::assembler as;
+		as.entry();
+		size_t exit_offset = as.code.size();
+		as.shared_exit();
+
+		auto in_program = [&](size_t i, int64_t offset) {
+			auto target = int64_t(i) + offset;
+			return target >= 0 && target < int64_t(program.size());
+		};
+
+		std::vector<size_t> native_offsets(program.size());
+		for(size_t i = 0; i < program.size(); ++i) {
+			native_offsets[i] = as.code.size();
+			auto pc = &program[i];
+			auto op = pc->op;
+			auto next = (size_t)(pc + 1);
+
+			if(op == find_label) {
+				as.move_rax((size_t)detail::find_label_target(pc, program.data(), program.data() + program.size()));
+				as.store_rax(pc->out);
+			} else if(op == load_relative_address) {
+				as.move_rax((size_t)(pc + *(int32_t*)&pc->a));
+				as.store_rax(pc->out);
+			} else if(detail::emit_straight_line(as, pc, &out.call_outs[i * 2])) {
+				// Stencil emitted
+			} else if(op == jump_relative_immediate) {
+				auto offset = *(int32_t*)&pc->a;
+				as.move_rax(next);
+				as.store_rax(pc->out);
+				if(in_program(i, offset)) as.jump(i + offset);
+				else as.exit(pc + offset);
+			} else if(op == branch_relative_immediate) {
+				auto offset = *(int16_t*)&pc->b;
+				as.move_rax(next);
+				as.store_rax(pc->out);
+				// NOTE: The condition is read after the return address is written (so if they are the same register the branch is always taken)
+				if(pc->a == pc->out) {
+					if(in_program(i, offset)) as.jump(i + offset);
+					else as.exit(pc + offset);
+				} else if(pc->a != 0) {
+					as.bytes({0x48, 0x83, 0xBB}); as.displacement(pc->a); as.bytes({0x00}); // cmp qword [rbx + a], 0
+					if(in_program(i, offset)) as.jump_if_not_zero(i + offset);
+					else {
+						as.bytes({0x74, 15}); // je (over the exit)
+						as.exit(pc + offset);
+					}
+				}
+			} else if(detail::is_compare_and_branch(op)) {
+				auto offset = *(int16_t*)&pc->out;
+				detail::emit_compare_and_branch_condition(as, pc);
+				as.bytes({0x48, 0x85, 0xC0}); // test rax, rax
+				if(in_program(i, offset)) as.jump_if_not_zero(i + offset);
+				else {
+					as.bytes({0x74, 15}); // je (over the exit)
+					as.exit(pc + offset);
+				}
+			} else if(op == jump_relative || op == jump_to) {
+				if(op == jump_relative) {
+					as.load_rcx(pc->a);
+					as.move_rax(next);
+					as.store_rax(pc->out);
+					as.relative_target(pc);
+				} else {
+					as.move_rax(next);
+					as.store_rax(pc->out);
+					as.load_rax(pc->a);
+				}
+				as.dispatch_rax(program.size());
+			} else if(op == call_to || op == return_to) {
+				detail::emit_call_or_return(as, pc);
+				as.dispatch_rax(program.size());
+			} else if(op == branch_relative || op == branch_to) {
+				as.move_rax(next);
+				as.store_rax(pc->out);
+				as.load_rax(pc->a);
+				as.bytes({0x48, 0x85, 0xC0}); // test rax, rax
+				auto skip = as.code.size();
+				as.bytes({0x0F, 0x84}); as.imm32(0); // je (over the dispatch)
+				if(op == branch_relative) {
+					as.load_rcx(pc->b);
+					as.relative_target(pc);
+				} else as.load_rax(pc->b);
+				as.dispatch_rax(program.size());
+				int32_t relative = as.code.size() - (skip + 6);
+				std::memcpy(as.code.data() + skip + 2, &relative, 4);
+			} else {
+				as.exit(pc);
+				continue; // NOTE: The exit already leaves, no fallthrough to the next instruction
+			}
+
+			// Fall through to the next instruction (exiting if it is past the end of the program)
+			if(i + 1 == program.size()) as.exit(pc + 1);
+		}
+		as.patch(native_offsets, exit_offset);
+
+		out.code = detail::executable_memory(as.code);
+
+		out.native.resize(program.size());
+		for(size_t i = 0; i < program.size(); ++i)
+			out.native[i] = out.code.code + native_offsets[i];
+		return out;
+	}
+
+	/**
+	 * Executes a JIT compiled program starting at \p pc until it halts
+	 * @note Once the compiled code exits (for an instruction it can't handle) execution continues in the interpreter.
+	 *
+	 * @param compiled The compiled program
+	 * @param pc The first instruction to execute
+	 * @param registers The registers to execute with
+	 * @param env The environment to execute in
+	 * @param sp The initial stack pointer
+	 * @return void* the value returned by the halting instruction
+	 */
+	inline void* execute(const compiled_program& compiled, opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) {
+		if(compiled.contains(pc)) {
+			auto exit = compiled.code.enter(registers, env, sp, compiled.native[pc - compiled.program.data()], compiled.native.data(), compiled.program.data());
+			pc = exit.pc;
+			sp = exit.sp;
+			if(!pc) return nullptr;
+		}
+		return mizu::execute(pc, registers, env, sp);
+	}
+
+	/**
+	* Starts executing the provide JIT compiled program in the provided environment
+	* @param compiled The compiled program to execute
+	* @param env The environment to execute \p program in
+	*/
+	#define MIZU_START_JIT_FROM_ENVIRONMENT(compiled, env) mizu::jit::execute(compiled, const_cast<mizu::opcode*>((compiled).program.data()), env.memory.data(), &env, env.stack_bottom)
+}}
@@ -4,6 +4,7 @@
 #endif
 #include <fp/pointer.hpp>
 #include <fp/dynarray.hpp>
+#include <vector>
 
 #ifndef MIZU_REGISTER_INSTRUCTION
 #define MIZU_REGISTER_INSTRUCTION(name)
@@ -34,6 +35,10 @@
 	#define MIZU_MAIN(...) int main(const int argc, const char** argv __VA_ARGS__)
 #endif
 
+#if defined(MIZU_LOOP_DISPATCH) && defined(MIZU_NO_HARDWARE_THREADS)
+	#error "Loop dispatch is not supported alongside emulated (coroutine) threads"
+#endif
+
 #ifdef MIZU_ENABLE_TRACING
 	#include <iostream>
 	#define MIZU_TRACE(pc) (std::cout << __FUNCTION__ << "(" << pc->out << ", " << pc->a << ", " << pc->b << ")" << std::endl)
@@ -84,16 +89,53 @@ namespace mizu {
 	 */
 	using instruction_t = void*(*)(struct opcode* pc, uint64_t* registers, struct registers_and_stack* env, uint8_t* sp);
 
+#ifdef MIZU_COMPACT_OPCODES
+	namespace detail {
+		/**
+		 * Table mapping instruction IDs to their function pointers, filled in as instructions are registered with the lookup system
+		 * @note Defined in instructions/lookup.hpp
+		 */
+		extern std::vector<instruction_t> handler_table;
+	}
+
+	/**
+	 * 16bit index into the handler table which compact opcodes store in place of an instruction_t
+	 * @note The index of an instruction is the same as its serialization ID.
+	 */
+	struct instruction_index {
+		uint16_t id = 0;
+
+		constexpr instruction_index() = default;
+		/**
+		 * Finds the index of the provided instruction
+		 * @note The instruction must already be registered with the lookup system (implemented in instructions/lookup.hpp)
+		 *
+		 * @param ptr the instruction to find the index of
+		 */
+		instruction_index(instruction_t ptr);
+
+		/**
+		 * Looks up the function pointer this index refers to
+		 */
+		operator instruction_t() const { return detail::handler_table[id]; }
+	};
+#endif
+
 	/**
 	 * Type which holds an instruction and (upto) 3 registers for it to act upon.
 	 * @note Since instruction_t is a pointer, this struct will have different sizes on different machines.
 	 * 	Thus Mizu binaries are only compatible with machines of the same pointer size and endianness.
+	 * @note When MIZU_COMPACT_OPCODES is defined the instruction is instead stored as a 16bit index, making every opcode 8 bytes.
 	 */
 	struct opcode {
 		/**
 		 * Instruction to perform
 		 */
+#ifdef MIZU_COMPACT_OPCODES
+		instruction_index op;
+#else
 		instruction_t op;
+#endif
 		/**
 		 * Register to store the instructions result in
 		 */
@@ -125,6 +167,12 @@ namespace mizu {
 		 * @return opcode& this
 		 */
 		opcode& set_branch_immediate(const int16_t value) { (int16_t&)b = value; return *this; }
+		/**
+		 * Replaces out with a i16 immediate value (Used to determine the offsets of compare and branch instructions)
+		 *
+		 * @return opcode& this
+		 */
+		opcode& set_out_branch_immediate(const int16_t value) { (int16_t&)out = value; return *this; }
 
 		/**
 		 * Replaces a and b with a f32 immediate value
@@ -163,6 +211,31 @@ namespace mizu {
 		opcode& set_host_pointer_upper_immediate(const void* ptr) { set_immediate(((std::size_t)ptr) >> 32); return *this; }
 	};
 
+#ifdef MIZU_COMPACT_OPCODES
+	static_assert(sizeof(opcode) == 8, "Compact opcodes are expected to be 8 bytes");
+
+	/**
+	 * Opcode layout used when MIZU_COMPACT_OPCODES is not defined (storing a full function pointer)
+	 * @note Used to convert programs to and from the compact representation.
+	 */
+	struct pointer_opcode {
+		instruction_t op;
+		reg_t out, a, b;
+	};
+
+	/**
+	 * Finds the function pointer for the instruction stored in an opcode
+	 * @param pc pointer to the opcode
+	 */
+	#define MIZU_INSTRUCTION(pc) (mizu::detail::handler_table[(pc)->op.id])
+#else
+	/**
+	 * Finds the function pointer for the instruction stored in an opcode
+	 * @param pc pointer to the opcode
+	 */
+	#define MIZU_INSTRUCTION(pc) ((pc)->op)
+#endif
+
 	/**
 	 * How many registers long the memory space is.
 	 * @note set using the MIZU_STACK_SIZE (measured in kilobytes) config option.
@@ -193,6 +266,19 @@ namespace mizu {
 		 */
 		uint8_t* stack_bottom;
 
+#ifdef MIZU_LOOP_DISPATCH
+		/**
+		 * Stack pointer handed back to the dispatch loop by the last instruction
+		 * @note only present when MIZU_LOOP_DISPATCH is defined
+		 */
+		uint8_t* stack_pointer = nullptr;
+		/**
+		 * Register window handed back to the dispatch loop by the last windowed call or return (see mizu::call_windowed)
+		 * @note only present when MIZU_LOOP_DISPATCH is defined
+		 */
+		uint64_t* register_window = nullptr;
+#endif
+
 		/**
 		 * Pointer to the start of the program
 		 */
@@ -202,6 +288,30 @@ namespace mizu {
 		 */
 		const opcode* program_end = nullptr;
 
+		/**
+		 * Return addresses of the calls (see mizu::call_to) which haven't returned yet
+		 * @note Only the outermost MIZU_SHADOW_STACK_SIZE calls are remembered, returns from calls nested deeper than that use their return address register
+		 * @note set using the MIZU_SHADOW_STACK_SIZE config option.
+		 */
+		const opcode* shadow_stack[MIZU_SHADOW_STACK_SIZE];
+		/**
+		 * How many calls haven't returned yet (may be larger than MIZU_SHADOW_STACK_SIZE)
+		 */
+		size_t shadow_stack_depth = 0;
+		/**
+		 * Constants loaded by mizu::load_constant (usually copied out of a mizu::constant_pool)
+		 */
+		std::vector<uint64_t> constants;
+
+		/**
+		 * How many of the innermost windowed calls (see mizu::call_windowed) ran out of room to slide the register window and spilled registers instead
+		 */
+		size_t spilled_windows = 0;
+		/**
+		 * Registers spilled by windowed calls, the innermost call's are at the end
+		 */
+		std::vector<uint64_t> spilled_registers;
+
 		/**
 		 * Calculates where the program starts (or a estimate based on the current program counter if null)
 		 * 
@@ -239,6 +349,9 @@ namespace mizu {
 		env.stack_bottom = (uint8_t*)(env.memory.data() + env.memory.size());
 		env.program_start = program_start;
 		env.program_end = program_end;
+		env.shadow_stack_depth = 0;
+		env.spilled_windows = 0;
+		env.spilled_registers.clear();
 	}
 
 	/**
@@ -266,18 +379,59 @@ namespace mizu {
 /** @}*/
 
 #ifndef MIZU_NO_HARDWARE_THREADS
+	#ifndef MIZU_LOOP_DISPATCH
 	/**
 	* Executes the next instruction
 	* @note assumes all of the variables defined in the signature of instruction_t are available
 	*/
-	#define MIZU_NEXT()  MIZU_TRACE(pc); registers[0] = 0; ++pc; MIZU_TAIL_CALL return pc->op(pc, registers, env, sp)
+	#define MIZU_NEXT()  MIZU_TRACE(pc); registers[0] = 0; ++pc; MIZU_TAIL_CALL return MIZU_INSTRUCTION(pc)(pc, registers, env, sp)
+	/**
+	* Executes the next instruction without resetting x0
+	* @note Only valid in instructions which provably never write to x0
+	*/
+	#define MIZU_NEXT_WITHOUT_ZERO_RESET()  MIZU_TRACE(pc); ++pc; MIZU_TAIL_CALL return MIZU_INSTRUCTION(pc)(pc, registers, env, sp)
+	#else // MIZU_LOOP_DISPATCH
+	/**
+	* Returns the next instruction to the dispatch loop in mizu::execute
+	* @note assumes all of the variables defined in the signature of instruction_t are available
+	* @note The stack pointer is handed back to the loop through the environment
+	*/
+	#define MIZU_NEXT()  MIZU_TRACE(pc); registers[0] = 0; env->stack_pointer = sp; return ++pc
+	/**
+	* Returns the next instruction to the dispatch loop in mizu::execute without resetting x0
+	* @note Only valid in instructions which provably never write to x0
+	*/
+	#define MIZU_NEXT_WITHOUT_ZERO_RESET()  MIZU_TRACE(pc); env->stack_pointer = sp; return ++pc
+	#endif // MIZU_LOOP_DISPATCH
+
+	/**
+	* Executes instructions starting at \p pc until the program halts
+	* @note When MIZU_LOOP_DISPATCH is defined instructions return the next opcode instead of tail calling it,
+	*	this function then runs them in a loop so that the native stack never grows (for compilers which can't guarantee tail calls)
+	*
+	* @param pc The first instruction to execute
+	* @param registers The registers to execute with
+	* @param env The environment to execute in
+	* @param sp The initial stack pointer
+	* @return void* the value returned by the halting instruction
+	*/
+	inline void* execute(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) {
+	#ifdef MIZU_LOOP_DISPATCH
+		env->stack_pointer = sp;
+		env->register_window = registers;
+		while(pc) pc = (opcode*)MIZU_INSTRUCTION(pc)(pc, env->register_window, env, env->stack_pointer);
+		return nullptr;
+	#else
+		return MIZU_INSTRUCTION(pc)(pc, registers, env, sp);
+	#endif
+	}
 
 	/**
 	* Starts executing the provide program in the provided environment
 	* @param program The program to execute
 	* @param env The environment to execute \p program in
 	*/
-	#define MIZU_START_FROM_ENVIRONMENT(program, env) const_cast<mizu::opcode*>(program)->op(const_cast<mizu::opcode*>(program), env.memory.data(), &env, env.stack_bottom)
+	#define MIZU_START_FROM_ENVIRONMENT(program, env) mizu::execute(const_cast<mizu::opcode*>(program), env.memory.data(), &env, env.stack_bottom)
 #else // MIZU_NO_HARDWARE_THREADS
 	struct coroutine {
 		struct execution_context {
@@ -313,13 +467,13 @@ namespace mizu {
 
 			if(fpda_size(contexts) == 1) {
 				get_current_context().program_counter = ++pc;
-				MIZU_TAIL_CALL return pc->op(pc, env, sp);
+				MIZU_TAIL_CALL return MIZU_INSTRUCTION(pc)(pc, env, sp);
 			} else get_current_context().program_counter = pc; // Make sure pc updates (jumps) are recorded
 
 			auto& context = get_context(next_context());
 			if(!context.program_counter) return next(pc, registers, env, context.stack_pointer); // If this context is done... recursively run the next one
 			pc = ++context.program_counter;
-			MIZU_TAIL_CALL return pc->op(pc, context.environment->memory, context.environment, context.stack_pointer);
+			MIZU_TAIL_CALL return MIZU_INSTRUCTION(pc)(pc, context.environment->memory, context.environment, context.stack_pointer);
 		}
 
 		static void start(opcode* program_counter, registers_and_stack* environment) {
@@ -342,6 +496,7 @@ namespace mizu {
 	};
 
 	#define MIZU_NEXT() MIZU_TRACE(pc); registers[0] = 0; MIZU_TAIL_CALL return mizu::coroutine::next(pc, registers, env, sp)
+	#define MIZU_NEXT_WITHOUT_ZERO_RESET() MIZU_TRACE(pc); MIZU_TAIL_CALL return mizu::coroutine::next(pc, registers, env, sp)
 
 	#define MIZU_START_FROM_ENVIRONMENT(program, env) [](mizu::opcode* program_counter, registers_and_stack* environment) -> void* {\
 		mizu::coroutine::start(program_counter, environment);\
@@ -0,0 +1,263 @@
+#pragma once
+
+#include "../instructions/core.hpp"
+#include "../instructions/f64.hpp"
+#include "../instructions/fused.hpp"
+
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace mizu {
+	namespace detail {
+		/**
+		 * A pair of consecutive instructions which can be replaced by a single fused instruction
+		 */
+		struct fusion_rule {
+			instruction_t first, second, fused;
+		};
+
+		/**
+		 * List of instruction pairs which mizu::optimize::fuse replaces
+		 * @note Custom fused instructions can be added to this list (they should also be added to the set of program counter dependent instructions if single stepping or JIT compilation is used).
+		 */
+		inline std::vector<fusion_rule>& fusion_rules() {
+			static std::vector<fusion_rule> rules = {
+				{load_immediate, stack_load_u64, fused::load_immediate_stack_load_u64},
+				{load_immediate, stack_store_u64, fused::load_immediate_stack_store_u64},
+				{load_immediate, add, fused::load_immediate_add},
+				{load_immediate, subtract, fused::load_immediate_subtract},
+				{set_if_equal, branch_relative_immediate, fused::set_if_equal_branch_relative_immediate},
+				{set_if_not_equal, branch_relative_immediate, fused::set_if_not_equal_branch_relative_immediate},
+				{set_if_less, branch_relative_immediate, fused::set_if_less_branch_relative_immediate},
+				{set_if_greater_equal, branch_relative_immediate, fused::set_if_greater_equal_branch_relative_immediate},
+				{set_if_equal, branch_to, fused::set_if_equal_branch_to},
+				{set_if_not_equal, branch_to, fused::set_if_not_equal_branch_to},
+				{set_if_less, branch_to, fused::set_if_less_branch_to},
+				{set_if_greater_equal, branch_to, fused::set_if_greater_equal_branch_to},
+			};
+			return rules;
+		}
+
+		/**
+		 * An instruction reading two registers and the version of it which instead takes its second operand as an immediate
+		 */
+		struct immediate_rule {
+			instruction_t registers, immediate;
+			bool commutative; // Weather or not the operands can be swapped (so a constant in a can also be folded)
+			bool only_reads_a = false; // Weather or not the register version only reads a (like a stack load's offset), in which case the constant must be in a
+		};
+
+		/**
+		 * List of instructions which mizu::optimize::fold_immediates can replace with their immediate versions
+		 */
+		inline std::vector<immediate_rule>& immediate_rules() {
+			static std::vector<immediate_rule> rules = {
+				{set_if_equal, set_if_equal_immediate, true},
+				{set_if_not_equal, set_if_not_equal_immediate, true},
+				{set_if_less, set_if_less_immediate, false},
+				{set_if_less_signed, set_if_less_signed_immediate, false},
+				{set_if_greater_equal, set_if_greater_equal_immediate, false},
+				{set_if_greater_equal_signed, set_if_greater_equal_signed_immediate, false},
+				{add, add_immediate, true},
+				{subtract, subtract_immediate, false},
+				{multiply, multiply_immediate, true},
+				{divide, divide_immediate, false},
+				{modulus, modulus_immediate, false},
+				{divide_signed, divide_signed_immediate, false},
+				{modulus_signed, modulus_signed_immediate, false},
+				{shift_left, shift_left_immediate, false},
+				{shift_right_logical, shift_right_logical_immediate, false},
+				{shift_right_arithmetic, shift_right_arithmetic_immediate, false},
+				{bitwise_xor, bitwise_xor_immediate, true},
+				{bitwise_and, bitwise_and_immediate, true},
+				{bitwise_or, bitwise_or_immediate, true},
+				{stack_load_u64, stack_load_u64_immediate, false, true},
+				{stack_load_u32, stack_load_u32_immediate, false, true},
+				{stack_load_u16, stack_load_u16_immediate, false, true},
+				{stack_load_u8, stack_load_u8_immediate, false, true},
+				{stack_load_i32, stack_load_i32_immediate, false, true},
+				{stack_load_i16, stack_load_i16_immediate, false, true},
+				{stack_load_i8, stack_load_i8_immediate, false, true},
+				{stack_load_f32, stack_load_f32_immediate, false, true},
+				{stack_load_f64, stack_load_f64_immediate, false, true},
+				{stack_store_u64, stack_store_u64_immediate, false},
+				{stack_store_u32, stack_store_u32_immediate, false},
+				{stack_store_u16, stack_store_u16_immediate, false},
+				{stack_store_u8, stack_store_u8_immediate, false},
+				{stack_store_f32, stack_store_f32_immediate, false},
+				{stack_store_f64, stack_store_f64_immediate, false},
+			};
+			return rules;
+		}
+	}
+
+	namespace optimize {
+		/**
+		 * Replaces common pairs of instructions with fused instructions which perform both with a single dispatch
+		 * @note Only the first opcode of each pair is rewritten, the second is left in place and provides the operands for the second half of the fused instruction.
+		 *	Thus the program's size, branch offsets, and label positions are unaffected, and a jump to the second opcode of a pair still executes just that instruction.
+		 * @note Fused instructions read the opcode after them, so fused programs should be interpreted rather than single stepped or JIT compiled.
+		 *
+		 * @param program The program to optimize (modified in place)
+		 * @return size_t how many pairs were fused
+		 */
+		inline size_t fuse(fp::view<opcode> program) {
+			size_t fused = 0;
+			for(size_t i = 0; i + 1 < program.size(); ++i)
+				for(auto& rule: detail::fusion_rules())
+					if(program[i].op == rule.first && program[i + 1].op == rule.second) {
+						program[i].op = rule.fused;
+						++fused;
+						++i; // NOTE: The second opcode is executed as part of the fused instruction, no need to consider it as the start of another pair
+						break;
+					}
+			return fused;
+		}
+
+		/**
+		 * Replaces common pairs of instructions with fused instructions which perform both with a single dispatch
+		 * @see fuse(fp::view<opcode>)
+		 *
+		 * @param program The program to optimize (modified in place)
+		 * @return size_t how many pairs were fused
+		 */
+		inline size_t fuse(fp::dynarray<opcode>& program) { return fuse(program.full_view()); }
+
+		/**
+		 * Undoes mizu::optimize::fuse, restoring the original first instruction of every fused pair
+		 *
+		 * @param program The program to restore (modified in place)
+		 * @return size_t how many pairs were unfused
+		 */
+		inline size_t unfuse(fp::view<opcode> program) {
+			size_t unfused = 0;
+			for(auto& op: program)
+				for(auto& rule: detail::fusion_rules())
+					if(op.op == rule.fused) {
+						op.op = rule.first;
+						++unfused;
+						break;
+					}
+			return unfused;
+		}
+
+		/**
+		 * Removes load_immediates which only feed a constant into the next instruction, replacing that instruction with its immediate version
+		 *	(e.g. load_immediate t0, 1; subtract a0, a0, t0 becomes subtract_immediate a0, a0, 1, and load_immediate t0, 8; stack_load_u64 a2, t0 becomes stack_load_u64_immediate a2, 8)
+		 * @note A pair is only folded if the constant fits in a signed 16 bit immediate, and the register it was loaded into is overwritten (in the same straight line block) before it is read again.
+		 * @note Since opcodes are removed the program is compacted, with the offsets of relative jumps, branches (including compare and branches), forks, and addresses adjusted to match. The opcodes left over at the end of the program are replaced with halts.
+		 * @note Programs which jump through offsets stored in registers (whose targets can't be adjusted) or have been fused are left unchanged, thus immediates should be folded before fusing.
+		 *
+		 * @param program The program to optimize (modified in place)
+		 * @return size_t the number of opcodes in the folded program
+		 */
+		inline size_t fold_immediates(fp::view<opcode> program) {
+			size_t n = program.size();
+			auto find_rule = [](instruction_t op) -> const detail::immediate_rule* {
+				for(auto& rule: detail::immediate_rules())
+					if(op == rule.registers || op == rule.immediate) return &rule;
+				return nullptr;
+			};
+
+			// Find where straight line blocks begin (anywhere a jump could land)
+			std::vector<bool> block_start(n + 1, false);
+			block_start[0] = true;
+			for(size_t i = 0; i < n; ++i) {
+				auto& op = program[i];
+				if(op.op == jump_relative || op.op == branch_relative || op.op == fork_relative) return n;
+				for(auto& rule: detail::fusion_rules())
+					if(op.op == rule.fused) return n;
+
+				std::optional<int64_t> offset;
+				if(op.op == jump_relative_immediate || op.op == fork_relative_immediate || op.op == load_relative_address) offset = *(int32_t*)&op.a;
+				else if(op.op == branch_relative_immediate) offset = *(int16_t*)&op.b;
+				else if(detail::is_compare_and_branch(op.op)) offset = *(int16_t*)&op.out;
+				if(offset) {
+					if(int64_t(i) + *offset < 0 || int64_t(i) + *offset > int64_t(n)) return n;
+					block_start[i + *offset] = true;
+				}
+
+				if(op.op == label) block_start[i] = true;
+				if(op.op == jump_relative_immediate || op.op == jump_to || op.op == call_to || op.op == return_to || op.op == call_windowed || op.op == return_windowed || op.op == branch_relative_immediate || op.op == branch_to || op.op == fork_relative_immediate || op.op == halt || detail::is_compare_and_branch(op.op))
+					block_start[i + 1] = true; // NOTE: Return addresses point after jumps
+			}
+
+			// Checks if register r is overwritten (starting at opcode i) before it is read or the block ends
+			auto overwritten_before_read = [&](size_t i, reg_t r) {
+				for(size_t j = i; j < n && (j == i || !block_start[j]); ++j) {
+					auto& op = program[j];
+					if(op.op == load_immediate) {
+						if(op.out == r) return true;
+					} else if(auto rule = find_rule(op.op)) {
+						if(op.a == r || (op.op == rule->registers && !rule->only_reads_a && op.b == r)) return false;
+						if(op.out == r) return true;
+					} else return false; // Unknown instructions might read anything
+				}
+				return false;
+			};
+
+			std::vector<bool> removed(n, false);
+			for(size_t i = 0; i + 1 < n; ++i) {
+				auto& load = program[i], &op = program[i + 1];
+				auto rule = find_rule(op.op);
+				uint32_t constant = *(uint32_t*)&load.a;
+				if(load.op != load_immediate || load.out == 0 || constant > std::numeric_limits<int16_t>::max() || block_start[i + 1] || !rule || op.op != rule->registers)
+					continue;
+
+				auto folded = op;
+				if(rule->only_reads_a) {
+					if(op.a != load.out) continue;
+					folded.a = 0;
+				} else if(op.b == load.out && op.a != load.out) {
+					// Constant already in the immediate's place
+				} else if(rule->commutative && op.a == load.out && op.b != load.out)
+					folded.a = op.b;
+				else continue;
+				folded.op = rule->immediate;
+				folded.set_branch_immediate(constant);
+
+				auto original = op;
+				op = folded;
+				if(!overwritten_before_read(i + 1, load.out)) {
+					op = original;
+					continue;
+				}
+				removed[i] = true;
+				++i; // NOTE: The folded instruction can't also be the load of another pair
+			}
+
+			// Compact the program (removed opcodes map to the opcode after them)
+			std::vector<int64_t> index(n + 1);
+			size_t size = 0;
+			for(size_t i = 0; i < n; ++i) {
+				index[i] = size;
+				if(!removed[i]) ++size;
+			}
+			index[n] = size;
+			for(size_t i = 0; i < n; ++i) {
+				auto op = program[i];
+				if(removed[i]) continue;
+				if(op.op == jump_relative_immediate || op.op == fork_relative_immediate || op.op == load_relative_address)
+					op.set_immediate_signed(index[i + *(int32_t*)&op.a] - index[i]);
+				else if(op.op == branch_relative_immediate)
+					op.set_branch_immediate(index[i + *(int16_t*)&op.b] - index[i]);
+				else if(detail::is_compare_and_branch(op.op))
+					op.set_out_branch_immediate(index[i + *(int16_t*)&op.out] - index[i]);
+				program[index[i]] = op;
+			}
+			for(size_t i = size; i < n; ++i)
+				program[i] = opcode{halt};
+			return size;
+		}
+
+		/**
+		 * Removes load_immediates which only feed a constant into the next instruction, replacing that instruction with its immediate version
+		 * @see fold_immediates(fp::view<opcode>)
+		 *
+		 * @param program The program to optimize (modified in place)
+		 * @return size_t the number of opcodes in the folded program
+		 */
+		inline size_t fold_immediates(fp::dynarray<opcode>& program) { return fold_immediates(program.full_view()); }
+	}
+}
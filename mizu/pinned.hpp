@@ -0,0 +1,454 @@
+#pragma once
+
+#include "../instructions/core.hpp"
+#include "exception.hpp"
+#include "optimize.hpp"
+#include "step.hpp"
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#ifdef MIZU_LOOP_DISPATCH
+	#error "Pinned registers are carried between instructions by tail calls, and thus are not supported alongside loop dispatch"
+#endif
+
+namespace mizu {
+	/**
+	 * Opcode of a program which keeps its hottest registers (t0, a0, and ra) in host registers
+	 * @note Construct using mizu::pinned::translate
+	 */
+	struct pinned_opcode;
+
+	/**
+	 * Function pointer type representing the interface every pinned instruction is expected to have
+	 * @note The registers array is always the start of the environment's memory, so it isn't passed separately (leaving room for the pinned registers to be passed in host registers on x86-64 and ARM64)
+	 */
+	using pinned_instruction_t = void*(*)(const pinned_opcode* pc, registers_and_stack* env, uint8_t* sp, uint64_t t0, uint64_t a0, uint64_t ra);
+
+	struct pinned_opcode {
+		/**
+		 * Instruction to perform (specialized for which of its operands are pinned)
+		 */
+		pinned_instruction_t op;
+		/**
+		 * Register to store the instructions result in
+		 */
+		reg_t out;
+		/**
+		 * Register storing the first argument
+		 */
+		reg_t a;
+		/**
+		 * Register storing the second argument
+		 */
+		reg_t b;
+		/**
+		 * Instruction this opcode was translated from (run directly by instructions without a pinned implementation)
+		 */
+		instruction_t original;
+	};
+
+	namespace detail {
+		/**
+		 * Where a pinned instruction finds one of its operands
+		 */
+		enum class pinned_location : uint8_t {
+			memory, // registers[r]
+			t0, a0, ra, // Pinned in a host register
+			zero, // Unused operands and writes to x0 (which are discarded)
+			spilled, // In memory, after the pinned registers are spilled there (used for rare combinations of the other locations)
+		};
+
+		/**
+		 * Finds the variable holding an operand
+		 */
+		template<pinned_location L>
+		inline uint64_t& pinned_register(uint64_t* registers, reg_t r, uint64_t& t0, uint64_t& a0, uint64_t& ra, uint64_t& zero) {
+			if constexpr(L == pinned_location::memory || L == pinned_location::spilled) return registers[r];
+			else if constexpr(L == pinned_location::t0) return t0;
+			else if constexpr(L == pinned_location::a0) return a0;
+			else if constexpr(L == pinned_location::ra) return ra;
+			else return zero;
+		}
+
+		/**
+		 * Copies the pinned registers back into memory
+		 */
+		inline void spill_pinned_registers(uint64_t* registers, uint64_t t0, uint64_t a0, uint64_t ra) {
+			registers[registers::t(0)] = t0;
+			registers[registers::a(0)] = a0;
+			registers[registers::ra] = ra;
+		}
+
+		/**
+		 * Executes the next pinned instruction
+		 * @note assumes all of the variables defined in the signature of pinned_instruction_t are available
+		 */
+		#define MIZU_PINNED_NEXT() ++pc; MIZU_TAIL_CALL return pc->op(pc, env, sp, t0, a0, ra)
+
+		/**
+		 * Checks if an instruction has a pinned implementation
+		 */
+		constexpr bool has_pinned_handler(instruction_t op) {
+			return op == label || op == load_relative_address || op == halt
+				|| op == load_immediate || op == load_upper_immediate || op == convert_to_u64
+				|| op == convert_to_i64 || op == convert_to_i32 || op == convert_to_i16 || op == convert_to_i8
+				|| op == stack_load_u64 || op == stack_store_u64 || op == stack_push_immediate || op == stack_pop_immediate
+				|| op == stack_push_registers || op == stack_pop_registers || op == stack_push_register_mask || op == stack_pop_register_mask
+				|| op == jump_relative || op == jump_relative_immediate || op == jump_to || op == call_to || op == return_to
+				|| op == branch_relative || op == branch_relative_immediate || op == branch_to
+				|| op == branch_if_equal || op == branch_if_not_equal || op == branch_if_less || op == branch_if_less_signed
+				|| op == branch_if_greater_equal || op == branch_if_greater_equal_signed
+				|| op == branch_if_equal_f32 || op == branch_if_not_equal_f32 || op == branch_if_less_f32 || op == branch_if_greater_equal_f32
+				|| op == branch_if_equal_f64 || op == branch_if_not_equal_f64 || op == branch_if_less_f64 || op == branch_if_greater_equal_f64
+				|| op == loop_decrement_branch || op == loop_subtract_branch
+				|| op == set_if_equal || op == set_if_not_equal || op == set_if_less || op == set_if_less_signed
+				|| op == set_if_greater_equal || op == set_if_greater_equal_signed
+				|| op == add || op == subtract || op == multiply || op == divide || op == modulus || op == divide_signed || op == modulus_signed
+				|| op == shift_left || op == shift_right_logical || op == shift_right_arithmetic
+				|| op == bitwise_xor || op == bitwise_and || op == bitwise_or
+				|| op == select_if || op == min || op == max || op == min_signed || op == max_signed || op == abs_signed;
+		}
+
+		/**
+		 * Checks which operands of an instruction hold registers (rather than immediates or nothing)
+		 * @return uint8_t bitmask, 1 = out, 2 = a, 4 = b
+		 */
+		constexpr uint8_t pinned_register_operands(instruction_t op) {
+			if(op == label || op == halt || op == stack_push_immediate || op == stack_pop_immediate) return 0;
+			if(op == stack_push_registers || op == stack_pop_registers || op == stack_push_register_mask || op == stack_pop_register_mask) return 0; // NOTE: The saved registers are accessed through memory
+			if(op == load_immediate || op == load_upper_immediate || op == load_relative_address || op == jump_relative_immediate) return 1;
+			if(op == convert_to_u64 || op == stack_load_u64 || op == jump_relative || op == jump_to || op == call_to || op == branch_relative_immediate) return 1 | 2;
+			if(op == return_to) return 2;
+			if(op == convert_to_i64 || op == convert_to_i32 || op == convert_to_i16 || op == convert_to_i8 || op == abs_signed) return 1 | 2;
+			if(op == branch_if_equal || op == branch_if_not_equal || op == branch_if_less || op == branch_if_less_signed
+				|| op == branch_if_greater_equal || op == branch_if_greater_equal_signed
+				|| op == branch_if_equal_f32 || op == branch_if_not_equal_f32 || op == branch_if_less_f32 || op == branch_if_greater_equal_f32
+				|| op == branch_if_equal_f64 || op == branch_if_not_equal_f64 || op == branch_if_less_f64 || op == branch_if_greater_equal_f64
+				|| op == loop_subtract_branch
+			) return 2 | 4; // NOTE: out holds the branch offset
+			if(op == loop_decrement_branch) return 2;
+			return 1 | 2 | 4;
+		}
+
+		/**
+		 * Implementation of \p Op which reads and writes its operands wherever they are pinned
+		 * @note Jumps and branches write their return address before reading their target (matching the interpreter when the same register is used for both).
+		 */
+		template<instruction_t Op, pinned_location Out, pinned_location A, pinned_location B>
+		void* pinned_handler(const pinned_opcode* pc, registers_and_stack* env, uint8_t* sp, uint64_t t0, uint64_t a0, uint64_t ra) {
+			uint64_t* registers = env->memory.data();
+			uint64_t zero = 0;
+			auto& out = pinned_register<Out>(registers, pc->out, t0, a0, ra, zero);
+			auto& a = pinned_register<A>(registers, pc->a, t0, a0, ra, zero);
+			auto& b = pinned_register<B>(registers, pc->b, t0, a0, ra, zero);
+			auto immediate = *(uint32_t*)&pc->a;
+			constexpr bool spill = Out == pinned_location::spilled || A == pinned_location::spilled || B == pinned_location::spilled;
+			if constexpr(spill) spill_pinned_registers(registers, t0, a0, ra);
+
+			if constexpr(Op == label) {}
+			else if constexpr(Op == load_relative_address) out = (uint64_t)(pc + *(int32_t*)&pc->a);
+			else if constexpr(Op == halt) {
+				spill_pinned_registers(registers, t0, a0, ra);
+				return nullptr;
+			}
+			else if constexpr(Op == load_immediate) out = immediate;
+			else if constexpr(Op == load_upper_immediate) out = out | (uint64_t(immediate) << 32);
+			else if constexpr(Op == convert_to_u64 || Op == convert_to_i64) out = a;
+			else if constexpr(Op == convert_to_i32) out = int64_t(int32_t(a));
+			else if constexpr(Op == convert_to_i16) out = int64_t(int16_t(a));
+			else if constexpr(Op == convert_to_i8) out = int64_t(int8_t(a));
+			else if constexpr(Op == stack_load_u64 || Op == stack_store_u64) {
+				uint8_t* offset = (uint8_t*)(sp + (Op == stack_load_u64 ? a : b));
+				assert(offset > env->stack_boundary);
+				assert(offset <= env->stack_bottom);
+				if constexpr(Op == stack_load_u64) out = *(uint64_t*)offset;
+				else out = *(uint64_t*)offset = a;
+			} else if constexpr(Op == stack_push_immediate) {
+				sp -= immediate;
+				assert(sp > env->stack_boundary);
+				assert(sp <= env->stack_bottom);
+			} else if constexpr(Op == stack_pop_immediate) {
+				sp += immediate;
+				assert(sp > env->stack_boundary);
+				assert(sp <= env->stack_bottom);
+			} else if constexpr(Op == stack_push_registers || Op == stack_pop_registers || Op == stack_push_register_mask || Op == stack_pop_register_mask) {
+				// NOTE: The saved registers might include pinned ones
+				spill_pinned_registers(registers, t0, a0, ra);
+				if constexpr(Op == stack_push_registers) sp = push_registers(registers, env, sp, pc->a, pc->b);
+				else if constexpr(Op == stack_pop_registers) sp = pop_registers(registers, env, sp, pc->a, pc->b);
+				else if constexpr(Op == stack_push_register_mask) sp = push_register_mask(registers, env, sp, pc->out, immediate);
+				else sp = pop_register_mask(registers, env, sp, pc->out, immediate);
+				t0 = registers[registers::t(0)];
+				a0 = registers[registers::a(0)];
+				ra = registers[registers::ra];
+			}
+			else if constexpr(Op == jump_relative) {
+				auto offset = a;
+				out = (uint64_t)(pc + 1);
+				pc += *(int64_t*)&offset - 1;
+			} else if constexpr(Op == jump_relative_immediate) {
+				out = (uint64_t)(pc + 1);
+				pc += *(int32_t*)&pc->a - 1;
+			} else if constexpr(Op == jump_to) {
+				out = (uint64_t)(pc + 1);
+				pc = (const pinned_opcode*)a - 1;
+			} else if constexpr(Op == call_to) {
+				out = (uint64_t)(pc + 1);
+				detail::shadow_stack_push(env, (const opcode*)(pc + 1));
+				pc = (const pinned_opcode*)a - 1;
+			} else if constexpr(Op == return_to) {
+				pc = (const pinned_opcode*)detail::shadow_stack_pop(env, (const opcode*)a) - 1;
+			} else if constexpr(Op == branch_relative) {
+				out = (uint64_t)(pc + 1);
+				if(a) pc += *(int64_t*)&b - 1;
+			} else if constexpr(Op == branch_relative_immediate) {
+				out = (uint64_t)(pc + 1);
+				if(a) pc += *(int16_t*)&pc->b - 1;
+			} else if constexpr(Op == branch_to) {
+				out = (uint64_t)(pc + 1);
+				if(a) pc = (const pinned_opcode*)b - 1;
+			}
+			else if constexpr(Op == branch_if_equal) { if(a == b) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == branch_if_not_equal) { if(a != b) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == branch_if_less) { if(a < b) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == branch_if_less_signed) { if(int64_t(a) < int64_t(b)) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == branch_if_greater_equal) { if(a >= b) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == branch_if_greater_equal_signed) { if(int64_t(a) >= int64_t(b)) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == branch_if_equal_f32) { if(float_register<std::float32_t>(&a, 0) == float_register<std::float32_t>(&b, 0)) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == branch_if_not_equal_f32) { if(float_register<std::float32_t>(&a, 0) != float_register<std::float32_t>(&b, 0)) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == branch_if_less_f32) { if(float_register<std::float32_t>(&a, 0) < float_register<std::float32_t>(&b, 0)) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == branch_if_greater_equal_f32) { if(float_register<std::float32_t>(&a, 0) >= float_register<std::float32_t>(&b, 0)) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == branch_if_equal_f64) { if(float_register<std::float64_t>(&a, 0) == float_register<std::float64_t>(&b, 0)) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == branch_if_not_equal_f64) { if(float_register<std::float64_t>(&a, 0) != float_register<std::float64_t>(&b, 0)) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == branch_if_less_f64) { if(float_register<std::float64_t>(&a, 0) < float_register<std::float64_t>(&b, 0)) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == branch_if_greater_equal_f64) { if(float_register<std::float64_t>(&a, 0) >= float_register<std::float64_t>(&b, 0)) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == loop_decrement_branch) { if(--a != 0) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == loop_subtract_branch) { if(int64_t(a -= b) > 0) pc += *(int16_t*)&pc->out - 1; }
+			else if constexpr(Op == set_if_equal) out = a == b;
+			else if constexpr(Op == set_if_not_equal) out = a != b;
+			else if constexpr(Op == set_if_less) out = a < b;
+			else if constexpr(Op == set_if_less_signed) out = int64_t(a) < int64_t(b);
+			else if constexpr(Op == set_if_greater_equal) out = a >= b;
+			else if constexpr(Op == set_if_greater_equal_signed) out = int64_t(a) >= int64_t(b);
+			else if constexpr(Op == add) out = a + b;
+			else if constexpr(Op == subtract) out = a - b;
+			else if constexpr(Op == multiply) out = a * b;
+			else if constexpr(Op == divide) out = a / b;
+			else if constexpr(Op == modulus) out = a % b;
+			else if constexpr(Op == divide_signed) out = detail::signed_quotient(a, b);
+			else if constexpr(Op == modulus_signed) out = detail::signed_remainder(a, b);
+			else if constexpr(Op == shift_left) out = a << b;
+			else if constexpr(Op == shift_right_logical) out = a >> b;
+			else if constexpr(Op == shift_right_arithmetic) out = int64_t(a) >> b;
+			else if constexpr(Op == bitwise_xor) out = a ^ b;
+			else if constexpr(Op == bitwise_and) out = a & b;
+			else if constexpr(Op == bitwise_or) out = a | b;
+			else if constexpr(Op == select_if) out = out ? a : b;
+			else if constexpr(Op == min) out = std::min(a, b);
+			else if constexpr(Op == max) out = std::max(a, b);
+			else if constexpr(Op == min_signed) out = std::min(int64_t(a), int64_t(b));
+			else if constexpr(Op == max_signed) out = std::max(int64_t(a), int64_t(b));
+			else if constexpr(Op == abs_signed) out = a >> 63 ? 0 - a : a;
+			else static_assert(!has_pinned_handler(Op), "Missing pinned implementation");
+
+			if constexpr(spill) {
+				registers[0] = 0; // NOTE: Writes to x0 went to memory
+				t0 = registers[registers::t(0)];
+				a0 = registers[registers::a(0)];
+				ra = registers[registers::ra];
+			}
+			MIZU_PINNED_NEXT();
+		}
+
+		/**
+		 * Runs an instruction without a pinned implementation by spilling the pinned registers, running a copy of its opcode, and then reloading them
+		 */
+		inline void* pinned_call_out(const pinned_opcode* pc, registers_and_stack* env, uint8_t* sp, uint64_t t0, uint64_t a0, uint64_t ra) {
+			uint64_t* registers = env->memory.data();
+			spill_pinned_registers(registers, t0, a0, ra);
+			opcode copy[2] = {opcode{pc->original, pc->out, pc->a, pc->b}, opcode{resume_caller}};
+			sp = run_copy(copy, registers, env, sp);
+			t0 = registers[registers::t(0)];
+			a0 = registers[registers::a(0)];
+			ra = registers[registers::ra];
+			MIZU_PINNED_NEXT();
+		}
+
+		/**
+		 * Locations (in order) that one operand of an instruction has pinned implementations specialized for
+		 */
+		struct pinned_specializations {
+			std::array<pinned_location, 5> locations;
+			size_t size;
+
+			/**
+			 * @return size_t the index of \p location, or size if it isn't specialized
+			 */
+			constexpr size_t find(pinned_location location) const {
+				for(size_t i = 0; i < size; ++i)
+					if(locations[i] == location) return i;
+				return size;
+			}
+		};
+
+		/**
+		 * Finds the locations that the operand \p operand (1 = out, 2 = a, 4 = b) of \p op is specialized for
+		 * @note Only the locations translate produces are specialized (inputs are never zero), and since instructions reading two registers would otherwise instantiate every combination of three operands, any of their operands being ra is left to a single implementation which spills the pinned registers
+		 */
+		constexpr pinned_specializations specialized_pinned_locations(instruction_t op, uint8_t operand) {
+			using enum pinned_location;
+			auto used = pinned_register_operands(op);
+			if(!(used & operand)) return {{zero}, 1}; // NOTE: Unused operands are always treated as zero so that they don't instantiate extra specializations
+			bool spill_rare = used & 4;
+			if(operand == 1) return spill_rare ? pinned_specializations{{memory, t0, a0, zero}, 4} : pinned_specializations{{memory, t0, a0, ra, zero}, 5};
+			return spill_rare ? pinned_specializations{{memory, t0, a0}, 3} : pinned_specializations{{memory, t0, a0, ra}, 4};
+		}
+
+		/**
+		 * Finds the pinned implementation of \p Op specialized for where its operands are found
+		 */
+		template<instruction_t Op>
+		pinned_instruction_t find_pinned_handler(pinned_location out, pinned_location a, pinned_location b) {
+			static constexpr auto outs = specialized_pinned_locations(Op, 1), as = specialized_pinned_locations(Op, 2), bs = specialized_pinned_locations(Op, 4);
+			constexpr auto used = pinned_register_operands(Op);
+			size_t o = used & 1 ? outs.find(out) : 0, i = used & 2 ? as.find(a) : 0, j = used & 4 ? bs.find(b) : 0;
+
+			if constexpr(used & 4)
+				if(o == outs.size || i == as.size || j == bs.size)
+					return &pinned_handler<Op,
+						used & 1 ? pinned_location::spilled : pinned_location::zero,
+						used & 2 ? pinned_location::spilled : pinned_location::zero,
+						pinned_location::spilled
+					>;
+
+			constexpr auto table = []<size_t... I>(std::index_sequence<I...>) {
+				return std::array<pinned_instruction_t, sizeof...(I)>{&pinned_handler<Op,
+					outs.locations[I / as.size / bs.size],
+					as.locations[I / bs.size % as.size],
+					bs.locations[I % bs.size]
+				>...};
+			}(std::make_index_sequence<outs.size * as.size * bs.size>{});
+			return table[(o * as.size + i) * bs.size + j];
+		}
+
+		/**
+		 * Finds the pinned implementation of an instruction specialized for where its operands are found
+		 * @return pinned_instruction_t the implementation or nullptr if \p op doesn't have one
+		 */
+		inline pinned_instruction_t find_pinned_handler(instruction_t op, pinned_location out, pinned_location a, pinned_location b) {
+			#define MIZU_PINNED_CASE(name) if(op == name) return find_pinned_handler<name>(out, a, b)
+			MIZU_PINNED_CASE(label); MIZU_PINNED_CASE(load_relative_address); MIZU_PINNED_CASE(halt);
+			MIZU_PINNED_CASE(load_immediate); MIZU_PINNED_CASE(load_upper_immediate); MIZU_PINNED_CASE(convert_to_u64);
+			MIZU_PINNED_CASE(convert_to_i64); MIZU_PINNED_CASE(convert_to_i32); MIZU_PINNED_CASE(convert_to_i16); MIZU_PINNED_CASE(convert_to_i8);
+			MIZU_PINNED_CASE(stack_load_u64); MIZU_PINNED_CASE(stack_store_u64); MIZU_PINNED_CASE(stack_push_immediate); MIZU_PINNED_CASE(stack_pop_immediate);
+			MIZU_PINNED_CASE(stack_push_registers); MIZU_PINNED_CASE(stack_pop_registers); MIZU_PINNED_CASE(stack_push_register_mask); MIZU_PINNED_CASE(stack_pop_register_mask);
+			MIZU_PINNED_CASE(jump_relative); MIZU_PINNED_CASE(jump_relative_immediate); MIZU_PINNED_CASE(jump_to); MIZU_PINNED_CASE(call_to); MIZU_PINNED_CASE(return_to);
+			MIZU_PINNED_CASE(branch_relative); MIZU_PINNED_CASE(branch_relative_immediate); MIZU_PINNED_CASE(branch_to);
+			MIZU_PINNED_CASE(branch_if_equal); MIZU_PINNED_CASE(branch_if_not_equal); MIZU_PINNED_CASE(branch_if_less); MIZU_PINNED_CASE(branch_if_less_signed);
+			MIZU_PINNED_CASE(branch_if_greater_equal); MIZU_PINNED_CASE(branch_if_greater_equal_signed);
+			MIZU_PINNED_CASE(branch_if_equal_f32); MIZU_PINNED_CASE(branch_if_not_equal_f32); MIZU_PINNED_CASE(branch_if_less_f32); MIZU_PINNED_CASE(branch_if_greater_equal_f32);
+			MIZU_PINNED_CASE(branch_if_equal_f64); MIZU_PINNED_CASE(branch_if_not_equal_f64); MIZU_PINNED_CASE(branch_if_less_f64); MIZU_PINNED_CASE(branch_if_greater_equal_f64);
+			MIZU_PINNED_CASE(loop_decrement_branch); MIZU_PINNED_CASE(loop_subtract_branch);
+			MIZU_PINNED_CASE(set_if_equal); MIZU_PINNED_CASE(set_if_not_equal); MIZU_PINNED_CASE(set_if_less); MIZU_PINNED_CASE(set_if_less_signed);
+			MIZU_PINNED_CASE(set_if_greater_equal); MIZU_PINNED_CASE(set_if_greater_equal_signed);
+			MIZU_PINNED_CASE(add); MIZU_PINNED_CASE(subtract); MIZU_PINNED_CASE(multiply); MIZU_PINNED_CASE(divide); MIZU_PINNED_CASE(modulus); MIZU_PINNED_CASE(divide_signed); MIZU_PINNED_CASE(modulus_signed);
+			MIZU_PINNED_CASE(shift_left); MIZU_PINNED_CASE(shift_right_logical); MIZU_PINNED_CASE(shift_right_arithmetic);
+			MIZU_PINNED_CASE(bitwise_xor); MIZU_PINNED_CASE(bitwise_and); MIZU_PINNED_CASE(bitwise_or);
+			MIZU_PINNED_CASE(select_if); MIZU_PINNED_CASE(min); MIZU_PINNED_CASE(max); MIZU_PINNED_CASE(min_signed); MIZU_PINNED_CASE(max_signed); MIZU_PINNED_CASE(abs_signed);
+			#undef MIZU_PINNED_CASE
+			return nullptr;
+		}
+	}
+
+	inline namespace pinned {
+		/**
+		 * A Mizu program translated to keep t0, a0, and ra in host registers
+		 * @note Construct using mizu::pinned::translate
+		 */
+		struct pinned_program {
+			/**
+			 * Translated opcodes (one for each opcode of the source program)
+			 */
+			std::vector<pinned_opcode> program;
+		};
+
+		/**
+		 * Translates a Mizu program so that t0, a0, and ra are carried between instructions in host registers (as extra arguments of every instruction) instead of living in memory
+		 * @note Only the core integer instructions and control flow have pinned implementations, every other instruction spills the pinned registers to memory, runs, and then reloads them.
+		 * @note find_label instructions are resolved during translation (searching the whole program), and fused instructions are unfused.
+		 * @note Addresses stored by jumps and find_label point into the translated program, thus they can't be used by the interpreter (or vice versa).
+		 *
+		 * @param program The program to translate
+		 * @throws std::runtime_error if the program contains an instruction that depends on the program counter and doesn't have a pinned implementation (such as fork_relative), or a relative jump or branch leaving the program
+		 * @return pinned_program the translated program
+		 */
+		inline pinned_program translate(fp::view<const opcode> program) {
+			auto location = [](reg_t r, bool output) {
+				if(r == registers::t(0)) return detail::pinned_location::t0;
+				if(r == registers::a(0)) return detail::pinned_location::a0;
+				if(r == registers::ra) return detail::pinned_location::ra;
+				if(r == 0 && output) return detail::pinned_location::zero;
+				return detail::pinned_location::memory;
+			};
+			auto in_program = [&](size_t i, int64_t offset) { return int64_t(i) + offset >= 0 && int64_t(i) + offset < int64_t(program.size()); };
+
+			pinned_program out;
+			out.program.resize(program.size());
+			for(size_t i = 0; i < program.size(); ++i) {
+				opcode op = program[i];
+				instruction_t instruction = MIZU_INSTRUCTION(&op);
+				for(auto& rule: detail::fusion_rules())
+					if(instruction == rule.fused)
+						instruction = rule.first; // NOTE: The second half of the pair is still in place
+
+				if(instruction == find_label) {
+					auto target = detail::find_label_target(&program[i], program.data(), program.data() + program.size());
+					if(target) {
+						instruction = load_relative_address;
+						op.set_immediate_signed(target - &program[i]);
+					} else {
+						instruction = load_immediate;
+						op.set_immediate(0);
+					}
+				}
+				if((instruction == jump_relative_immediate && !in_program(i, *(int32_t*)&op.a)) || (instruction == branch_relative_immediate && !in_program(i, *(int16_t*)&op.b))
+					|| (detail::is_compare_and_branch(instruction) && !in_program(i, *(int16_t*)&op.out)))
+					MIZU_THROW(std::runtime_error("Opcode " + std::to_string(i) + " jumps outside the program."));
+
+				auto handler = detail::find_pinned_handler(instruction, location(op.out, true), location(op.a, false), location(op.b, false));
+				if(!handler) {
+					if(detail::requires_program_counter(instruction))
+						MIZU_THROW(std::runtime_error("Opcode " + std::to_string(i) + " depends on the program counter and can't be run with pinned registers."));
+					handler = detail::pinned_call_out;
+				}
+				out.program[i] = {handler, op.out, op.a, op.b, instruction};
+			}
+			return out;
+		}
+
+		/**
+		 * Executes a translated program starting at \p pc until it halts
+		 * @note The pinned registers are loaded from memory when execution starts and written back when it halts.
+		 *
+		 * @param pc The first instruction to execute
+		 * @param env The environment to execute in
+		 * @param sp The initial stack pointer
+		 * @return void* the value returned by the halting instruction
+		 */
+		inline void* execute(const pinned_opcode* pc, registers_and_stack* env, uint8_t* sp) {
+			uint64_t* registers = env->memory.data();
+			return pc->op(pc, env, sp, registers[registers::t(0)], registers[registers::a(0)], registers[registers::ra]);
+		}
+
+		/**
+		* Starts executing the provided translated program in the provided environment
+		* @param translated The translated program to execute
+		* @param env The environment to execute \p translated in
+		*/
+		#define MIZU_START_PINNED_FROM_ENVIRONMENT(translated, env) mizu::pinned::execute((translated).program.data(), &env, env.stack_bottom)
+	}
+}
@@ -12,21 +12,22 @@ namespace mizu { inline namespace portable {
 	*
 	* @param program The program to serialize
 	* @param data The data to put at the bottom of the program's stack
+	* @param constants The constants the program loads (see mizu::constant_pool)
 	* @return fp::dynarray<std::byte> a dynamically allocated array of bytes representing the serialized program
 	*/
-	inline fp::dynarray<std::byte> to_portable(fp::view<const opcode> program, fp::view<std::byte> data = {nullptr, 0}) {
+	inline fp::dynarray<std::byte> to_portable(fp::view<const opcode> program, fp::view<std::byte> data = {nullptr, 0}, fp::view<const uint64_t> constants = {nullptr, 0}) {
 		assert(data.size() <= memory_size_bytes);
 
-		auto out = to_binary(program);
+		auto out = to_binary(program, constants);
 		if(data.size() == 0) return out;
 
-		// Make sure there is a null opcode at the end
+		// Make sure there is a null opcode at the end (after the constants if there are any)
 		auto& last = program[program.size() - 1];
-		if(last.op != nullptr || last.out != 0 || last.a != 0 || last.b != 0) {
-			auto marker = opcode{nullptr, 0, 0, 0};
+		if(constants.size() > 0 || last.op != nullptr || last.out != 0 || last.a != 0 || last.b != 0) {
+			auto marker = serialization_opcode{0, 0, 0, 0}; // NOTE: The null instruction's ID is zero
 			auto end = out.size();
-			out.grow(sizeof(opcode));
-			memcpy(out.data() + end, &marker, sizeof(opcode));
+			out.grow(sizeof(serialization_opcode));
+			memcpy(out.data() + end, &marker, sizeof(serialization_opcode));
 		}
 
 		// Paste in the data
@@ -45,7 +46,7 @@ namespace mizu { inline namespace portable {
 	* @return fp::dynarray<std::byte> a dynamically allocated array of bytes representing the serialized program
 	*/
 	inline fp::dynarray<std::byte> to_portable(fp::view<const opcode> program, registers_and_stack& env) {
-		return to_portable(program, {(std::byte*)env.memory.data(), env.memory.size() * sizeof(env.memory[0])});
+		return to_portable(program, {(std::byte*)env.memory.data(), env.memory.size() * sizeof(env.memory[0])}, {env.constants.data(), env.constants.size()});
 	}
 
 	/**
@@ -56,26 +57,39 @@ namespace mizu { inline namespace portable {
 	* @return std::pair<fp::dynarray<opcode>, registers_and_stack> a dynamically allocated Mizu program and its enviornment
 	*/
 	inline std::pair<fp::dynarray<opcode>, registers_and_stack> from_portable(fp::view<const std::byte> binary) {
-		fp::view<opcode> raw_program{(opcode*)binary.data(), 0};
+		// NOTE: The serialized program is made of serialization_opcodes (which are larger than compact opcodes)
+		auto program_start = binary.data();
+		size_t program_size = 0;
 
 		// While there are opcodes left in the data...
-		while(binary.size() > sizeof(opcode)) {
-			// Decode an opcode
-			auto op = (opcode*)binary.data();
+		while(binary.size() >= sizeof(serialization_opcode)) {
+			serialization_opcode op;
+			std::memcpy(&op, binary.data(), sizeof(op));
+			if constexpr (std::endian::native != std::endian::little)
+				op.byteswap();
+
+			// Skip over the constant pool (its values could look like the marker at the end of the program)
+			if(op.op == constant_pool_marker) {
+				auto size = sizeof(serialization_opcode) + (size_t(op.a | (size_t(op.b) << 16)) + 1) / 2 * sizeof(serialization_opcode);
+				program_size += size;
+				binary = binary.subview(size);
+				continue;
+			}
+
 			// Push valid opcodes into the program
-			++raw_program.raw().size;
-			binary = binary.subview(sizeof(opcode));
+			program_size += sizeof(serialization_opcode);
+			binary = binary.subview(sizeof(serialization_opcode));
 
-			// If the opcode marks the end then we are finished
-			if(op->op == nullptr && op->out == 0 && op->a == 0 && op->b == 0)
+			// If the opcode marks the end then we are finished (the null instruction's ID is zero)
+			if(op.op == 0 && op.out == 0 && op.a == 0 && op.b == 0)
 				break;
 		}
 
-		// Deserialize the opcodes
-		auto program = from_binary(raw_program.byte_view());
+		// Deserialize the opcodes (and constants)
+		registers_and_stack env = {};
+		auto program = from_binary({program_start, program_size}, env.constants);
 
 		// Create the enviornment
-		registers_and_stack env = {};
 		if(binary.empty()) return {program, env};
 
 		fill_stack_bottom(env, binary);
@@ -118,8 +132,14 @@ namespace mizu { inline namespace portable {
 		}
 
 		out << "\t}};\n"
-			<< "\tsetup_environment(environment);\n"
-			<< "\n"
+			<< "\tsetup_environment(environment);\n";
+		if(!env.constants.empty()) {
+			out << "\tenvironment.constants = {";
+			for(auto constant: env.constants)
+				out << "0x" << std::format("{:X}", constant) << ", ";
+			out << "};\n";
+		}
+		out << "\n"
 			<< "\tMIZU_START_FROM_ENVIRONMENT(program, environment);\n"
 			<< "}\n";
 			
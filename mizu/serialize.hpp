@@ -3,6 +3,8 @@
 #include "../instructions/lookup.hpp"
 #include <cassert>
 #include <bit>
+#include <limits>
+#include <vector>
 
 namespace mizu { inline namespace serialization {
 	/**
@@ -14,14 +16,22 @@ namespace mizu { inline namespace serialization {
 
 		static serialization_opcode from_opcode(const opcode& code) {
 			serialization_opcode out;
+#ifdef MIZU_COMPACT_OPCODES
+			out.op = code.op.id; // Compact opcodes already store their serialization ID
+#else
 			out.op = (size_t)code.op;
+#endif
 			std::memcpy(&out.out, &code.out, 3 * sizeof(reg_t));
 			return out;
 		}
 
 		opcode to_opcode() {
 			opcode out;
+#ifdef MIZU_COMPACT_OPCODES
+			out.op.id = op;
+#else
 			out.op = (instruction_t)op;
+#endif
 			std::memcpy(&out.out, &this->out, 3 * sizeof(reg_t));
 			return out;
 		}
@@ -34,6 +44,29 @@ namespace mizu { inline namespace serialization {
 		}
 	};
 
+	/**
+	 * Value stored in place of an instruction ID to mark the start of a serialized constant pool
+	 * @note The marker's a and b store the lower and upper 16 bits of the number of constants, which follow it (padded to a whole number of opcodes).
+	 */
+	constexpr static uint64_t constant_pool_marker = std::numeric_limits<uint64_t>::max() - 1;
+
+	/**
+	 * Finds where the constant pool of a serialized program starts
+	 *
+	 * @param binary The serialized program
+	 * @return size_t the offset of the constant pool's marker (or the size of \p binary if there is no pool)
+	 */
+	inline size_t find_constant_pool(fp::view<const std::byte> binary) {
+		for(size_t offset = 0; offset + sizeof(serialization_opcode) <= binary.size(); offset += sizeof(serialization_opcode)) {
+			uint64_t op;
+			std::memcpy(&op, binary.data() + offset, sizeof(op));
+			if constexpr (std::endian::native != std::endian::little)
+				op = std::byteswap(op);
+			if(op == constant_pool_marker) return offset;
+		}
+		return binary.size();
+	}
+
 	/**
 	 * Converts a Mizu \p program into a byte array ready to be written to a file or sent over the network.
 	 * @note This function makes no account of different machine endianness or pointer sizes. 
@@ -58,10 +91,12 @@ namespace mizu { inline namespace serialization {
 		// Replace the op pointers with ids from the lookup
 		auto out = fp::dynarray<std::byte>{}.resize(program.size() * sizeof(serialization_opcode));
 		std::memcpy(out.raw, program.data(), out.size());
+#ifndef MIZU_COMPACT_OPCODES // Compact opcodes already store ids
 		for(size_t i = 0, size = program.size(); i < size; ++i) {
 			auto* op = ((serialization_opcode*)out.data()) + i;
 			op->op = lookup_id((instruction_t)op->op).value_or(-1);
 		}
+#endif
 
 		// Make sure all the integers are stored little endian
 		if constexpr (std::endian::native != std::endian::little)
@@ -72,14 +107,47 @@ namespace mizu { inline namespace serialization {
 		return out;
 	}
 
+	/**
+	 * Converts a Mizu \p program and its \p constants (see mizu::constant_pool) into a byte array ready to be written to a file or sent over the network.
+	 * @note The constants are stored after the program's opcodes.
+	 *
+	 * @param program The program to serialize
+	 * @param constants The constants the program loads
+	 * @return fp::dynarray<std::byte> a dynamically allocated array of bytes representing the serialized program and constants
+	 */
+	inline fp::dynarray<std::byte> to_binary(fp::view<const opcode> program, fp::view<const uint64_t> constants) {
+		auto out = to_binary(program);
+		if(constants.size() == 0) return out;
+		assert(constants.size() <= std::numeric_limits<uint32_t>::max());
+
+		serialization_opcode marker = {constant_pool_marker, 0, reg_t(constants.size()), reg_t(constants.size() >> 16)};
+		if constexpr (std::endian::native != std::endian::little)
+			marker.byteswap();
+
+		auto start = out.size();
+		size_t padded = (constants.size() + 1) / 2 * sizeof(serialization_opcode); // NOTE: Two constants fit in the space of one opcode
+		out.grow(sizeof(serialization_opcode) + padded);
+		std::memset(out.data() + start, 0, sizeof(serialization_opcode) + padded);
+		std::memcpy(out.data() + start, &marker, sizeof(marker));
+		for(size_t i = 0; i < constants.size(); ++i) {
+			uint64_t value = constants[i];
+			if constexpr (std::endian::native != std::endian::little)
+				value = std::byteswap(value);
+			std::memcpy(out.data() + start + sizeof(serialization_opcode) + i * sizeof(uint64_t), &value, sizeof(value));
+		}
+		return out;
+	}
+
 	/**
 	 * Converts a blob of \p binary data into a Mizu program
 	 * @note This function makes no account of different machine endianness or pointer sizes. 
+	 * @note Any constants stored with the program are ignored.
 	 * 
 	 * @param binary The binary blob to deserialize
 	 * @return fp::dynarray<opcode> a dynamically allocated Mizu program
 	 */
 	inline fp::dynarray<opcode> from_binary(fp::view<const std::byte> binary) {
+		binary = {binary.data(), find_constant_pool(binary)};
 		assert(binary.size() % sizeof(serialization_opcode) == 0);
 		auto out = fp::dynarray<serialization_opcode>{}.resize(binary.size() / sizeof(serialization_opcode));
 		std::memcpy(out.raw, binary.data(), binary.size());
@@ -90,8 +158,10 @@ namespace mizu { inline namespace serialization {
 				op.byteswap();
 
 		// Lookup all the pointers
+#ifndef MIZU_COMPACT_OPCODES // Compact opcodes store ids directly
 		for(auto& op: out)
 			op.op = (size_t)lookup_pointer(op.op).value_or(nullptr);
+#endif
 
 		// If opcodes use 64bit pointers then we can just return 
 		if constexpr(sizeof(opcode) == sizeof(serialization_opcode))
@@ -109,4 +179,60 @@ namespace mizu { inline namespace serialization {
 			}
 		}
 	}
+
+	/**
+	 * Converts a blob of \p binary data into a Mizu program and the constants stored with it
+	 * @note This function makes no account of different machine endianness or pointer sizes.
+	 *
+	 * @param binary The binary blob to deserialize
+	 * @param constants Updated to hold the constants stored with the program (emptied if there aren't any)
+	 * @return fp::dynarray<opcode> a dynamically allocated Mizu program
+	 */
+	inline fp::dynarray<opcode> from_binary(fp::view<const std::byte> binary, std::vector<uint64_t>& constants) {
+		constants.clear();
+		auto pool = find_constant_pool(binary);
+		if(pool < binary.size()) {
+			serialization_opcode marker;
+			std::memcpy(&marker, binary.data() + pool, sizeof(marker));
+			if constexpr (std::endian::native != std::endian::little)
+				marker.byteswap();
+
+			constants.resize(marker.a | (size_t(marker.b) << 16));
+			assert(pool + sizeof(serialization_opcode) + constants.size() * sizeof(uint64_t) <= binary.size());
+			std::memcpy(constants.data(), binary.data() + pool + sizeof(serialization_opcode), constants.size() * sizeof(uint64_t));
+			if constexpr (std::endian::native != std::endian::little)
+				for(auto& value: constants)
+					value = std::byteswap(value);
+		}
+		return from_binary(binary);
+	}
+
+#ifdef MIZU_COMPACT_OPCODES
+	/**
+	 * Converts a \p program using full function pointer opcodes into compact opcodes
+	 * @note Every instruction in the program must be registered with the lookup system.
+	 *
+	 * @param program The program to convert
+	 * @return fp::dynarray<opcode> a dynamically allocated compact Mizu program
+	 */
+	inline fp::dynarray<opcode> to_compact(fp::view<const pointer_opcode> program) {
+		auto out = fp::dynarray<opcode>{}.reserve(program.size());
+		for(auto& code: program)
+			out.push_back(opcode{code.op, code.out, code.a, code.b});
+		return out;
+	}
+
+	/**
+	 * Converts a compact \p program into one using full function pointer opcodes
+	 *
+	 * @param program The program to convert
+	 * @return fp::dynarray<pointer_opcode> a dynamically allocated Mizu program
+	 */
+	inline fp::dynarray<pointer_opcode> from_compact(fp::view<const opcode> program) {
+		auto out = fp::dynarray<pointer_opcode>{}.reserve(program.size());
+		for(auto& code: program)
+			out.push_back(pointer_opcode{code.op, code.out, code.a, code.b});
+		return out;
+	}
+#endif
 }}
\ No newline at end of file
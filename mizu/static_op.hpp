@@ -0,0 +1,158 @@
+#pragma once
+
+#include "../instructions/core.hpp"
+
+#include <array>
+#include <bit>
+
+#ifdef MIZU_COMPACT_OPCODES
+	#error "Operand specialized instructions are not supported with compact opcodes (handler table indices can't be created at compile time)"
+#endif
+
+namespace mizu {
+	namespace detail {
+		/**
+		 * Checks if an instruction has an operand specialized implementation
+		 * @note Instructions which depend on the program counter are never specialized (so that single stepping and JIT compilation keep working on static programs),
+		 *	neither are labels (find_label needs to be able to recognize them).
+		 */
+		template<instruction_t Op>
+		consteval bool has_static_handler() {
+			return Op == load_immediate || Op == load_upper_immediate || Op == convert_to_u64
+				|| Op == convert_to_i64 || Op == convert_to_i32 || Op == convert_to_i16 || Op == convert_to_i8
+				|| Op == stack_load_u64 || Op == stack_store_u64 || Op == stack_push_immediate || Op == stack_pop_immediate
+				|| Op == set_if_equal || Op == set_if_not_equal || Op == set_if_less || Op == set_if_less_signed
+				|| Op == set_if_greater_equal || Op == set_if_greater_equal_signed
+				|| Op == add || Op == subtract || Op == multiply || Op == divide || Op == modulus || Op == divide_signed || Op == modulus_signed
+				|| Op == shift_left || Op == shift_right_logical || Op == shift_right_arithmetic
+				|| Op == bitwise_xor || Op == bitwise_and || Op == bitwise_or
+				|| Op == select_if || Op == min || Op == max || Op == min_signed || Op == max_signed || Op == abs_signed;
+		}
+
+		/**
+		 * Implementation of \p Op with its operands baked in as constants
+		 * @note Since the output register is known writes to x0 are dropped at compile time, so x0 never needs to be reset afterwards.
+		 */
+		template<instruction_t Op, reg_t Out, reg_t A, reg_t B>
+		void* static_handler(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) {
+			constexpr uint32_t immediate = std::endian::native == std::endian::little ? A | (uint32_t(B) << 16) : B | (uint32_t(A) << 16);
+			// NOTE: x0 always reads as zero
+			auto read = [registers](reg_t r) -> uint64_t { return r ? registers[r] : 0; };
+			auto write = [registers](uint64_t value) { if constexpr(Out != 0) registers[Out] = value; };
+
+			if constexpr(Op == load_immediate) write(immediate);
+			else if constexpr(Op == load_upper_immediate) write(read(Out) | (uint64_t(immediate) << 32));
+			else if constexpr(Op == convert_to_u64 || Op == convert_to_i64) write(read(A));
+			else if constexpr(Op == convert_to_i32) write(int64_t(int32_t(read(A))));
+			else if constexpr(Op == convert_to_i16) write(int64_t(int16_t(read(A))));
+			else if constexpr(Op == convert_to_i8) write(int64_t(int8_t(read(A))));
+			else if constexpr(Op == stack_load_u64 || Op == stack_store_u64) {
+				uint8_t* offset = (uint8_t*)(sp + read(Op == stack_load_u64 ? A : B));
+				assert(offset > env->stack_boundary);
+				assert(offset <= env->stack_bottom);
+				if constexpr(Op == stack_load_u64) write(*(uint64_t*)offset);
+				else write(*(uint64_t*)offset = read(A));
+			} else if constexpr(Op == stack_push_immediate) {
+				sp -= immediate;
+				assert(sp > env->stack_boundary);
+				assert(sp <= env->stack_bottom);
+			} else if constexpr(Op == stack_pop_immediate) {
+				sp += immediate;
+				assert(sp > env->stack_boundary);
+				assert(sp <= env->stack_bottom);
+			}
+			else if constexpr(Op == set_if_equal) write(read(A) == read(B));
+			else if constexpr(Op == set_if_not_equal) write(read(A) != read(B));
+			else if constexpr(Op == set_if_less) write(read(A) < read(B));
+			else if constexpr(Op == set_if_less_signed) write(int64_t(read(A)) < int64_t(read(B)));
+			else if constexpr(Op == set_if_greater_equal) write(read(A) >= read(B));
+			else if constexpr(Op == set_if_greater_equal_signed) write(int64_t(read(A)) >= int64_t(read(B)));
+			else if constexpr(Op == add) write(read(A) + read(B));
+			else if constexpr(Op == subtract) write(read(A) - read(B));
+			else if constexpr(Op == multiply) write(read(A) * read(B));
+			else if constexpr(Op == divide) write(read(A) / read(B));
+			else if constexpr(Op == modulus) write(read(A) % read(B));
+			else if constexpr(Op == divide_signed) write(detail::signed_quotient(read(A), read(B)));
+			else if constexpr(Op == modulus_signed) write(detail::signed_remainder(read(A), read(B)));
+			else if constexpr(Op == shift_left) write(read(A) << read(B));
+			else if constexpr(Op == shift_right_logical) write(read(A) >> read(B));
+			else if constexpr(Op == shift_right_arithmetic) write(int64_t(read(A)) >> read(B));
+			else if constexpr(Op == bitwise_xor) write(read(A) ^ read(B));
+			else if constexpr(Op == bitwise_and) write(read(A) & read(B));
+			else if constexpr(Op == bitwise_or) write(read(A) | read(B));
+			else if constexpr(Op == select_if) write(read(Out) ? read(A) : read(B));
+			else if constexpr(Op == min) write(std::min(read(A), read(B)));
+			else if constexpr(Op == max) write(std::max(read(A), read(B)));
+			else if constexpr(Op == min_signed) write(std::min(int64_t(read(A)), int64_t(read(B))));
+			else if constexpr(Op == max_signed) write(std::max(int64_t(read(A)), int64_t(read(B))));
+			else if constexpr(Op == abs_signed) write(read(A) >> 63 ? 0 - read(A) : read(A));
+			else static_assert(!has_static_handler<Op>(), "Missing operand specialized implementation");
+			MIZU_NEXT_WITHOUT_ZERO_RESET();
+		}
+
+		/**
+		 * Finds the operand specialized implementation of \p Op (or \p Op itself if it doesn't have one)
+		 */
+		template<instruction_t Op, reg_t Out, reg_t A, reg_t B>
+		consteval instruction_t find_static_handler() {
+			if constexpr(has_static_handler<Op>()) return static_handler<Op, Out, A, B>;
+			else return Op;
+		}
+	}
+
+	/**
+	 * Version of an instruction with its operands baked in at compile time
+	 * @note Instructions which don't have a specialized implementation (including anything which depends on the program counter) are returned unchanged,
+	 *	thus the operands must still be stored in the opcode (mizu::static_opcode takes care of this).
+	 *
+	 * @tparam Op the instruction to specialize
+	 * @tparam Out the output register
+	 * @tparam A the first argument register
+	 * @tparam B the second argument register
+	 */
+	template<instruction_t Op, reg_t Out = 0, reg_t A = 0, reg_t B = 0>
+	constexpr instruction_t static_op = detail::find_static_handler<Op, Out, A, B>();
+
+	/**
+	 * Opcode running the operand specialized version of an instruction
+	 * @note For use with mizu::static_program
+	 */
+	template<instruction_t Op, reg_t Out = 0, reg_t A = 0, reg_t B = 0>
+	struct static_opcode {
+		constexpr static opcode value = {static_op<Op, Out, A, B>, Out, A, B};
+	};
+
+	/**
+	 * Opcode running the operand specialized version of an instruction which takes an immediate
+	 * @note For use with mizu::static_program
+	 */
+	template<instruction_t Op, reg_t Out, uint32_t Immediate>
+	using static_immediate_opcode = std::conditional_t<std::endian::native == std::endian::little,
+		static_opcode<Op, Out, reg_t(Immediate), reg_t(Immediate >> 16)>,
+		static_opcode<Op, Out, reg_t(Immediate >> 16), reg_t(Immediate)>
+	>;
+
+	/**
+	 * Opcode running an instruction which takes a branch immediate
+	 * @note For use with mizu::static_program
+	 */
+	template<instruction_t Op, reg_t Out, reg_t A, int16_t Offset>
+	using static_branch_opcode = static_opcode<Op, Out, A, reg_t(Offset)>;
+
+	/**
+	 * Array of opcodes (built at compile time) where every instruction with known operands has been replaced by its operand specialized version
+	 * @note Static programs can't be serialized (specialized instructions aren't registered with the lookup system).
+	 *
+	 * Example:
+	 * @code
+	 * constexpr static auto program = mizu::static_program<
+	 * 	mizu::static_immediate_opcode<mizu::load_immediate, mizu::registers::t(0), 40>,
+	 * 	mizu::static_opcode<mizu::debug_print, 0, mizu::registers::t(0)>,
+	 * 	mizu::static_opcode<mizu::halt>
+	 * >;
+	 * MIZU_START_FROM_ENVIRONMENT(program.data(), env);
+	 * @endcode
+	 */
+	template<typename... Opcodes>
+	constexpr std::array<opcode, sizeof...(Opcodes)> static_program = {Opcodes::value...};
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "../instructions/core.hpp"
+#include "../instructions/f64.hpp"
+#include "../instructions/parallel.hpp"
+#include "../instructions/fused.hpp"
+
+#include <optional>
+#include <unordered_set>
+
+#ifdef MIZU_COMPACT_OPCODES
+	#error "Single stepping does not support compact opcodes"
+#endif
+#ifdef MIZU_NO_HARDWARE_THREADS
+	#error "Single stepping does not support emulated (coroutine) threads"
+#endif
+
+namespace mizu {
+	namespace detail {
+		/**
+		 * Set of instructions which inspect or modify the program counter (beyond reading their operands) and thus can't be run on a copy of their opcode
+		 * @note Custom instructions which use the program counter should be added to this set before they are stepped or JIT compiled.
+		 */
+		inline std::unordered_set<instruction_t>& program_counter_dependent_instructions() {
+			static std::unordered_set<instruction_t> set = {
+				find_label, load_relative_address, quickening_in_progress, halt,
+				jump_relative, jump_relative_immediate, jump_to, call_to, return_to, call_windowed, return_windowed,
+				branch_relative, branch_relative_immediate, branch_to,
+				branch_if_equal, branch_if_not_equal, branch_if_less, branch_if_less_signed, branch_if_greater_equal, branch_if_greater_equal_signed,
+				branch_if_equal_f32, branch_if_not_equal_f32, branch_if_less_f32, branch_if_greater_equal_f32,
+				branch_if_equal_f64, branch_if_not_equal_f64, branch_if_less_f64, branch_if_greater_equal_f64,
+				loop_decrement_branch, loop_subtract_branch,
+				fork_relative, fork_relative_immediate,
+				// Fused instructions read the opcode after them
+				fused::load_immediate_stack_load_u64, fused::load_immediate_stack_store_u64, fused::load_immediate_add, fused::load_immediate_subtract,
+				fused::set_if_equal_branch_relative_immediate, fused::set_if_not_equal_branch_relative_immediate,
+				fused::set_if_less_branch_relative_immediate, fused::set_if_greater_equal_branch_relative_immediate,
+				fused::set_if_equal_branch_to, fused::set_if_not_equal_branch_to, fused::set_if_less_branch_to, fused::set_if_greater_equal_branch_to,
+			};
+			return set;
+		}
+
+		/**
+		 * Checks if an instruction inspects or modifies the program counter
+		 *
+		 * @param op the instruction to check
+		 * @return true if the instruction can only be run in place
+		 */
+		inline bool requires_program_counter(instruction_t op) {
+			return program_counter_dependent_instructions().contains(op);
+		}
+
+		/**
+		 * Instruction placed after a copied opcode so that running the copy returns to its caller (instead of continuing to interpret)
+		 * @note Returns the stack pointer the copied instruction finished with
+		 */
+		extern "C" inline void* resume_caller(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) {
+			return sp;
+		}
+
+		/**
+		 * Runs a single instruction which doesn't depend on the program counter
+		 *
+		 * @param copy two opcodes, the first a copy of the opcode to run and the second resume_caller
+		 * @return uint8_t* the stack pointer after the instruction has run
+		 */
+		inline uint8_t* run_copy(opcode* copy, uint64_t* registers, registers_and_stack* env, uint8_t* sp) {
+#ifndef MIZU_LOOP_DISPATCH
+			return (uint8_t*)copy->op(copy, registers, env, sp);
+#else
+			copy->op(copy, registers, env, sp);
+			return env->stack_pointer;
+#endif
+		}
+
+		/**
+		 * Performs the same search as find_label
+		 *
+		 * @param pc the find_label opcode
+		 * @param program_start where the search stops when searching above \p pc
+		 * @param program_end where the search stops when searching below \p pc
+		 * @return const opcode* the found label or nullptr if there is no matching label
+		 */
+		inline const opcode* find_label_target(const opcode* pc, const opcode* program_start, const opcode* program_end) {
+			auto needle = *(uint32_t*)&pc->a;
+			for(auto cur = pc; cur != program_end; ++cur)
+				if(cur->op == label && *(uint32_t*)&cur->a == needle)
+					return cur;
+			for(auto cur = pc; cur != program_start; --cur)
+				if(cur->op == label && *(uint32_t*)&cur->a == needle)
+					return cur;
+			return nullptr;
+		}
+	}
+
+	/**
+	 * State after single stepping an instruction
+	 */
+	struct step_result {
+		/**
+		 * The next instruction to execute (nullptr if the program halted)
+		 */
+		opcode* pc;
+		/**
+		 * The stack pointer after the instruction
+		 */
+		uint8_t* sp;
+	};
+
+	/**
+	 * Executes a single instruction
+	 * @note Instructions which don't depend on the program counter are run on a copy of their opcode,
+	 *	the core control flow instructions are emulated.
+	 *
+	 * @param pc The instruction to execute
+	 * @param registers The registers to execute with
+	 * @param env The environment to execute in
+	 * @param sp The current stack pointer
+	 * @return std::optional<step_result> the state after the instruction, or std::nullopt if the instruction can't be run one at a time (mizu::execute should continue from \p pc instead)
+	 */
+	inline std::optional<step_result> step(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) {
+		auto op = pc->op;
+		auto next = pc + 1;
+		if(!detail::requires_program_counter(op)) {
+			opcode copy[2] = {*pc, opcode{detail::resume_caller}};
+			sp = detail::run_copy(copy, registers, env, sp);
+		} else if(op == halt) {
+			halt(pc, registers, env, sp);
+			return step_result{nullptr, sp};
+		} else if(op == find_label) {
+			registers[pc->out] = (size_t)detail::find_label_target(pc, env->calculate_program_start(pc), env->calculate_program_end(pc));
+		} else if(op == load_relative_address) {
+			registers[pc->out] = (size_t)(pc + *(int32_t*)&pc->a);
+		} else if(op == jump_relative) {
+			auto a = registers[pc->a];
+			registers[pc->out] = (size_t)next;
+			next = pc + (int64_t&)a;
+		} else if(op == jump_relative_immediate) {
+			registers[pc->out] = (size_t)next;
+			next = pc + *(int32_t*)&pc->a;
+		} else if(op == jump_to) {
+			registers[pc->out] = (size_t)next;
+			next = (opcode*)registers[pc->a];
+		} else if(op == call_to) {
+			registers[pc->out] = (size_t)next;
+			detail::shadow_stack_push(env, next);
+			next = (opcode*)registers[pc->a];
+		} else if(op == return_to) {
+			next = (opcode*)detail::shadow_stack_pop(env, (const opcode*)registers[pc->a]);
+		} else if(op == branch_relative) {
+			registers[pc->out] = (size_t)next;
+			if(registers[pc->a]) next = pc + (int64_t&)registers[pc->b];
+		} else if(op == branch_relative_immediate) {
+			registers[pc->out] = (size_t)next;
+			if(registers[pc->a]) next = pc + *(int16_t*)&pc->b;
+		} else if(op == branch_to) {
+			registers[pc->out] = (size_t)next;
+			if(registers[pc->a]) next = (opcode*)registers[pc->b];
+		} else if(detail::is_compare_and_branch(op)) {
+			if(detail::compare_and_branch_taken(pc, registers)) next = pc + *(int16_t*)&pc->out;
+		} else return {};
+
+		registers[0] = 0;
+		return step_result{next, sp};
+	}
+}
@@ -0,0 +1,316 @@
+#pragma once
+
+#include "jit.hpp"
+
+#include <memory>
+
+namespace mizu { inline namespace trace_jit {
+
+	/**
+	 * An instruction which was executed while recording a trace
+	 */
+	struct traced_instruction {
+		/**
+		 * The executed opcode
+		 */
+		const opcode* pc;
+		/**
+		 * The opcode which was executed after it
+		 */
+		const opcode* next;
+		/**
+		 * Where a branch_to or branch_relative would have gone if its condition had been true (nullptr for every other instruction)
+		 */
+		const opcode* branch_target = nullptr;
+	};
+
+	/**
+	 * A recorded trace which has been compiled to native code
+	 */
+	struct compiled_trace {
+		/**
+		 * Executable memory holding the compiled trace
+		 */
+		detail::executable_memory code;
+		/**
+		 * Where the native code for the trace's first instruction begins
+		 */
+		const void* body = nullptr;
+		/**
+		 * Copies of the opcodes which are called out to (each followed by a resume_caller opcode)
+		 */
+		std::vector<opcode> call_outs;
+		/**
+		 * Where a side exit leads
+		 * @note Exits jump through destination, which initially leads back to the interpreter but is redirected into the compiled trace starting at target once one exists.
+		 */
+		struct exit_link {
+			const opcode* target;
+			const void* destination;
+		};
+		/**
+		 * The trace's side exits (sized up front so the addresses the compiled code jumps through stay stable)
+		 */
+		std::vector<exit_link> exits;
+
+		/**
+		 * Compiles a recorded trace to native code
+		 * @note Every control flow decision made while recording becomes a guard which exits back to the interpreter if a different path is taken.
+		 * @note If the trace ends where it started the compiled code loops back to its beginning, otherwise it exits to wherever the trace ended.
+		 *
+		 * @param trace The instructions which were recorded
+		 * @param env The environment the trace was recorded in (used to resolve find_label instructions)
+		 */
+		compiled_trace(fp::view<const traced_instruction> trace, registers_and_stack* env) : call_outs(trace.size() * 2), exits(trace.size() + 1) {
+			detail::assembler as;
+			as.entry();
+			size_t exit_offset = as.code.size();
+			as.shared_exit();
+			size_t body_offset = as.code.size();
+
+			size_t exit_count = 0;
+			auto side_exit = [&](const opcode* target) {
+				auto& link = exits[exit_count++];
+				link.target = target;
+				as.exit_through(target, &link.destination);
+			};
+			// Exits at target unless the flags say the condition is zero (or not)
+			auto side_exit_unless = [&](uint8_t short_jump, const opcode* target) {
+				as.bytes({short_jump, as.exit_through_size}); // j(n)e (over the exit)
+				side_exit(target);
+			};
+			// Exits to the interpreter unless rax holds the expected opcode
+			auto guard_rax = [&](const opcode* expected) {
+				as.bytes({0x48, 0xB9}); as.imm64((size_t)expected); // mov rcx, expected
+				as.bytes({0x48, 0x39, 0xC8}); // cmp rax, rcx
+				as.jump_if_not_zero(as.exit_target);
+			};
+
+			for(size_t i = 0; i < trace.size(); ++i) {
+				auto pc = trace[i].pc;
+				auto next = trace[i].next;
+				auto op = pc->op;
+
+				if(op == find_label) {
+					as.move_rax((size_t)detail::find_label_target(pc, env->calculate_program_start(pc), env->calculate_program_end(pc)));
+					as.store_rax(pc->out);
+				} else if(op == load_relative_address) {
+					as.move_rax((size_t)(pc + *(int32_t*)&pc->a));
+					as.store_rax(pc->out);
+				} else if(detail::emit_straight_line(as, pc, &call_outs[i * 2])) {
+					// Stencil emitted
+				} else if(op == jump_relative_immediate) {
+					// Always goes the same place, no guard needed
+					as.move_rax((size_t)(pc + 1));
+					as.store_rax(pc->out);
+				} else if(op == branch_relative_immediate) {
+					as.move_rax((size_t)(pc + 1));
+					as.store_rax(pc->out);
+					// NOTE: If the condition is the return address or x0 the branch always goes the same way
+					if(pc->a != pc->out && pc->a != 0) {
+						as.bytes({0x48, 0x83, 0xBB}); as.displacement(pc->a); as.bytes({0x00}); // cmp qword [rbx + a], 0
+						if(next == pc + 1) side_exit_unless(0x74, pc + *(int16_t*)&pc->b); // je
+						else side_exit_unless(0x75, pc + 1); // jne
+					}
+				} else if(detail::is_compare_and_branch(op)) {
+					detail::emit_compare_and_branch_condition(as, pc);
+					as.bytes({0x48, 0x85, 0xC0}); // test rax, rax
+					if(next == pc + 1) side_exit_unless(0x74, pc + *(int16_t*)&pc->out); // je
+					else side_exit_unless(0x75, pc + 1); // jne
+				} else if(op == jump_relative || op == jump_to) {
+					if(op == jump_relative) {
+						as.load_rcx(pc->a);
+						as.move_rax((size_t)(pc + 1));
+						as.store_rax(pc->out);
+						as.relative_target(pc);
+					} else {
+						as.move_rax((size_t)(pc + 1));
+						as.store_rax(pc->out);
+						as.load_rax(pc->a);
+					}
+					guard_rax(next);
+				} else if(op == call_to || op == return_to) {
+					detail::emit_call_or_return(as, pc);
+					guard_rax(next);
+				} else if(op == branch_relative || op == branch_to) {
+					auto target = [&] {
+						if(op == branch_relative) {
+							as.load_rcx(pc->b);
+							as.relative_target(pc);
+						} else as.load_rax(pc->b);
+					};
+					as.move_rax((size_t)(pc + 1));
+					as.store_rax(pc->out);
+					as.load_rax(pc->a);
+					as.bytes({0x48, 0x85, 0xC0}); // test rax, rax
+					if(next == pc + 1) {
+						// Not taken while recording, leave (to wherever the branch goes) if the condition isn't zero
+						auto skip = as.code.size();
+						as.bytes({0x74, 0}); // je (over the exit)
+						target();
+						guard_rax(trace[i].branch_target);
+						side_exit(trace[i].branch_target);
+						as.code[skip + 1] = as.code.size() - (skip + 2);
+					} else {
+						side_exit_unless(0x75, pc + 1); // jne
+						target();
+						guard_rax(next);
+					}
+				} else assert(false && "Traces can't contain instructions which can't be single stepped");
+			}
+
+			// Loop back to the top or leave (to the next trace)
+			if(trace[trace.size() - 1].next == trace[0].pc) as.jump(0);
+			else side_exit(trace[trace.size() - 1].next);
+
+			as.patch({body_offset}, exit_offset);
+			code = detail::executable_memory(as.code);
+			body = code.code + body_offset;
+			exits.resize(exit_count);
+			for(auto& link: exits)
+				link.destination = code.code + exit_offset;
+		}
+	};
+
+	/**
+	 * Profiles a program while interpreting it, compiling hot loops into native code
+	 * @note Every time a backward jump or branch is taken a counter associated with its target is incremented.
+	 *	Once that counter reaches hot_threshold the next iteration of the loop is recorded and compiled.
+	 *	Side exits from compiled traces are counted the same way, so frequently taken exits get their own (side) traces.
+	 */
+	struct tracer {
+		/**
+		 * Value stored in a counter when its loop has failed to be recorded (and thus shouldn't be tried again)
+		 */
+		constexpr static uint32_t blacklisted = -1;
+
+		/**
+		 * The program being traced
+		 */
+		fp::view<const opcode> program = {nullptr, 0};
+		/**
+		 * How many times a loop must be entered before it is compiled
+		 */
+		uint32_t hot_threshold = 64;
+		/**
+		 * Maximum number of instructions a trace may contain before recording is abandoned
+		 */
+		size_t max_trace_length = 1024;
+		/**
+		 * How many times each opcode has been the target of a backwards jump (or side exit)
+		 */
+		std::vector<uint32_t> counters;
+		/**
+		 * The compiled trace starting at each opcode (if any)
+		 */
+		std::vector<std::unique_ptr<compiled_trace>> traces;
+
+		/**
+		 * Creates a tracer for a program
+		 * @param program The program to trace (which must outlive the tracer)
+		 */
+		tracer(fp::view<const opcode> program) : program(program), counters(program.size(), 0), traces(program.size()) {}
+
+		/**
+		 * Installs a newly compiled trace, linking the side exits of every trace which leads to it (and those of the new trace which lead to existing traces) directly together
+		 *
+		 * @param head The opcode the trace starts at
+		 * @param trace The compiled trace
+		 */
+		void install(const opcode* head, std::unique_ptr<compiled_trace> trace) {
+			for(auto& existing: traces)
+				if(existing) for(auto& link: existing->exits)
+					if(link.target == head) link.destination = trace->body;
+			for(auto& link: trace->exits)
+				if(link.target == head) link.destination = trace->body;
+				else if(contains(link.target) && traces[link.target - program.data()])
+					link.destination = traces[link.target - program.data()]->body;
+			traces[head - program.data()] = std::move(trace);
+		}
+
+		/**
+		 * Checks if an opcode is part of the traced program
+		 */
+		bool contains(const opcode* pc) const { return pc >= program.data() && pc < program.data() + program.size(); }
+	};
+
+	/**
+	 * Executes a program starting at \p pc until it halts, recording and compiling hot loops as they are discovered
+	 * @note Execution continues in the regular interpreter if the program leaves the traced program or runs an instruction which can't be single stepped.
+	 *
+	 * @param tracer The tracer profiling the program
+	 * @param pc The first instruction to execute
+	 * @param registers The registers to execute with
+	 * @param env The environment to execute in
+	 * @param sp The initial stack pointer
+	 * @return void* the value returned by the halting instruction
+	 */
+	inline void* execute(tracer& tracer, opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp) {
+		std::vector<traced_instruction> recording;
+		const opcode* head = nullptr; // Start of the trace being recorded (nullptr when not recording)
+		auto stop_recording = [&]{ head = nullptr; recording.clear(); };
+
+		while(pc) {
+			if(!tracer.contains(pc)) return mizu::execute(pc, registers, env, sp);
+			auto index = pc - tracer.program.data();
+
+			// Run compiled traces
+			if(!head && tracer.traces[index]) {
+				auto& trace = *tracer.traces[index];
+				auto exit = trace.code.enter(registers, env, sp, trace.body);
+				pc = exit.pc;
+				sp = exit.sp;
+
+				// Count side exits
+				if(pc && tracer.contains(pc) && !tracer.traces[pc - tracer.program.data()]) {
+					auto& counter = tracer.counters[pc - tracer.program.data()];
+					if(counter != tracer.blacklisted && ++counter >= tracer.hot_threshold)
+						head = pc;
+				}
+				continue;
+			}
+
+			const opcode* branch_target = nullptr;
+			if(head && (pc->op == branch_to || pc->op == branch_relative)) {
+				// NOTE: The return address is written before the target is read
+				uint64_t b = pc->out == pc->b ? (size_t)(pc + 1) : registers[pc->b];
+				branch_target = pc->op == branch_to ? (opcode*)b : pc + (int64_t&)b;
+			}
+
+			auto result = step(pc, registers, env, sp);
+			if(!result) {
+				if(head) tracer.counters[head - tracer.program.data()] = tracer.blacklisted;
+				return mizu::execute(pc, registers, env, sp);
+			}
+
+			// Record the trace
+			if(head) {
+				recording.push_back({pc, result->pc, branch_target});
+				bool links = result->pc && tracer.contains(result->pc) && tracer.traces[result->pc - tracer.program.data()];
+				if(result->pc == head || links) {
+					tracer.install(head, std::make_unique<compiled_trace>(fp::view<const traced_instruction>{recording.data(), recording.size()}, env));
+					stop_recording();
+				} else if(!result->pc || !tracer.contains(result->pc) || recording.size() >= tracer.max_trace_length) {
+					tracer.counters[head - tracer.program.data()] = tracer.blacklisted;
+					stop_recording();
+				}
+			// Count backwards jumps
+			} else if(result->pc && result->pc <= pc && tracer.contains(result->pc)) {
+				auto& counter = tracer.counters[result->pc - tracer.program.data()];
+				if(counter != tracer.blacklisted && ++counter >= tracer.hot_threshold && !tracer.traces[result->pc - tracer.program.data()])
+					head = result->pc;
+			}
+
+			pc = result->pc;
+			sp = result->sp;
+		}
+		return nullptr;
+	}
+
+	/**
+	* Starts executing the provided program in the provided environment, compiling hot loops as they are discovered
+	* @param tracer The tracer profiling the program
+	* @param env The environment to execute the program in
+	*/
+	#define MIZU_START_TRACING_FROM_ENVIRONMENT(tracer, env) mizu::trace_jit::execute(tracer, const_cast<mizu::opcode*>((tracer).program.data()), env.memory.data(), &env, env.stack_bottom)
+}}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include "../instructions/core.hpp"
+#include "../instructions/f64.hpp"
+#include "../instructions/parallel.hpp"
+#include "../instructions/unchecked.hpp"
+#include "exception.hpp"
+
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mizu {
+	/**
+	 * Checks that a program's control flow and stack immediates are well formed
+	 * @note The following properties are checked:
+	 *	- No opcode is missing its instruction.
+	 *	- Every relative jump, branch, and fork with an immediate offset lands inside the program.
+	 *	- Every find_label has a matching label in the program.
+	 *	- Jumps and branches through registers holding offsets aren't present (their targets can't be known ahead of time).
+	 *	- Stack immediates (pushes, pops, and the offsets of immediate stack loads and stores) are smaller than the stack (the memory after the registers).
+	 *	- Windowed calls and returns slide the window by between 22 and 256 registers.
+	 *	- The last instruction doesn't fall through past the end of the program.
+	 * @note Jumps through registers holding addresses (jump_to, call_to, return_to, call_windowed, return_windowed, branch_to) are assumed to target labels or return addresses (the only code addresses Mizu instructions produce).
+	 *
+	 * @param program The program to verify
+	 * @throws std::runtime_error describing the first problem found
+	 */
+	inline void verify(fp::view<const opcode> program) {
+		auto fail = [](size_t i, const std::string& message) {
+			MIZU_THROW(std::runtime_error("Verification failed at opcode " + std::to_string(i) + ": " + message));
+		};
+		auto in_program = [&](size_t i, int64_t offset) { return int64_t(i) + offset >= 0 && int64_t(i) + offset < int64_t(program.size()); };
+		constexpr int64_t stack_size_bytes = memory_size_bytes - 256 * sizeof(uint64_t); // NOTE: The first 256 slots of memory hold the registers
+		auto is_stack_immediate_access = [](instruction_t op) {
+			return op == stack_load_u64_immediate || op == stack_load_u32_immediate || op == stack_load_u16_immediate || op == stack_load_u8_immediate
+				|| op == stack_load_i32_immediate || op == stack_load_i16_immediate || op == stack_load_i8_immediate
+				|| op == stack_load_f32_immediate || op == stack_load_f64_immediate
+				|| op == stack_store_u64_immediate || op == stack_store_u32_immediate || op == stack_store_u16_immediate || op == stack_store_u8_immediate
+				|| op == stack_store_f32_immediate || op == stack_store_f64_immediate;
+		};
+
+		if(program.size() == 0) MIZU_THROW(std::runtime_error("Verification failed: the program is empty."));
+		for(size_t i = 0; i < program.size(); ++i) {
+			auto& op = program[i];
+			if(op.op == nullptr)
+				fail(i, "missing instruction.");
+			else if((op.op == jump_relative_immediate || op.op == fork_relative_immediate) && !in_program(i, *(int32_t*)&op.a))
+				fail(i, "jump target is outside the program.");
+			else if(op.op == branch_relative_immediate && !in_program(i, *(int16_t*)&op.b))
+				fail(i, "branch target is outside the program.");
+			else if(detail::is_compare_and_branch(op.op) && !in_program(i, *(int16_t*)&op.out))
+				fail(i, "branch target is outside the program.");
+			else if(op.op == jump_relative || op.op == branch_relative || op.op == fork_relative)
+				fail(i, "jumps through offsets stored in registers can't be verified.");
+			else if((op.op == stack_push_immediate || op.op == stack_pop_immediate) && *(uint32_t*)&op.a >= stack_size_bytes)
+				fail(i, "stack immediate is larger than the stack.");
+			else if(is_stack_immediate_access(op.op) && (*(int16_t*)&op.b >= stack_size_bytes || *(int16_t*)&op.b <= -stack_size_bytes))
+				fail(i, "stack offset reaches outside the stack.");
+			else if((op.op == call_windowed || op.op == return_windowed) && (op.b < 22 || op.b > 256))
+				fail(i, "register window must slide by between 22 and 256 registers.");
+			else if(op.op == find_label) {
+				bool found = false;
+				for(auto& other: program)
+					if(other.op == label && *(uint32_t*)&other.a == *(uint32_t*)&op.a)
+						found = true;
+				if(!found) fail(i, "label not found.");
+			}
+		}
+
+		auto last = program[program.size() - 1].op;
+		if(last != halt && last != jump_to && last != return_to && last != return_windowed && last != jump_relative_immediate)
+			fail(program.size() - 1, "execution can fall off the end of the program.");
+	}
+
+	namespace optimize {
+		/**
+		 * Verifies a program and then replaces every instruction whose runtime checks are provably unnecessary with its unchecked version
+		 * @note Arithmetic instructions which don't write to x0 stop resetting it.
+		 * @note Within straight line code, stack loads, stores, and immediate pops stop checking the stack bounds if they only touch memory reserved by a stack_push_immediate earlier in the same block
+		 *	(that push keeps its check, so the memory it reserved is known to be within the stack).
+		 *	The offsets of loads and stores must come from a load_immediate earlier in the same block.
+		 * @see mizu::verify
+		 *
+		 * @param program The program to optimize (modified in place)
+		 * @throws std::runtime_error if the program fails verification
+		 * @return size_t how many instructions were replaced
+		 */
+		inline size_t remove_checks(fp::view<opcode> program) {
+			verify({program.data(), program.size()});
+
+			auto is_control_flow = [](instruction_t op) {
+				return op == jump_relative || op == jump_relative_immediate || op == jump_to || op == call_to || op == return_to || op == call_windowed || op == return_windowed
+					|| op == branch_relative || op == branch_relative_immediate || op == branch_to
+					|| op == fork_relative || op == fork_relative_immediate || op == halt || detail::is_compare_and_branch(op);
+			};
+
+			// Find where straight line blocks begin (anywhere a jump could land)
+			std::vector<bool> block_start(program.size() + 1, false);
+			block_start[0] = true;
+			for(size_t i = 0; i < program.size(); ++i) {
+				auto& op = program[i];
+				if(op.op == label) block_start[i] = true;
+				if(op.op == jump_relative_immediate || op.op == fork_relative_immediate) block_start[i + *(int32_t*)&op.a] = true;
+				if(op.op == branch_relative_immediate) block_start[i + *(int16_t*)&op.b] = true;
+				if(detail::is_compare_and_branch(op.op)) block_start[i + *(int16_t*)&op.out] = true;
+				if(is_control_flow(op.op)) block_start[i + 1] = true; // NOTE: Return addresses point after jumps
+			}
+
+			static const std::unordered_map<instruction_t, instruction_t> without_zero_reset = {
+				{load_immediate, unchecked_load_immediate}, {convert_to_u64, unchecked_convert_to_u64},
+				{add, unchecked_add}, {subtract, unchecked_subtract}, {multiply, unchecked_multiply}, {divide, unchecked_divide}, {modulus, unchecked_modulus},
+				{shift_left, unchecked_shift_left}, {shift_right_logical, unchecked_shift_right_logical}, {shift_right_arithmetic, unchecked_shift_right_arithmetic},
+				{bitwise_xor, unchecked_bitwise_xor}, {bitwise_and, unchecked_bitwise_and}, {bitwise_or, unchecked_bitwise_or},
+				{set_if_equal, unchecked_set_if_equal}, {set_if_not_equal, unchecked_set_if_not_equal},
+				{set_if_less, unchecked_set_if_less}, {set_if_less_signed, unchecked_set_if_less_signed},
+				{set_if_greater_equal, unchecked_set_if_greater_equal}, {set_if_greater_equal_signed, unchecked_set_if_greater_equal_signed},
+			};
+
+			size_t replaced = 0;
+			std::unordered_map<reg_t, uint64_t> constants; // Registers with known values
+			std::optional<uint64_t> reserved; // Bytes above the stack pointer known to be within the stack
+			auto in_reserved = [&](reg_t offset) {
+				return reserved && constants.contains(offset) && constants[offset] > 0 && constants[offset] <= *reserved;
+			};
+
+			for(size_t i = 0; i < program.size(); ++i) {
+				auto& op = program[i];
+				if(block_start[i]) {
+					constants.clear();
+					reserved = {};
+				}
+
+				auto original = op.op;
+				if(op.op == stack_load_u64 && op.out != 0 && in_reserved(op.a))
+					op.op = unchecked_stack_load_u64;
+				else if(op.op == stack_store_u64 && op.out == 0 && in_reserved(op.b))
+					op.op = unchecked_stack_store_u64;
+				else if(op.op == stack_pop_immediate && reserved && *(uint32_t*)&op.a <= *reserved)
+					op.op = unchecked_stack_pop_immediate;
+				else if(without_zero_reset.contains(op.op) && op.out != 0)
+					op.op = without_zero_reset.at(op.op);
+				if(op.op != original) ++replaced;
+
+				// Track what is known about the registers and stack
+				if(original == load_immediate) {
+					if(op.out != 0) constants[op.out] = *(uint32_t*)&op.a;
+				} else if(original == stack_push_immediate) {
+					reserved = reserved.value_or(0) + *(uint32_t*)&op.a;
+				} else if(original == stack_pop_immediate) {
+					if(reserved && *(uint32_t*)&op.a <= *reserved) *reserved -= *(uint32_t*)&op.a;
+					else reserved = {};
+				} else if(without_zero_reset.contains(original) || original == stack_load_u64 || original == stack_store_u64 || original == stack_load_u64_immediate || original == stack_store_u64_immediate || is_control_flow(original)) {
+					constants.erase(op.out);
+				} else if(original != label) {
+					// Unknown instructions might modify any register or the stack pointer
+					constants.clear();
+					reserved = {};
+				}
+			}
+			return replaced;
+		}
+	}
+}
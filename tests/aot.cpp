@@ -0,0 +1,89 @@
+#define MIZU_IMPLEMENTATION
+#include <mizu/aot.hpp> // NOTE: Must come before the instructions so they register themselves with the lookup system
+#include <mizu/instructions.hpp>
+#include "expect.hpp"
+#include "fib.hpp"
+
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Generates ahead of time compiled versions of fib and bubble (which check their own results) into the directory passed as the first argument
+MIZU_MAIN() {
+	using namespace mizu;
+	std::string directory = argc > 1 ? argv[1] : ".";
+	auto extra_includes = fp::string_view::from_cstr("#include \"expect.hpp\"\n");
+
+	{
+		auto base = fib::program();
+		std::vector<opcode> program(base.begin(), base.end());
+		// Check the result before halting (the program halts after printing it)
+		program.insert(program.begin() + 4, {
+			opcode{load_immediate, registers::t(0)}.set_immediate(fib::expected),
+			opcode{expect_equal, 0, registers::a(0), registers::t(0)},
+		});
+
+		auto env = std::make_unique<registers_and_stack>();
+		setup_environment(*env, program.data(), program.data() + program.size());
+		std::ofstream(directory + "/aot_fib.cpp") << generate_aot_source_file({program.data(), program.size()}, *env, extra_includes);
+	}
+
+	{
+		constexpr size_t count = 100, size = count * sizeof(uint64_t);
+		const opcode program[] = {
+			opcode{find_label, 200}.set_immediate(label2immediate("bub")), // while loop
+			opcode{find_label, 201}.set_immediate(label2immediate("inner")), // for loop
+			opcode{find_label, 202}.set_immediate(label2immediate("ctop")), // check loop
+			// The numbers are already at the bottom of the stack (the generated source stores the whole environment)
+			opcode{stack_push_immediate, 0}.set_immediate(size),
+			opcode{load_immediate, registers::a(0)}.set_immediate(size),
+			opcode{load_immediate, registers::t(5)}.set_immediate(sizeof(uint64_t)),
+			// do { a1 (changed) = false
+			opcode{label}.set_immediate(label2immediate("bub")),
+			opcode{load_immediate, registers::a(1)}.set_immediate(0),
+			// for(a2 (offset of i) = 8; a2 < a0; a2 += 8)
+			opcode{load_immediate, registers::a(2)}.set_immediate(sizeof(uint64_t)),
+				opcode{label}.set_immediate(label2immediate("inner")),
+				// t0 = sp[i - 1], t1 = sp[i]
+				opcode{subtract, registers::t(2), registers::a(2), registers::t(5)},
+				opcode{stack_load_u64, registers::t(0), registers::t(2)},
+				opcode{stack_load_u64, registers::t(1), registers::a(2)},
+				// if t0 (sp[i - 1]) > t1 (sp[i]) swap them and set a1 (changed)
+				opcode{set_if_greater_equal, registers::t(4), registers::t(1), registers::t(0)},
+				opcode{branch_relative_immediate, 0, registers::t(4)}.set_branch_immediate(4),
+				opcode{stack_store_u64, 0, registers::t(1), registers::t(2)},
+				opcode{stack_store_u64, 0, registers::t(0), registers::a(2)},
+				opcode{load_immediate, registers::a(1)}.set_immediate(1),
+				opcode{add, registers::a(2), registers::a(2), registers::t(5)},
+				opcode{set_if_less, registers::t(4), registers::a(2), registers::a(0)},
+				opcode{branch_to, 0, registers::t(4), 201}, // 201 -> goto top of for
+			// } while(a1 (changed))
+			opcode{branch_to, 0, registers::a(1), 200}, // 200 -> goto top of while
+
+			// Check every number is at least as large as the one before it
+			opcode{load_immediate, registers::a(2)}.set_immediate(sizeof(uint64_t)),
+			opcode{load_immediate, registers::t(3)}.set_immediate(1),
+			opcode{label}.set_immediate(label2immediate("ctop")),
+				opcode{subtract, registers::t(2), registers::a(2), registers::t(5)},
+				opcode{stack_load_u64, registers::t(0), registers::t(2)},
+				opcode{stack_load_u64, registers::t(1), registers::a(2)},
+				opcode{set_if_greater_equal, registers::t(4), registers::t(1), registers::t(0)},
+				opcode{expect_equal, 0, registers::t(4), registers::t(3)},
+				opcode{add, registers::a(2), registers::a(2), registers::t(5)},
+				opcode{set_if_less, registers::t(4), registers::a(2), registers::a(0)},
+				opcode{branch_to, 0, registers::t(4), 202}, // 202 -> goto top of check
+			opcode{stack_pop_immediate}.set_immediate(size),
+			opcode{halt},
+		};
+		constexpr size_t program_size = sizeof(program) / sizeof(program[0]);
+
+		auto env = std::make_unique<registers_and_stack>();
+		setup_environment(*env, program, program + program_size);
+		for(size_t i = 0; i < count; ++i) // Pseudo random numbers in [0, 2000)
+			env->memory[memory_size - count + i] = (i * 7919 + 104729) % 2000;
+		std::ofstream(directory + "/aot_bubble.cpp") << generate_aot_source_file({program, program_size}, *env, extra_includes);
+	}
+
+	return 0;
+}
@@ -0,0 +1,77 @@
+#define MIZU_IMPLEMENTATION
+#include <mizu/instructions.hpp>
+#include <mizu/batch.hpp>
+
+#include <memory>
+
+MIZU_MAIN() {
+	using namespace mizu;
+
+	// a0 = max(polynomial(a0 / 100 - 1), 0) (every input is scored independently)
+	const static opcode program[] = {
+		opcode{convert_to_f64, registers::a(0), registers::a(0)},
+		opcode{load_immediate, registers::t(1)}.set_lower_immediate_f64(100),
+		opcode{load_upper_immediate, registers::t(1)}.set_upper_immediate_f64(100),
+		opcode{divide_f64, registers::a(0), registers::a(0), registers::t(1)},
+		opcode{load_immediate, registers::t(1)}.set_lower_immediate_f64(1),
+		opcode{load_upper_immediate, registers::t(1)}.set_upper_immediate_f64(1),
+		opcode{subtract_f64, registers::a(0), registers::a(0), registers::t(1)},
+		// Horner's method (t0 = ((3x - 2)x + 0.5)x - 0.25)
+		opcode{load_immediate, registers::t(0)}.set_lower_immediate_f64(3),
+		opcode{load_upper_immediate, registers::t(0)}.set_upper_immediate_f64(3),
+		opcode{multiply_f64, registers::t(0), registers::t(0), registers::a(0)},
+		opcode{load_immediate, registers::t(1)}.set_lower_immediate_f64(-2),
+		opcode{load_upper_immediate, registers::t(1)}.set_upper_immediate_f64(-2),
+		opcode{add_f64, registers::t(0), registers::t(0), registers::t(1)},
+		opcode{multiply_f64, registers::t(0), registers::t(0), registers::a(0)},
+		opcode{load_immediate, registers::t(1)}.set_lower_immediate_f64(0.5),
+		opcode{load_upper_immediate, registers::t(1)}.set_upper_immediate_f64(0.5),
+		opcode{add_f64, registers::t(0), registers::t(0), registers::t(1)},
+		opcode{multiply_f64, registers::t(0), registers::t(0), registers::a(0)},
+		opcode{load_immediate, registers::t(1)}.set_lower_immediate_f64(-0.25),
+		opcode{load_upper_immediate, registers::t(1)}.set_upper_immediate_f64(-0.25),
+		opcode{add_f64, registers::t(0), registers::t(0), registers::t(1)},
+		// if(t0 < 0) t0 = 0 (lanes diverge here)
+		opcode{set_if_less_f64, registers::t(1), registers::t(0), 0},
+		opcode{branch_relative_immediate, 0, registers::t(1)}.set_branch_immediate(3),
+		opcode{add, registers::a(0), registers::t(0), 0},
+		opcode{halt},
+		opcode{add, registers::a(0), 0, 0},
+		opcode{halt},
+	};
+	constexpr size_t program_size = sizeof(program) / sizeof(program[0]);
+
+	// Score every input, 16 at a time
+	constexpr size_t lanes = 16;
+	size_t inputs = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+	auto batch = mizu::batch::translate({program, program_size});
+	auto env = std::make_unique<mizu::batch::environment<lanes>>();
+	double total = 0, checked = 0;
+	for(size_t i = 0; i < inputs; i += lanes) {
+		mizu::batch::setup_environment(*env, batch);
+		for(size_t l = 0; l < lanes; ++l)
+			env->registers[registers::a(0)][l] = (i + l) % 200;
+		mizu::batch::execute(batch, *env);
+		for(size_t l = 0; l < lanes && i + l < inputs; ++l) {
+			auto score = float_register<std::float64_t>((uint64_t*)&env->registers[registers::a(0)], l);
+			total += score;
+			if(i + l < 1000) checked += score;
+		}
+	}
+
+	// Check the first thousand inputs against running them through the interpreter
+	double expected = 0;
+	for(size_t i = 0; i < std::min<size_t>(inputs, 1000); ++i) {
+		registers_and_stack env = {};
+		setup_environment(env, program, program + program_size);
+		env.memory[registers::a(0)] = i % 200;
+		MIZU_START_FROM_ENVIRONMENT(program, env);
+		expected += float_register<std::float64_t>(env.memory.data(), registers::a(0));
+	}
+	if(checked != expected) {
+		printf("Batch result %f does not match interpreter result %f\n", checked, expected);
+		return 1;
+	}
+	printf("total = %f\n", total);
+	return 0;
+}
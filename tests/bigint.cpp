@@ -0,0 +1,97 @@
+// Adds and multiplies 256 bit numbers with the multi-precision instructions
+#define MIZU_IMPLEMENTATION
+#include <mizu/instructions.hpp>
+
+#include <array>
+#include <cstdio>
+
+using limbs = std::array<uint64_t, 4>;
+
+// Adds two 256 bit numbers (dropping the carry out of the top limb)
+limbs add(const limbs& a, const limbs& b) {
+	limbs sum;
+	uint64_t carry = 0;
+	for(size_t i = 0; i < 4; ++i)
+		sum[i] = mizu::detail::add_with_carry(a[i], b[i], carry);
+	return sum;
+}
+
+// Finds the (3 * count + 1)th Fibonacci number modulo 2^256 (the same way as the Mizu program below)
+limbs fibonacci(uint64_t count) {
+	limbs a = {0}, b = {1}, c;
+	for(uint64_t i = 0; i < count; ++i) {
+		c = add(a, b);
+		a = add(b, c);
+		b = add(c, a);
+	}
+	return b;
+}
+
+MIZU_MAIN() {
+	using namespace mizu;
+
+	// Each 256 bit number takes four limbs (and a fifth register for the carry out of the top limb)
+	constexpr auto A = [](size_t i) { return registers::x(30 + i); };
+	constexpr auto B = [](size_t i) { return registers::x(35 + i); };
+	constexpr auto C = [](size_t i) { return registers::x(40 + i); };
+	constexpr auto product = registers::x(50);
+	const static opcode program[] = {
+		// A = 0, B = 1, t0 (i) = count
+		opcode{load_immediate, B(0)}.set_immediate(1),
+		opcode{add, registers::t(0), registers::a(1), 0},
+			// C = A + B
+			opcode{load_immediate, C(0)}.set_immediate(0),
+			opcode{add_carry, C(0), A(0), B(0)}, opcode{add_carry, C(1), A(1), B(1)}, opcode{add_carry, C(2), A(2), B(2)}, opcode{add_carry, C(3), A(3), B(3)},
+			// A = B + C
+			opcode{load_immediate, A(0)}.set_immediate(0),
+			opcode{add_carry, A(0), B(0), C(0)}, opcode{add_carry, A(1), B(1), C(1)}, opcode{add_carry, A(2), B(2), C(2)}, opcode{add_carry, A(3), B(3), C(3)},
+			// B = C + A
+			opcode{load_immediate, B(0)}.set_immediate(0),
+			opcode{add_carry, B(0), C(0), A(0)}, opcode{add_carry, B(1), C(1), A(1)}, opcode{add_carry, B(2), C(2), A(2)}, opcode{add_carry, B(3), C(3), A(3)},
+			// if --t0 (i) != 0 continue
+			opcode{loop_decrement_branch, 0, registers::t(0)}.set_out_branch_immediate(-15),
+		// product = B * B + B (t1 = &B, t2 = &product, t3 = limb count)
+		opcode{unsafe::pointer_to_register, registers::t(1), B(0)},
+		opcode{unsafe::pointer_to_register, registers::t(2), product},
+		opcode{load_immediate, registers::t(3)}.set_immediate(4),
+		opcode{unsafe::bigint_multiply, registers::t(2), registers::t(1), registers::t(1)},
+		opcode{unsafe::bigint_add, registers::t(2), registers::t(2), registers::t(1)},
+		opcode{debug_print, 0, B(0)},
+		opcode{halt},
+	};
+
+	uint64_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+	registers_and_stack env = {};
+	setup_environment(env, program, program + sizeof(program)/sizeof(program[0]));
+	env.memory[registers::a(1)] = count;
+
+	MIZU_START_FROM_ENVIRONMENT(program, env);
+
+	// Check the square (plus the number itself, with the carry out of the bottom half) against a schoolbook multiplication
+	auto expected = fibonacci(count);
+	std::array<uint64_t, 8> square = {};
+	for(size_t i = 0; i < 4; ++i) {
+		uint64_t carry = 0;
+		for(size_t j = 0; j < 4; ++j) {
+			uint64_t high = mizu::detail::upper_product(expected[i], expected[j]), first = 0, second = 0;
+			square[i + j] = mizu::detail::add_with_carry(expected[i] * expected[j], square[i + j], first);
+			square[i + j] = mizu::detail::add_with_carry(square[i + j], carry, second);
+			carry = high + first + second;
+		}
+		square[i + 4] = carry;
+	}
+	uint64_t carry = 0;
+	for(size_t i = 0; i < 4; ++i)
+		square[i] = mizu::detail::add_with_carry(square[i], expected[i], carry);
+
+	bool matches = env.memory[registers::t(3)] == carry;
+	for(size_t i = 0; i < 4; ++i)
+		matches &= env.memory[B(i)] == expected[i];
+	for(size_t i = 0; i < 8; ++i)
+		matches &= env.memory[product + i] == square[i];
+	if(!matches) {
+		std::printf("Expected %llx %llx %llx %llx\n", (unsigned long long)expected[3], (unsigned long long)expected[2], (unsigned long long)expected[1], (unsigned long long)expected[0]);
+		return 1;
+	}
+	return 0;
+}
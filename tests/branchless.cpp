@@ -0,0 +1,107 @@
+// Runs branch swapping with min and max instead of branching
+#define MIZU_IMPLEMENTATION
+#include <mizu/instructions.hpp>
+
+const fp::array<uint64_t, 100> numbers = {
+	179, 1630, 754, 259, 858, 970, 310, 1612, 1269, 1000, 397, 783, 814, 1812, 1778, 641, 1925, 382, 82, 1147,
+	152, 399, 1061, 1364, 1323, 1753, 96, 980, 1849, 1155, 1355, 1558, 168, 982, 1659, 598, 8, 1547, 52, 1164,
+	1555, 445, 1069, 1921, 627, 1337, 845, 193, 1829, 1572, 1681, 1885, 197, 894, 1940, 1081, 1839, 313, 26, 116,
+	692, 1105, 489, 1293, 502, 1019, 567, 496, 787, 1757, 1333, 1863, 1291, 1975, 744, 457, 1113, 1974, 246, 164,
+	1441, 854, 1710, 583, 648, 484, 1279, 1890, 1588, 1073, 1944, 1231, 656, 566, 1676, 301, 1931, 667, 1167, 707
+};
+const fp::array<uint64_t, 100> sorted = {
+	8, 26, 52, 82, 96, 116, 152, 164, 168,179, 193, 197, 246, 259, 301, 310, 313, 382, 397, 399, 445, 457, 484, 489, 
+	496, 502, 566, 567, 583, 598, 627, 641, 648, 656, 667, 692, 707, 744, 754, 783, 787, 814, 845, 854, 858, 894, 970, 
+	980, 982, 1000, 1019, 1061, 1069, 1073, 1081, 1105, 1113, 1147, 1155, 1164, 1167, 1231, 1269, 1279, 1291, 1293, 
+	1323, 1333, 1337, 1355, 1364, 1441, 1547, 1555, 1558, 1572, 1588, 1612, 1630, 1659, 1676, 1681, 1710, 1753, 1757, 
+	1778, 1812, 1829, 1839, 1849, 1863, 1885, 1890, 1921, 1925, 1931, 1940, 1944, 1974, 1975
+};
+
+MIZU_MAIN() {
+	using namespace mizu;
+
+	// Same sort as branch.cpp, but neighbours are swapped with min and max instead of branching around the swap
+	const static opcode bubble_program[] = {
+		opcode{load_immediate, 204}.set_immediate(sizeof(uint64_t)), // type size constant
+		// a0 (size) = 100
+		opcode{load_immediate, registers::a(0)}.set_immediate(100),
+		// sp = numbers
+		opcode{multiply, registers::t(0), 204, registers::a(0)}, // 204 == sizeof(uint64_t)
+		opcode{stack_push, 0, registers::t(0)},
+		opcode{unsafe::pointer_to_stack, registers::t(1)},
+		opcode{load_immediate, registers::t(2)}.set_host_pointer_lower_immediate(numbers.data()),
+		opcode{load_upper_immediate, registers::t(2)}.set_host_pointer_upper_immediate(numbers.data()),
+		opcode{unsafe::copy_memory, registers::t(1), registers::t(2), registers::t(0)},
+		// Bubble Sort
+		// a1 (changed) = true
+		opcode{load_immediate, registers::a(1)}.set_immediate(1),
+			// while loop: if not a1 (changed) goto check
+			opcode{branch_if_equal, 0, registers::a(1), 0}.set_out_branch_immediate(17),
+			// a1 (changed) = false
+			opcode{load_immediate, registers::a(1)}.set_immediate(0),
+			// a2 (i) = 1
+			opcode{load_immediate, registers::a(2)}.set_immediate(1),
+				// Inner loop: if a2 (i) >= a0 (size) goto while loop
+				opcode{branch_if_greater_equal, 0, registers::a(2), registers::a(0)}.set_out_branch_immediate(-3),
+				// t3 = offset of sp[i], t2 = offset of sp[i - 1]
+				opcode{multiply, registers::t(3), registers::a(2), 204}, // 204 == sizeof(uint64_t)
+				opcode{subtract, registers::t(2), registers::t(3), 204},
+				// t0 = sp[i - 1], t1 = sp[i]
+				opcode{stack_load_u64, registers::t(0), registers::t(2)},
+				opcode{stack_load_u64, registers::t(1), registers::t(3)},
+				// a2 (i) += 1
+				opcode{load_immediate, registers::t(4)}.set_immediate(1),
+				opcode{add, registers::a(2), registers::a(2), registers::t(4)},
+				// t4 (swapped) = t1 (sp[i]) < t0 (sp[i - 1])
+				opcode{set_if_less, registers::t(4), registers::t(1), registers::t(0)},
+				// sp[t2] = min(t0, t1), sp[t3] = max(t0, t1)
+				opcode{min, registers::t(5), registers::t(0), registers::t(1)},
+				opcode{max, registers::t(6), registers::t(0), registers::t(1)},
+				opcode{stack_store_u64, 0, registers::t(5), registers::t(2)},
+				opcode{stack_store_u64, 0, registers::t(6), registers::t(3)},
+				// a1 (changed) |= t4 (swapped)
+				opcode{bitwise_or, registers::a(1), registers::a(1), registers::t(4)},
+				// continue
+				opcode{jump_relative_immediate}.set_immediate_signed(-13),
+
+		// Assert all equal
+		// sp = sorted
+		opcode{multiply, registers::t(0), 204, registers::a(0)}, // 204 == sizeof(uint64_t)
+		opcode{stack_push, 0, registers::t(0)},
+		opcode{unsafe::pointer_to_stack, registers::t(1)},
+		opcode{load_immediate, registers::t(2)}.set_host_pointer_lower_immediate(sorted.data()),
+		opcode{load_upper_immediate, registers::t(2)}.set_host_pointer_upper_immediate(sorted.data()),
+		opcode{unsafe::copy_memory, registers::t(1), registers::t(2), registers::t(0)},
+		// a1 (i) = 0
+		opcode{load_immediate, registers::a(1)}.set_immediate(0),
+			// Assert loop: if a1 (i) >= a0 (size) halt
+			opcode{branch_if_greater_equal, 0, registers::a(1), registers::a(0)}.set_out_branch_immediate(11),
+			// t0 = sp[a1], t1 = offset
+			opcode{multiply, registers::t(1), registers::a(1), 204}, // 204 == sizeof(uint64_t)
+			opcode{stack_load_u64, registers::t(0), registers::t(1)},
+			// t1 = (sp + size * sizeof(uint64_t))[a1]
+			opcode{multiply, registers::t(2), registers::a(0), 204}, // 204 == sizeof(uint64_t)
+			opcode{add, registers::t(1), registers::t(1), registers::t(2)},
+			opcode{stack_load_u64, registers::t(1), registers::t(1)},
+			// a1 (i) += 1
+			opcode{load_immediate, registers::t(2)}.set_immediate(1),
+			opcode{add, registers::a(1), registers::a(1), registers::t(2)},
+			// if t0 == t1 continue
+			opcode{branch_if_equal, 0, registers::t(0), registers::t(1)}.set_out_branch_immediate(-8),
+			// assert index (print a1)
+			opcode{subtract, registers::t(0), registers::a(1), registers::t(2)},
+			opcode{debug_print, 0, registers::t(0)},
+		opcode{halt},
+	};
+
+	// The sort can optionally be repeated (for benchmarking purposes)
+	size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1;
+	for(size_t i = 0; i < iterations; ++i) {
+		registers_and_stack env = {};
+		setup_environment(env, bubble_program, bubble_program + sizeof(bubble_program)/sizeof(bubble_program[0]));
+
+		MIZU_START_FROM_ENVIRONMENT(bubble_program, env);
+	}
+
+	return 0;
+}
\ No newline at end of file
@@ -1,4 +1,4 @@
-#define MIZU_NO_HARDWARE_THREADS
+// Bubble sorts 100 numbers on the stack (optionally repeating the sort, given as the first argument)
 #define MIZU_IMPLEMENTATION
 #include <mizu/instructions.hpp>
 
@@ -21,12 +21,12 @@ MIZU_MAIN() {
 	using namespace mizu;
 
 	const static opcode bubble_program[] = {
-		opcode{find_label, 200}.set_immediate(label2int("bub")), // while loop
-		opcode{find_label, 201}.set_immediate(label2int("inner")), // for loop
-		opcode{find_label, 202}.set_immediate(label2int("check")), // loop end
-		opcode{find_label, 203}.set_immediate(label2int("ctop")), // check/assert loop
+		opcode{find_label, 200}.set_immediate(label2immediate("bub")), // while loop
+		opcode{find_label, 201}.set_immediate(label2immediate("inner")), // for loop
+		opcode{find_label, 202}.set_immediate(label2immediate("check")), // loop end
+		opcode{find_label, 203}.set_immediate(label2immediate("ctop")), // check/assert loop
 		opcode{load_immediate, 204}.set_immediate(sizeof(uint64_t)), // type size constant
-		// opcode{find_label, 203}.set_immediate(label2int("end")), // check/assert loop
+		// opcode{find_label, 203}.set_immediate(label2immediate("end")), // check/assert loop
 		// a0 (size) = 100
 		opcode{load_immediate, registers::a(0)}.set_immediate(100),
 		// sp = numbers
@@ -39,7 +39,7 @@ MIZU_MAIN() {
 		// Bubble Sort 
 		// a1 (changed) = true
 		opcode{load_immediate, registers::a(1)}.set_immediate(1),
-		opcode{label}.set_immediate(label2int("bub")),
+		opcode{label}.set_immediate(label2immediate("bub")),
 			// if not a1 (changed) jump out
 			opcode{set_if_equal, registers::t(0), registers::a(1), 0},
 			opcode{branch_to, 0, registers::t(0), 202}, // 202 -> goto check
@@ -48,7 +48,7 @@ MIZU_MAIN() {
 			// a2 (i) = 0
 			opcode{load_immediate, registers::a(2)}.set_immediate(0),
 				// Inner loop
-				opcode{label}.set_immediate(label2int("inner")),
+				opcode{label}.set_immediate(label2immediate("inner")),
 				// if a2 (i) >= a0 (size) jump up
 				opcode{set_if_greater_equal, registers::t(0), registers::a(2), registers::a(0)},
 				opcode{branch_to, 0, registers::t(0), 200}, // 200 -> goto while loop
@@ -77,7 +77,7 @@ MIZU_MAIN() {
 					opcode{jump_to, 0, 201}, // 201 -> goto top of for
 	
 		// Assert all equal
-		opcode{label}.set_immediate(label2int("check")),
+		opcode{label}.set_immediate(label2immediate("check")),
 		// sp = sorted
 		// opcode{load_immediate, registers::t(0)}.set_immediate(sizeof(uint64_t)),
 		opcode{multiply, registers::t(0), 204, registers::a(0)}, // 204 == sizeof(uint64_t)
@@ -89,10 +89,10 @@ MIZU_MAIN() {
 		// a1 (i) = 0
 		opcode{load_immediate, registers::a(1)}.set_immediate(0),
 		// Assert loop
-		opcode{label}.set_immediate(label2int("ctop")),
+		opcode{label}.set_immediate(label2immediate("ctop")),
 			// if a1 (i) >= a0 (size) halt
 			opcode{set_if_less, registers::t(0), registers::a(1), registers::a(0)},
-			opcode{branch_relative_immediate, 0}.set_branch_immediate(2),
+			opcode{branch_relative_immediate, 0, registers::t(0)}.set_branch_immediate(2),
 			opcode{halt},
 			// t0 = sp[a1], t1 = offset
 			// opcode{load_immediate, registers::t(2)}.set_immediate(sizeof(uint64_t)),
@@ -114,11 +114,13 @@ MIZU_MAIN() {
 			opcode{halt},
 	};
 
-	{
+	// The sort can optionally be repeated (for benchmarking purposes)
+	size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1;
+	for(size_t i = 0; i < iterations; ++i) {
 		registers_and_stack env = {};
-		setup_environment(env);
+		setup_environment(env, bubble_program, bubble_program + sizeof(bubble_program)/sizeof(bubble_program[0]));
 
-		MIZU_START_FROM_ENVIRONMENT(program, env);
+		MIZU_START_FROM_ENVIRONMENT(bubble_program, env);
 	}
 
 	return 0;
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <mizu/opcode.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+
+// Custom instruction letting programs which run outside of their test (like ahead of time compiled ones) check their own results
+namespace mizu { inline namespace instructions { extern "C" {
+
+	/**
+	 * Exits the process with a failure if two registers don't store the same value
+	 * @param a register storing the value to check
+	 * @param b register storing the expected value
+	 */
+	void* expect_equal(opcode* pc, uint64_t* registers, registers_and_stack* env, uint8_t* sp)
+#ifdef MIZU_IMPLEMENTATION
+	{
+		if(registers[pc->a] != registers[pc->b]) {
+			std::printf("Expected %llu but found %llu\n", (unsigned long long)registers[pc->b], (unsigned long long)registers[pc->a]);
+			std::exit(1);
+		}
+		MIZU_NEXT();
+	}
+#else
+	;
+#endif
+	MIZU_REGISTER_INSTRUCTION(expect_equal);
+}}}
@@ -0,0 +1,79 @@
+// Runs fib after folding constants into immediate instructions
+#define MIZU_IMPLEMENTATION
+#include <mizu/instructions.hpp>
+#include <mizu/optimize.hpp>
+#include "fib.hpp"
+
+#include <array>
+#include <cstdio>
+
+MIZU_MAIN() {
+	using namespace mizu;
+
+	auto program = fib::program();
+	{
+		registers_and_stack env = {};
+		size_t size = optimize::fold_immediates({program.data(), program.size()});
+		if(size >= program.size()) {
+			printf("No immediates were folded\n");
+			return 1;
+		}
+		setup_environment(env, program.data(), program.data() + size);
+
+		MIZU_START_FROM_ENVIRONMENT(program.data(), env);
+		if(env.memory[registers::a(0)] != fib::expected) {
+			printf("Expected %llu\n", (unsigned long long)fib::expected);
+			return 1;
+		}
+	}
+
+	// Folds pairs around jumps and branches whose offsets must be adjusted as the program shrinks
+	{
+		using namespace registers;
+		auto program = std::array{
+			opcode{load_immediate, a(0)}.set_immediate(5),
+			opcode{load_immediate, a(1)}.set_immediate(0),
+			opcode{load_relative_address, a(3)}.set_immediate_signed(14), // -> halt
+			opcode{jump_relative_immediate}.set_immediate_signed(4), // -> loop (skipping a folded pair)
+			opcode{load_immediate, t(0)}.set_immediate(100), // Removed
+			opcode{add, a(1), a(1), t(0)},
+			opcode{load_immediate, t(0)}.set_immediate(0),
+			// loop: a0 -= 1, a1 += 3
+			opcode{load_immediate, t(0)}.set_immediate(1), // Removed
+			opcode{subtract, a(0), a(0), t(0)},
+			opcode{load_immediate, t(0)}.set_immediate(3), // Removed
+			opcode{add, a(1), a(1), t(0)},
+			opcode{load_immediate, t(0)}.set_immediate(0),
+			opcode{branch_if_not_equal, 0, a(0), t(0)}.set_out_branch_immediate(-5), // -> loop
+			// a2 = a1 + 7 + 7 (t1 is read again so its load can't be folded)
+			opcode{load_immediate, t(1)}.set_immediate(7),
+			opcode{add, a(2), a(1), t(1)},
+			opcode{add, a(2), a(2), t(1)},
+			opcode{halt},
+		};
+
+		size_t size = optimize::fold_immediates({program.data(), program.size()});
+		if(size != program.size() - 3) {
+			printf("Expected 3 opcodes to be removed, %zu were\n", program.size() - size);
+			return 1;
+		}
+		if(*(int32_t*)&program[2].a != 11 || *(int32_t*)&program[3].a != 3 || program[9].op != branch_if_not_equal || *(int16_t*)&program[9].out != -3) {
+			printf("Offsets weren't adjusted to match the folded program\n");
+			return 1;
+		}
+		if(program[10].op != load_immediate || program[11].op != add) {
+			printf("A load whose register is read again was folded\n");
+			return 1;
+		}
+
+		registers_and_stack env = {};
+		setup_environment(env, program.data(), program.data() + size);
+		MIZU_START_FROM_ENVIRONMENT(program.data(), env);
+		if(env.memory[a(1)] != 15 || env.memory[a(2)] != 29 || env.memory[a(3)] != (uint64_t)&program[13] || program[13].op != halt) {
+			printf("The folded program computed the wrong results\n");
+			return 1;
+		}
+	}
+
+	return 0;
+}
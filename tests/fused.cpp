@@ -0,0 +1,60 @@
+// Runs fib after fusing superinstructions
+#define MIZU_IMPLEMENTATION
+#include <mizu/instructions.hpp>
+#include <mizu/optimize.hpp>
+#include "fib.hpp"
+
+#include <array>
+#include <cstdio>
+
+MIZU_MAIN() {
+	using namespace mizu;
+
+	auto program = fib::program();
+	{
+		registers_and_stack env = {};
+		setup_environment(env, program.data(), program.data() + program.size());
+
+		if(optimize::fuse({program.data(), program.size()}) == 0) {
+			printf("Nothing was fused\n");
+			return 1;
+		}
+		MIZU_START_FROM_ENVIRONMENT(program.data(), env);
+		if(env.memory[registers::a(0)] != fib::expected) {
+			printf("Expected %llu\n", (unsigned long long)fib::expected);
+			return 1;
+		}
+	}
+
+	// Jumping to the second opcode of a fused pair only executes that opcode
+	{
+		using namespace registers;
+		auto program = std::array{
+			opcode{load_immediate, a(0)}.set_immediate(10),
+			opcode{load_immediate, t(0)}.set_immediate(1),
+			opcode{load_immediate, a(1)}.set_immediate(1),
+			opcode{jump_relative_immediate}.set_immediate_signed(2), // -> the add (a0 += 1)
+			opcode{load_immediate, t(0)}.set_immediate(100), // Fused with the add
+			opcode{add, a(0), a(0), t(0)},
+			// Run the pair (a0 += 100) the first time through
+			opcode{add, a(2), a(1), 0},
+			opcode{load_immediate, a(1)}.set_immediate(0),
+			opcode{branch_relative_immediate, 0, a(2)}.set_branch_immediate(-4),
+			opcode{halt},
+		};
+		if(optimize::fuse({program.data(), program.size()}) != 1 || program[4].op != fused::load_immediate_add) {
+			printf("Expected only the load_immediate and add to be fused\n");
+			return 1;
+		}
+
+		registers_and_stack env = {};
+		setup_environment(env, program.data(), program.data() + program.size());
+		MIZU_START_FROM_ENVIRONMENT(program.data(), env);
+		if(env.memory[a(0)] != 111) {
+			printf("Expected 111 after jumping into a fused pair, got %llu\n", (unsigned long long)env.memory[a(0)]);
+			return 1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,62 @@
+// Mixes numbers into a hash with the bit manipulation instructions
+#define MIZU_IMPLEMENTATION
+#include <mizu/instructions.hpp>
+#include <mizu/constant_pool.hpp>
+
+#include <cstdio>
+
+// Mixes every number from the count down to one into a hash (the same way as the Mizu program below)
+uint64_t hash(uint64_t count) {
+	uint64_t h = 0x9E3779B97F4A7C15ull;
+	for(uint64_t i = count; i != 0; --i) {
+		h = std::rotl(h ^ i, 29);
+		h = mizu::detail::upper_product(h, 0xD6E8FEB86659FD93ull) ^ (h * 0xD6E8FEB86659FD93ull);
+	}
+	return h ^ std::byteswap(h) ^ std::popcount(h) ^ std::countl_zero(h) ^ std::countr_zero(h);
+}
+
+MIZU_MAIN() {
+	using namespace mizu;
+
+	static constant_pool constants;
+	const static opcode program[] = {
+		// a0 (hash) = seed, t1 = multiplier, t0 (i) = count
+		constants.load(registers::a(0), 0x9E3779B97F4A7C15ull),
+		constants.load(registers::t(1), 0xD6E8FEB86659FD93ull),
+		opcode{add, registers::t(0), registers::a(1), 0},
+			// a0 = rotl(a0 ^ t0, 29)
+			opcode{bitwise_xor, registers::a(0), registers::a(0), registers::t(0)},
+			opcode{rotate_left_immediate, registers::a(0), registers::a(0)}.set_branch_immediate(29),
+			// a0 = mulhi(a0, t1) ^ (a0 * t1)
+			opcode{multiply_high, registers::t(2), registers::a(0), registers::t(1)},
+			opcode{multiply, registers::a(0), registers::a(0), registers::t(1)},
+			opcode{bitwise_xor, registers::a(0), registers::a(0), registers::t(2)},
+			// if --t0 (i) != 0 continue
+			opcode{loop_decrement_branch, 0, registers::t(0)}.set_out_branch_immediate(-5),
+		// a0 ^= bswap(a0) ^ popcount(a0) ^ clz(a0) ^ ctz(a0)
+		opcode{byte_swap, registers::t(2), registers::a(0)},
+		opcode{count_ones, registers::t(3), registers::a(0)},
+		opcode{bitwise_xor, registers::t(2), registers::t(2), registers::t(3)},
+		opcode{count_leading_zeros, registers::t(3), registers::a(0)},
+		opcode{bitwise_xor, registers::t(2), registers::t(2), registers::t(3)},
+		opcode{count_trailing_zeros, registers::t(3), registers::a(0)},
+		opcode{bitwise_xor, registers::t(2), registers::t(2), registers::t(3)},
+		opcode{bitwise_xor, registers::a(0), registers::a(0), registers::t(2)},
+		opcode{debug_print, 0, registers::a(0)},
+		opcode{halt},
+	};
+
+	uint64_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+	registers_and_stack env = {};
+	setup_environment(env, program, program + sizeof(program)/sizeof(program[0]));
+	env.constants = constants.values;
+	env.memory[registers::a(1)] = count;
+
+	MIZU_START_FROM_ENVIRONMENT(program, env);
+
+	if(env.memory[registers::a(0)] != hash(count)) {
+		std::printf("Expected %llu\n", (unsigned long long)hash(count));
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,95 @@
+// Runs bubble sorting the numbers in host memory instead of on the stack
+#define MIZU_IMPLEMENTATION
+#include <mizu/instructions.hpp>
+
+#include <algorithm>
+#include <array>
+
+const fp::array<uint64_t, 100> numbers = {
+	179, 1630, 754, 259, 858, 970, 310, 1612, 1269, 1000, 397, 783, 814, 1812, 1778, 641, 1925, 382, 82, 1147,
+	152, 399, 1061, 1364, 1323, 1753, 96, 980, 1849, 1155, 1355, 1558, 168, 982, 1659, 598, 8, 1547, 52, 1164,
+	1555, 445, 1069, 1921, 627, 1337, 845, 193, 1829, 1572, 1681, 1885, 197, 894, 1940, 1081, 1839, 313, 26, 116,
+	692, 1105, 489, 1293, 502, 1019, 567, 496, 787, 1757, 1333, 1863, 1291, 1975, 744, 457, 1113, 1974, 246, 164,
+	1441, 854, 1710, 583, 648, 484, 1279, 1890, 1588, 1073, 1944, 1231, 656, 566, 1676, 301, 1931, 667, 1167, 707
+};
+const fp::array<uint64_t, 100> sorted = {
+	8, 26, 52, 82, 96, 116, 152, 164, 168,179, 193, 197, 246, 259, 301, 310, 313, 382, 397, 399, 445, 457, 484, 489, 
+	496, 502, 566, 567, 583, 598, 627, 641, 648, 656, 667, 692, 707, 744, 754, 783, 787, 814, 845, 854, 858, 894, 970, 
+	980, 982, 1000, 1019, 1061, 1069, 1073, 1081, 1105, 1113, 1147, 1155, 1164, 1167, 1231, 1269, 1279, 1291, 1293, 
+	1323, 1333, 1337, 1355, 1364, 1441, 1547, 1555, 1558, 1572, 1588, 1612, 1630, 1659, 1676, 1681, 1710, 1753, 1757, 
+	1778, 1812, 1829, 1839, 1849, 1863, 1885, 1890, 1921, 1925, 1931, 1940, 1944, 1974, 1975
+};
+
+MIZU_MAIN() {
+	using namespace mizu;
+
+	// Same sort as bubble.cpp, but the numbers are sorted in place in host memory instead of being copied onto the stack
+	const static opcode bubble_program[] = {
+		// a0 = numbers, a1 = size, t6 = &numbers[size - 1]
+		opcode{subtract_immediate, registers::t(6), registers::a(1)}.set_branch_immediate(1),
+		opcode{shift_left_immediate, registers::t(6), registers::t(6)}.set_branch_immediate(3), // * sizeof(uint64_t)
+		opcode{add, registers::t(6), registers::a(0), registers::t(6)},
+		// Bubble Sort
+		// a2 (changed) = true
+		opcode{load_immediate, registers::a(2)}.set_immediate(1),
+			// while loop: if not a2 (changed) goto check
+			opcode{branch_if_equal, 0, registers::a(2), 0}.set_out_branch_immediate(12),
+			// a2 (changed) = false
+			opcode{load_immediate, registers::a(2)}.set_immediate(0),
+			// t0 (p) = numbers
+			opcode{add, registers::t(0), registers::a(0), 0},
+				// Inner loop: if t0 (p) >= t6 (last) goto while loop
+				opcode{branch_if_greater_equal, 0, registers::t(0), registers::t(6)}.set_out_branch_immediate(-3),
+				// t1 = p[0], t2 = p[1]
+				opcode{unsafe::load_u64, registers::t(1), registers::t(0)}.set_branch_immediate(0),
+				opcode{unsafe::load_u64, registers::t(2), registers::t(0)}.set_branch_immediate(sizeof(uint64_t)),
+					// if t1 (p[0]) <= t2 (p[1]) continue
+					opcode{branch_if_greater_equal, 0, registers::t(2), registers::t(1)}.set_out_branch_immediate(4),
+					// p[0] = t2, p[1] = t1
+					opcode{unsafe::store_u64, registers::t(0), registers::t(2)}.set_branch_immediate(0),
+					opcode{unsafe::store_u64, registers::t(0), registers::t(1)}.set_branch_immediate(sizeof(uint64_t)),
+					// a2 (changed) = true
+					opcode{load_immediate, registers::a(2)}.set_immediate(1),
+				// t0 (p) += 1, continue
+				opcode{add_immediate, registers::t(0), registers::t(0)}.set_branch_immediate(sizeof(uint64_t)),
+				opcode{jump_relative_immediate}.set_immediate_signed(-8),
+
+		// Assert all equal
+		// t0 (p) = numbers, t3 (q) = sorted
+		opcode{add, registers::t(0), registers::a(0), 0},
+		opcode{load_immediate, registers::t(3)}.set_host_pointer_lower_immediate(sorted.data()),
+		opcode{load_upper_immediate, registers::t(3)}.set_host_pointer_upper_immediate(sorted.data()),
+			// Assert loop: if t0 (p) > t6 (last) halt
+			opcode{branch_if_less, 0, registers::t(6), registers::t(0)}.set_out_branch_immediate(8),
+			// t1 = *p, t2 = *q
+			opcode{unsafe::load_u64, registers::t(1), registers::t(0)}.set_branch_immediate(0),
+			opcode{unsafe::load_u64, registers::t(2), registers::t(3)}.set_branch_immediate(0),
+			// p += 1, q += 1
+			opcode{add_immediate, registers::t(0), registers::t(0)}.set_branch_immediate(sizeof(uint64_t)),
+			opcode{add_immediate, registers::t(3), registers::t(3)}.set_branch_immediate(sizeof(uint64_t)),
+			// if t1 == t2 continue
+			opcode{branch_if_equal, 0, registers::t(1), registers::t(2)}.set_out_branch_immediate(-5),
+			// assert value (print t1)
+			opcode{debug_print, 0, registers::t(1)},
+			opcode{halt},
+		opcode{halt},
+	};
+
+	// The sort can optionally be repeated (for benchmarking purposes)
+	size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1;
+	for(size_t i = 0; i < iterations; ++i) {
+		std::array<uint64_t, 100> copy;
+		std::copy_n(numbers.data(), copy.size(), copy.begin());
+		registers_and_stack env = {};
+		setup_environment(env, bubble_program, bubble_program + sizeof(bubble_program)/sizeof(bubble_program[0]));
+		env.memory[registers::a(0)] = (size_t)copy.data();
+		env.memory[registers::a(1)] = copy.size();
+
+		MIZU_START_FROM_ENVIRONMENT(bubble_program, env);
+
+		if(!std::equal(copy.begin(), copy.end(), sorted.data()))
+			return 1;
+	}
+
+	return 0;
+}
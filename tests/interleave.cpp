@@ -0,0 +1,94 @@
+#define MIZU_IMPLEMENTATION
+#include <mizu/instructions.hpp>
+#include <mizu/interleave.hpp>
+
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+MIZU_MAIN() {
+	using namespace mizu;
+
+	// a0 = the node reached after following a1 next pointers from a0
+	const static opcode program[] = {
+		opcode{load_immediate, registers::t(0)}.set_immediate(1),
+		// loop: a0 = *a0 (switching to another environment while the load is fetched)
+		opcode{interleave::yielding_load_u64, registers::a(0), registers::a(0)},
+		// if(--a1) goto loop
+		opcode{subtract, registers::a(1), registers::a(1), registers::t(0)},
+		opcode{branch_relative_immediate, 0, registers::a(1)}.set_branch_immediate(-2),
+		opcode{halt},
+	};
+	constexpr size_t program_size = sizeof(program) / sizeof(program[0]);
+
+	// A single random cycle through a buffer much larger than the cache (one node per cache line)
+	constexpr size_t node_count = 1 << 20, node_stride = 64 / sizeof(uint64_t);
+	size_t steps = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+	std::vector<uint64_t> nodes(node_count * node_stride);
+	std::vector<size_t> order(node_count);
+	for(size_t i = 0; i < node_count; ++i) order[i] = i;
+	std::mt19937_64 random(42);
+	for(size_t i = node_count - 1; i > 0; --i) // Sattolo's algorithm (so every node is part of the same cycle)
+		std::swap(order[i], order[std::uniform_int_distribution<size_t>(0, i - 1)(random)]);
+	for(size_t i = 0; i < node_count; ++i)
+		nodes[order[i] * node_stride] = (uint64_t)&nodes[order[(i + 1) % node_count] * node_stride];
+
+	// Each VM chases its own part of the cycle
+	constexpr size_t vms = 8;
+	auto envs = std::make_unique<registers_and_stack[]>(vms);
+	auto setup = [&] {
+		for(size_t i = 0; i < vms; ++i) {
+			setup_environment(envs[i], program, program + program_size);
+			envs[i].memory[registers::a(0)] = (uint64_t)&nodes[order[i * node_count / vms] * node_stride];
+			envs[i].memory[registers::a(1)] = steps;
+		}
+	};
+
+	// One VM at a time (every miss stalls the thread)
+	setup();
+	auto start = std::chrono::steady_clock::now();
+	for(size_t i = 0; i < vms; ++i)
+		MIZU_START_FROM_ENVIRONMENT(program, envs[i]);
+	std::chrono::duration<double> sequential = std::chrono::steady_clock::now() - start;
+	std::vector<uint64_t> expected(vms);
+	for(size_t i = 0; i < vms; ++i) expected[i] = envs[i].memory[registers::a(0)];
+
+	// One VM per thread (misses overlap across the threads)
+	setup();
+	start = std::chrono::steady_clock::now();
+	{
+		std::vector<std::thread> threads;
+		for(size_t i = 0; i < vms; ++i)
+			threads.emplace_back([&, i] { MIZU_START_FROM_ENVIRONMENT(program, envs[i]); });
+		for(auto& thread: threads) thread.join();
+	}
+	std::chrono::duration<double> threaded = std::chrono::steady_clock::now() - start;
+	for(size_t i = 0; i < vms; ++i)
+		if(envs[i].memory[registers::a(0)] != expected[i]) {
+			printf("VM %zu reached a different node on its own thread than when run on this one\n", i);
+			return 1;
+		}
+
+	// Every VM interleaved on this thread (misses overlap)
+	setup();
+	std::vector<interleave::context> contexts;
+	for(size_t i = 0; i < vms; ++i) contexts.emplace_back(program, envs[i]);
+	start = std::chrono::steady_clock::now();
+	size_t switches = interleave::execute({contexts.data(), contexts.size()});
+	std::chrono::duration<double> interleaved = std::chrono::steady_clock::now() - start;
+
+	for(size_t i = 0; i < vms; ++i)
+		if(envs[i].memory[registers::a(0)] != expected[i]) {
+			printf("Interleaved VM %zu reached a different node than when run on its own\n", i);
+			return 1;
+		}
+	if(switches < vms * steps) {
+		printf("Interleaved VMs only switched %zu times (expected a switch at every load)\n", switches);
+		return 1;
+	}
+	printf("one VM at a time: %.1f ns/load, one VM per thread (%zu threads): %.1f ns/load, %zu VMs interleaved: %.1f ns/load\n",
+		sequential.count() * 1e9 / (vms * steps), vms, threaded.count() * 1e9 / (vms * steps), vms, interleaved.count() * 1e9 / (vms * steps));
+	return 0;
+}
@@ -0,0 +1,38 @@
+// Runs counted loops whose bookkeeping is a single instruction
+#define MIZU_IMPLEMENTATION
+#include <mizu/instructions.hpp>
+
+MIZU_MAIN() {
+	using namespace mizu;
+
+	// Sums every number from the count down to one, each counted loop's bookkeeping is a single instruction
+	const static opcode program[] = {
+		// a0 (sum) = 0, t0 (i) = count
+		opcode{load_immediate, registers::a(0)}.set_immediate(0),
+		opcode{add, registers::t(0), registers::a(1), 0},
+			// a0 (sum) += t0 (i)
+			opcode{add, registers::a(0), registers::a(0), registers::t(0)},
+			// if --t0 (i) != 0 continue
+			opcode{loop_decrement_branch, 0, registers::t(0)}.set_out_branch_immediate(-1),
+		opcode{debug_print, 0, registers::a(0)},
+
+		// Same sum, but only every other number (a2 = sum, t0 = i, t1 = stride)
+		opcode{load_immediate, registers::a(2)}.set_immediate(0),
+		opcode{add, registers::t(0), registers::a(1), 0},
+		opcode{load_immediate, registers::t(1)}.set_immediate(2),
+			// a2 (sum) += t0 (i)
+			opcode{add, registers::a(2), registers::a(2), registers::t(0)},
+			// if (t0 (i) -= t1 (stride)) > 0 continue
+			opcode{loop_subtract_branch, 0, registers::t(0), registers::t(1)}.set_out_branch_immediate(-1),
+		opcode{debug_print, 0, registers::a(2)},
+		opcode{halt},
+	};
+
+	registers_and_stack env = {};
+	setup_environment(env, program, program + sizeof(program)/sizeof(program[0]));
+	env.memory[registers::a(1)] = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000000;
+
+	MIZU_START_FROM_ENVIRONMENT(program, env);
+
+	return 0;
+}
@@ -0,0 +1,25 @@
+#define MIZU_IMPLEMENTATION
+#include <mizu/instructions.hpp>
+#include <mizu/pinned.hpp>
+#include "fib.hpp"
+
+#include <cstdio>
+
+MIZU_MAIN() {
+	using namespace mizu;
+
+	auto program = fib::program();
+	{
+		registers_and_stack env = {};
+		setup_environment(env, program.data(), program.data() + program.size());
+
+		auto pinned = mizu::pinned::translate({program.data(), program.size()});
+		MIZU_START_PINNED_FROM_ENVIRONMENT(pinned, env);
+		if(env.memory[registers::a(0)] != fib::expected) {
+			printf("Expected %llu\n", (unsigned long long)fib::expected);
+			return 1;
+		}
+	}
+
+	return 0;
+}
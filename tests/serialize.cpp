@@ -0,0 +1,82 @@
+#define MIZU_IMPLEMENTATION
+#include <mizu/portable_format.hpp> // NOTE: Must come before the instructions so they register themselves with the lookup system
+#include <mizu/instructions.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+// Checks that programs (and their constants and stack data) survive being serialized and deserialized
+MIZU_MAIN() {
+	using namespace mizu;
+
+	// Includes a constant which looks like the pool's marker, a duplicate, and an odd number of constants (so the pool is padded)
+	const std::vector<uint64_t> constants = {constant_pool_marker, 42, 42, 0x0123456789ABCDEF, 0};
+	const static opcode program[] = {
+		opcode{load_constant, registers::a(0)}.set_immediate(0),
+		opcode{load_constant, registers::a(1)}.set_immediate(1),
+		opcode{load_constant, registers::a(2)}.set_immediate(2),
+		opcode{load_constant, registers::a(3)}.set_immediate(3),
+		opcode{add, registers::a(4), registers::a(1), registers::a(2)},
+		opcode{halt},
+	};
+	constexpr size_t program_size = sizeof(program) / sizeof(program[0]);
+
+	auto same_program = [&](fp::view<const opcode> other) {
+		if(other.size() != program_size) return false;
+		for(size_t i = 0; i < program_size; ++i)
+			if(other[i].op != program[i].op || other[i].out != program[i].out || other[i].a != program[i].a || other[i].b != program[i].b)
+				return false;
+		return true;
+	};
+	auto runs = [&](fp::view<const opcode> other, registers_and_stack& env) {
+		setup_environment(env, other.data(), other.data() + other.size());
+		MIZU_START_FROM_ENVIRONMENT(other.data(), env);
+		return env.memory[registers::a(0)] == constant_pool_marker && env.memory[registers::a(3)] == 0x0123456789ABCDEF && env.memory[registers::a(4)] == 84;
+	};
+
+	// Binary format
+	{
+		auto binary = to_binary({program, program_size}, {constants.data(), constants.size()});
+		std::vector<uint64_t> loaded;
+		auto deserialized = from_binary({binary.data(), binary.size()}, loaded);
+		if(!same_program({deserialized.data(), deserialized.size()}) || loaded != constants) {
+			printf("The binary format didn't round trip\n");
+			return 1;
+		}
+
+		auto env = std::make_unique<registers_and_stack>();
+		env->constants = loaded;
+		if(!runs({deserialized.data(), deserialized.size()}, *env)) {
+			printf("The program loaded from the binary format computed the wrong result\n");
+			return 1;
+		}
+		deserialized.free();
+		binary.free();
+	}
+
+	// Portable format, with and without data at the bottom of the stack
+	const uint64_t data[] = {1, 2, 3, constant_pool_marker};
+	for(bool with_data: {false, true}) {
+		fp::view<std::byte> stack = with_data ? fp::view<std::byte>{(std::byte*)data, sizeof(data)} : fp::view<std::byte>{nullptr, 0};
+		auto portable = to_portable({program, program_size}, stack, {constants.data(), constants.size()});
+		auto [deserialized, env] = from_portable({portable.data(), portable.size()});
+		if(!same_program({deserialized.data(), deserialized.size()}) || env.constants != constants) {
+			printf("The portable format (%s stack data) didn't round trip\n", with_data ? "with" : "without");
+			return 1;
+		}
+		if(with_data && std::memcmp((std::byte*)(env.memory.data() + env.memory.size()) - sizeof(data), data, sizeof(data)) != 0) {
+			printf("The portable format's stack data didn't round trip\n");
+			return 1;
+		}
+		if(!runs({deserialized.data(), deserialized.size()}, env)) {
+			printf("The program loaded from the portable format (%s stack data) computed the wrong result\n", with_data ? "with" : "without");
+			return 1;
+		}
+		deserialized.free();
+		portable.free();
+	}
+
+	return 0;
+}
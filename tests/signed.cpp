@@ -0,0 +1,84 @@
+// Sums the decimal digits of signed numbers with the signed arithmetic instructions
+#define MIZU_IMPLEMENTATION
+#include <mizu/instructions.hpp>
+#include <mizu/constant_pool.hpp>
+
+#include <cstdio>
+#include <limits>
+
+// Sums the (signed) decimal digits of a pseudo random 32 bit number for every number from the count down to one, along with the number's bottom byte and half (the same way as the Mizu program below)
+int64_t digit_sum(uint64_t count) {
+	int64_t sum = 0;
+	for(uint64_t i = count; i != 0; --i) {
+		int64_t x = int32_t(i * 0x9E3779B97F4A7C15ull);
+		do {
+			sum += x % 10;
+			x /= 10;
+		} while(x != 0);
+		sum += int8_t(i) + int16_t(i);
+	}
+	return sum;
+}
+
+MIZU_MAIN() {
+	using namespace mizu;
+
+	static constant_pool constants;
+	const static opcode program[] = {
+		// t1 = multiplier, t4 = base, t0 (i) = count
+		constants.load(registers::t(1), 0x9E3779B97F4A7C15ull),
+		opcode{load_immediate, registers::t(4)}.set_immediate(10),
+		opcode{add, registers::t(0), registers::a(1), 0},
+			// t2 (x) = int32_t(i * multiplier)
+			opcode{multiply, registers::t(2), registers::t(0), registers::t(1)},
+			opcode{convert_to_i32, registers::t(2), registers::t(2)},
+				// a0 (sum) += x % 10; x /= 10
+				opcode{modulus_signed, registers::t(3), registers::t(2), registers::t(4)},
+				opcode{add, registers::a(0), registers::a(0), registers::t(3)},
+				opcode{divide_signed_immediate, registers::t(2), registers::t(2)}.set_branch_immediate(10),
+				// while x != 0
+				opcode{branch_if_not_equal, 0, registers::t(2), 0}.set_out_branch_immediate(-3),
+			// a0 (sum) += int8_t(i) + int16_t(i)
+			opcode{convert_to_i8, registers::t(3), registers::t(0)},
+			opcode{add, registers::a(0), registers::a(0), registers::t(3)},
+			opcode{convert_to_i16, registers::t(3), registers::t(0)},
+			opcode{add, registers::a(0), registers::a(0), registers::t(3)},
+			// if --t0 (i) != 0 continue
+			opcode{loop_decrement_branch, 0, registers::t(0)}.set_out_branch_immediate(-10),
+		opcode{debug_print, 0, registers::a(0)},
+		opcode{halt},
+	};
+
+	// Dividing the smallest signed number by -1 must neither trap nor be left undefined
+	const static opcode overflow[] = {
+		constants.load(registers::t(0), uint64_t(std::numeric_limits<int64_t>::min())),
+		constants.load(registers::t(1), uint64_t(-1)),
+		opcode{divide_signed, registers::a(2), registers::t(0), registers::t(1)},
+		opcode{modulus_signed, registers::a(3), registers::t(0), registers::t(1)},
+		opcode{divide_signed_immediate, registers::a(4), registers::t(0)}.set_branch_immediate(-1),
+		opcode{modulus_signed_immediate, registers::a(5), registers::t(0)}.set_branch_immediate(-1),
+		opcode{halt},
+	};
+
+	uint64_t count = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+	registers_and_stack env = {};
+	setup_environment(env, program, program + sizeof(program)/sizeof(program[0]));
+	env.constants = constants.values;
+	env.memory[registers::a(1)] = count;
+
+	MIZU_START_FROM_ENVIRONMENT(program, env);
+
+	if(int64_t(env.memory[registers::a(0)]) != digit_sum(count)) {
+		std::printf("Expected %lld\n", (long long)digit_sum(count));
+		return 1;
+	}
+
+	setup_environment(env, overflow, overflow + sizeof(overflow)/sizeof(overflow[0]));
+	env.constants = constants.values;
+	MIZU_START_FROM_ENVIRONMENT(overflow, env);
+	for(reg_t quotient : {registers::a(2), registers::a(4)})
+		if(int64_t(env.memory[quotient]) != std::numeric_limits<int64_t>::min()) return 1;
+	for(reg_t remainder : {registers::a(3), registers::a(5)})
+		if(env.memory[remainder] != 0) return 1;
+	return 0;
+}
@@ -0,0 +1,85 @@
+// Runs fib saving and restoring registers with a single instruction each
+#define MIZU_IMPLEMENTATION
+#include <mizu/instructions.hpp>
+
+#include <cstdio>
+
+MIZU_MAIN() {
+	using namespace mizu;
+	// ra, a2, and a3 (relative to ra)
+	constexpr uint32_t saved = 1 | 1 << (registers::a(2) - registers::return_address) | 1 << (registers::a(3) - registers::return_address);
+
+	const static opcode program[] = {
+		opcode{find_label, 200}.set_immediate(label2immediate("fib")),
+		// Mizu call (a0 = fib(40))
+		opcode{load_immediate, registers::a(0)}.set_immediate(40),
+		opcode{jump_to, registers::return_address, 200},
+		opcode{debug_print, 0, registers::a(0)},
+		// Check ra, a2, and a3 survive a save and restore (they are compared after halting)
+		opcode{load_immediate, registers::return_address}.set_immediate(11),
+		opcode{load_immediate, registers::a(2)}.set_immediate(22),
+		opcode{load_immediate, registers::a(3)}.set_immediate(33),
+		opcode{stack_push_register_mask, registers::return_address}.set_immediate(saved),
+		opcode{load_immediate, registers::return_address}.set_immediate(0),
+		opcode{load_immediate, registers::a(2)}.set_immediate(0),
+		opcode{load_immediate, registers::a(3)}.set_immediate(0),
+		opcode{stack_pop_register_mask, registers::return_address}.set_immediate(saved),
+		// a4 = sp (which every save should have given back)
+		opcode{unsafe::pointer_to_stack, registers::a(4)},
+		opcode{halt},
+
+
+		// Recursive Fibonacci
+		opcode{label}.set_immediate(label2immediate("fib")),
+		// if(a0 >= 3) skip return 1
+		opcode{load_immediate, registers::t(0)}.set_immediate(3),
+		opcode{set_if_greater_equal, registers::t(0), registers::a(0), registers::t(0)},
+		opcode{branch_relative_immediate, 0, registers::t(0)}.set_branch_immediate(3),
+		// return 1
+		opcode{load_immediate, registers::a(0)}.set_immediate(1),
+		opcode{jump_to, 0, registers::return_address}, // return
+		// save ra, save a2, save a3
+		opcode{stack_push_register_mask, registers::return_address}.set_immediate(saved),
+		// a2 = a0 - 1
+		opcode{load_immediate, registers::t(0)}.set_immediate(1),
+		opcode{subtract, registers::a(2), registers::a(0), registers::t(0)},
+		// a3 = a0 - 2
+		opcode{load_immediate, registers::t(0)}.set_immediate(2),
+		opcode{subtract, registers::a(3), registers::a(0), registers::t(0)},
+		// a2 = fib(a2)
+		opcode{add, registers::a(0), registers::a(2), 0},
+		opcode{jump_to, registers::return_address, 200}, // 200 == fib
+		opcode{add, registers::a(2), registers::a(0), 0},
+		// a0 = fib(a3)
+		opcode{add, registers::a(0), registers::a(3), 0},
+		opcode{jump_to, registers::return_address, 200}, // 200 == fib
+		// opcode{add, registers::a(3), registers::a(0), 0},
+		// a0 = a2 + a0
+		opcode{add, registers::a(0), registers::a(2), registers::a(0)},
+		// restore ra, a2, a3
+		opcode{stack_pop_register_mask, registers::return_address}.set_immediate(saved),
+		// return
+		opcode{jump_to, 0, registers::return_address}, // return
+	};
+
+	{
+		registers_and_stack env = {};
+		setup_environment(env, program, program + sizeof(program)/sizeof(program[0]));
+
+		MIZU_START_FROM_ENVIRONMENT(program, env);
+		if(env.memory[registers::a(0)] != 102334155) {
+			printf("Expected 102334155\n");
+			return 1;
+		}
+		if(env.memory[registers::return_address] != 11 || env.memory[registers::a(2)] != 22 || env.memory[registers::a(3)] != 33) {
+			printf("Saved registers weren't restored\n");
+			return 1;
+		}
+		if(env.memory[registers::a(4)] != (uint64_t)env.stack_bottom) {
+			printf("The stack pointer didn't return to the bottom of the stack\n");
+			return 1;
+		}
+	}
+
+	return 0;
+}
\ No newline at end of file
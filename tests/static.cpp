@@ -0,0 +1,86 @@
+// Runs fib with operand specialized instructions
+#define MIZU_IMPLEMENTATION
+#include <mizu/instructions.hpp>
+#include <mizu/static_op.hpp>
+#include "fib.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+MIZU_MAIN() {
+	using namespace mizu;
+
+	// Same program as fib.hpp, however the operands of each instruction are known at compile time
+	constexpr static auto program = static_program<
+		static_immediate_opcode<find_label, 200, label2immediate("fib")>,
+		// Mizu call (a0 = fib(40))
+		static_immediate_opcode<load_immediate, registers::a(0), 40>,
+		static_opcode<jump_to, registers::return_address, 200>,
+		static_opcode<debug_print, 0, registers::a(0)>,
+		static_opcode<halt>,
+
+
+		// Recursive Fibonacci
+		static_immediate_opcode<label, 0, label2immediate("fib")>,
+		// if(a0 >= 3) skip return 1
+		static_immediate_opcode<load_immediate, registers::t(0), 3>,
+		static_opcode<set_if_greater_equal, registers::t(0), registers::a(0), registers::t(0)>,
+		static_branch_opcode<branch_relative_immediate, 0, registers::t(0), 3>,
+		// return 1
+		static_immediate_opcode<load_immediate, registers::a(0), 1>,
+		static_opcode<jump_to, 0, registers::return_address>, // return
+		// save ra, save a2, save a3
+		static_immediate_opcode<stack_push_immediate, 0, 24>,
+		static_immediate_opcode<load_immediate, registers::t(0), 24>,
+		static_opcode<stack_store_u64, 0, registers::return_address, registers::t(0)>,
+		static_immediate_opcode<load_immediate, registers::t(0), 16>,
+		static_opcode<stack_store_u64, 0, registers::a(2), registers::t(0)>,
+		static_immediate_opcode<load_immediate, registers::t(0), 8>,
+		static_opcode<stack_store_u64, 0, registers::a(3), registers::t(0)>,
+		// a2 = a0 - 1
+		static_immediate_opcode<load_immediate, registers::t(0), 1>,
+		static_opcode<subtract, registers::a(2), registers::a(0), registers::t(0)>,
+		// a3 = a0 - 2
+		static_immediate_opcode<load_immediate, registers::t(0), 2>,
+		static_opcode<subtract, registers::a(3), registers::a(0), registers::t(0)>,
+		// a2 = fib(a2)
+		static_opcode<add, registers::a(0), registers::a(2), 0>,
+		static_opcode<jump_to, registers::return_address, 200>, // 200 == fib
+		static_opcode<add, registers::a(2), registers::a(0), 0>,
+		// a0 = fib(a3)
+		static_opcode<add, registers::a(0), registers::a(3), 0>,
+		static_opcode<jump_to, registers::return_address, 200>, // 200 == fib
+		// a0 = a2 + a0
+		static_opcode<add, registers::a(0), registers::a(2), registers::a(0)>,
+		// restore ra, a2, a3
+		static_immediate_opcode<load_immediate, registers::t(0), 24>,
+		static_opcode<stack_load_u64, registers::return_address, registers::t(0)>,
+		static_immediate_opcode<load_immediate, registers::t(0), 16>,
+		static_opcode<stack_load_u64, registers::a(2), registers::t(0)>,
+		static_immediate_opcode<load_immediate, registers::t(0), 8>,
+		static_opcode<stack_load_u64, registers::a(3), registers::t(0)>,
+		static_immediate_opcode<stack_pop_immediate, 0, 24>,
+		// return
+		static_opcode<jump_to, 0, registers::return_address> // return
+	>;
+
+	// At least the arithmetic, loads, and stores should have been replaced with operand specialized instructions
+	auto generic = fib::program();
+	if(std::ranges::equal(program, generic, {}, &opcode::op, &opcode::op)) {
+		printf("No instructions were specialized\n");
+		return 1;
+	}
+
+	{
+		registers_and_stack env = {};
+		setup_environment(env, program.data(), program.data() + program.size());
+
+		MIZU_START_FROM_ENVIRONMENT(program.data(), env);
+		if(env.memory[registers::a(0)] != fib::expected) {
+			printf("Expected %llu\n", (unsigned long long)fib::expected);
+			return 1;
+		}
+	}
+
+	return 0;
+}
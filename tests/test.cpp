@@ -1,5 +1,6 @@
 #define MIZU_IMPLEMENTATION
 #include <mizu/instructions.hpp>
+#include <mizu/constant_pool.hpp>
 
 #include <ffi/instructions.hpp>
 
@@ -13,18 +14,16 @@ MIZU_MAIN() {
 #endif
 	auto function = "print";
 	auto hw = "Hello 世界";
+	static constant_pool constants;
 	const static opcode program[] = {
 		opcode{find_label, 200}.set_immediate(label2immediate("thread")),
 		opcode{ffi::push_type_void},
 		opcode{ffi::push_type_pointer},
 		opcode{ffi::create_interface, 201},
 
-		opcode{load_immediate, 202}.set_host_pointer_lower_immediate(path),
-		opcode{load_upper_immediate, 202}.set_host_pointer_upper_immediate(path),
-		opcode{load_immediate, 203}.set_host_pointer_lower_immediate(function),
-		opcode{load_upper_immediate, 203}.set_host_pointer_upper_immediate(function),
-		opcode{load_immediate, 204}.set_host_pointer_lower_immediate(hw),
-		opcode{load_upper_immediate, 204}.set_host_pointer_upper_immediate(hw),
+		constants.load_host_pointer(202, path),
+		constants.load_host_pointer(203, function),
+		constants.load_host_pointer(204, hw),
 
 		opcode{ffi::load_library, 202, 202},
 		opcode{ffi::load_library_function, 203, 202, 203},
@@ -120,6 +119,7 @@ MIZU_MAIN() {
 	{
 		registers_and_stack env = {};
 		setup_environment(env, program, program + sizeof(program)/sizeof(program[0]));
+		env.constants = constants.values;
 
 		MIZU_START_FROM_ENVIRONMENT(program, env);
 	}
@@ -0,0 +1,84 @@
+// Runs fib after removing provably unnecessary checks
+#define MIZU_IMPLEMENTATION
+#include <mizu/instructions.hpp>
+#include <mizu/verify.hpp>
+#include "fib.hpp"
+
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+MIZU_MAIN() {
+	using namespace mizu;
+
+	auto program = fib::program();
+	{
+		registers_and_stack env = {};
+		setup_environment(env, program.data(), program.data() + program.size());
+
+		if(optimize::remove_checks({program.data(), program.size()}) == 0) {
+			printf("No checks were removed\n");
+			return 1;
+		}
+		MIZU_START_FROM_ENVIRONMENT(program.data(), env);
+		if(env.memory[registers::a(0)] != fib::expected) {
+			printf("Expected %llu\n", (unsigned long long)fib::expected);
+			return 1;
+		}
+	}
+
+	// Programs which verification must reject
+	constexpr uint32_t stack_size_bytes = memory_size_bytes - 256 * sizeof(uint64_t);
+	const std::vector<std::vector<opcode>> invalid = {
+		{opcode{jump_relative_immediate}.set_immediate_signed(2), opcode{halt}},
+		{opcode{jump_relative_immediate}.set_immediate_signed(-1), opcode{halt}},
+		{opcode{branch_relative_immediate, 0, registers::t(0)}.set_branch_immediate(5), opcode{halt}},
+		{opcode{branch_if_equal, 0, registers::t(0), registers::t(1)}.set_out_branch_immediate(-3), opcode{halt}},
+		{opcode{find_label, registers::t(0)}.set_immediate(label2immediate("missing")), opcode{label}.set_immediate(label2immediate("present")), opcode{halt}},
+		{opcode{jump_relative, 0, registers::t(0)}, opcode{halt}},
+		{opcode{stack_push_immediate}.set_immediate(stack_size_bytes), opcode{halt}},
+		{opcode{stack_load_u64_immediate, registers::t(0)}.set_branch_immediate(stack_size_bytes), opcode{halt}},
+		{opcode{stack_store_u32_immediate, 0, registers::t(0)}.set_branch_immediate(-int16_t(stack_size_bytes)), opcode{halt}},
+		{opcode{load_immediate, registers::t(0)}.set_immediate(1)}, // Falls off the end
+	};
+	for(size_t i = 0; i < invalid.size(); ++i) {
+		bool rejected = false;
+		try {
+			verify({invalid[i].data(), invalid[i].size()});
+		} catch(std::runtime_error&) {
+			rejected = true;
+		}
+		if(!rejected) {
+			printf("Invalid program %zu passed verification\n", i);
+			return 1;
+		}
+	}
+
+	// Stack loads whose offsets aren't known to be within memory reserved earlier in the same block must keep their checks
+	auto checked_load = [](opcode between) {
+		std::vector<opcode> program = {
+			opcode{stack_push_immediate}.set_immediate(16),
+			opcode{load_immediate, registers::t(1)}.set_immediate(8),
+			between,
+			opcode{stack_load_u64, registers::a(0), registers::t(1)},
+			opcode{stack_pop_immediate}.set_immediate(16),
+			opcode{halt},
+		};
+		optimize::remove_checks({program.data(), program.size()});
+		return program[3].op == stack_load_u64;
+	};
+	if(checked_load(opcode{add, registers::t(2), registers::t(3), registers::t(3)})) { // Nothing stands in the way of removing this check
+		printf("The check of a load from reserved memory wasn't removed\n");
+		return 1;
+	}
+	if(!checked_load(opcode{add, registers::t(1), registers::t(2), registers::t(3)})) { // The offset is no longer known
+		printf("The check of a load with an unknown offset was removed\n");
+		return 1;
+	}
+	if(!checked_load(opcode{max, registers::t(2), registers::t(2), registers::t(2)})) { // Unknown instructions might move the stack pointer
+		printf("The check of a load after an unknown instruction was removed\n");
+		return 1;
+	}
+
+	return 0;
+}
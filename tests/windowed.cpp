@@ -0,0 +1,54 @@
+// Runs fib giving each call a fresh register window
+#define MIZU_IMPLEMENTATION
+#include <mizu/instructions.hpp>
+
+MIZU_MAIN() {
+	using namespace mizu;
+	// Each call slides the registers up by 24, so the callee's a0 is the caller's a24 while the caller's ra, a0, and a1 are left alone
+	constexpr reg_t window = 24;
+
+	const static opcode program[] = {
+		opcode{find_label, 200}.set_immediate(label2immediate("fib")),
+		opcode{add, registers::x(200 + window), 200, 0}, // The callee's x200 is our x224
+		// Mizu call (a24 = fib(40))
+		opcode{load_immediate, registers::a(window)}.set_immediate(40),
+		opcode{call_windowed, registers::return_address, 200, window},
+		opcode{debug_print, 0, registers::a(window)},
+		opcode{halt},
+
+
+		// Recursive Fibonacci
+		opcode{label}.set_immediate(label2immediate("fib")),
+		// if(a0 >= 3) skip return 1
+		opcode{load_immediate, registers::t(0)}.set_immediate(3),
+		opcode{set_if_greater_equal, registers::t(0), registers::a(0), registers::t(0)},
+		opcode{branch_relative_immediate, 0, registers::t(0)}.set_branch_immediate(3),
+		// return 1
+		opcode{load_immediate, registers::a(0)}.set_immediate(1),
+		opcode{return_windowed, 0, registers::return_address, window}, // return
+		// pass the address of fib along to the callee
+		opcode{add, registers::x(200 + window), 200, 0},
+		// a1 = fib(a0 - 1)
+		opcode{load_immediate, registers::t(0)}.set_immediate(1),
+		opcode{subtract, registers::a(window), registers::a(0), registers::t(0)},
+		opcode{call_windowed, registers::return_address, 200, window}, // 200 == fib
+		opcode{add, registers::a(1), registers::a(window), 0},
+		// a0 = a1 + fib(a0 - 2)
+		opcode{load_immediate, registers::t(0)}.set_immediate(2),
+		opcode{subtract, registers::a(window), registers::a(0), registers::t(0)},
+		opcode{call_windowed, registers::return_address, 200, window}, // 200 == fib
+		opcode{add, registers::a(0), registers::a(1), registers::a(window)},
+		// return
+		opcode{return_windowed, 0, registers::return_address, window}, // return
+	};
+
+	{
+		registers_and_stack env = {};
+		setup_environment(env, program, program + sizeof(program)/sizeof(program[0]));
+
+		MIZU_START_FROM_ENVIRONMENT(program, env);
+		if(env.memory[registers::a(window)] != 102334155) return 1;
+	}
+
+	return 0;
+}